@@ -1,35 +1,37 @@
 ####################################################################################################
-# This function converts any file into C/C++ source code.
+# This function converts a SPIR-V file into C++ source code.
 # Example:
-# - input file: data.dat
-# - output file: data.h
-# - variable name declared in output file: DATA
-# - data length: sizeof(DATA)
-# embed_resource("data.dat" "data.h" "DATA")
+# - input file: test.vert.spv
+# - output file: test_vert.h
+# - variable name declared in output file: TEST_VERT
+# - word count: std::size(TEST_VERT)
+# embed_resource("test.vert.spv" "test_vert.h" "TEST_VERT")
 ####################################################################################################
 
 function(embed_resource resource_file_name source_file_name variable_name)
 
-    if(EXISTS "${source_file_name}")
-        if("${source_file_name}" IS_NEWER_THAN "${resource_file_name}")
-            return()
-        endif()
-    endif()
-
     if(EXISTS "${resource_file_name}")
         file(READ "${resource_file_name}" hex_content HEX)
 
-        string(REPEAT "[0-9a-f]" 32 pattern)
+        string(LENGTH "${hex_content}" hex_length)
+        math(EXPR hex_remainder "${hex_length} % 8")
+        if(NOT hex_remainder EQUAL 0)
+            message("ERROR: ${resource_file_name} is not a whole number of SPIR-V words")
+            return()
+        endif()
+
+        string(REPEAT "[0-9a-f]" 64 pattern)
         string(REGEX REPLACE "(${pattern})" "\\1\n" content "${hex_content}")
 
-        string(REGEX REPLACE "([0-9a-f][0-9a-f])" "0x\\1, " content "${content}")
+        # SPIR-V is little endian, swap each group of four bytes into one uint32_t literal
+        string(REGEX REPLACE "([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])([0-9a-f][0-9a-f])" "0x\\4\\3\\2\\1, " content "${content}")
 
         string(REGEX REPLACE ", $" "" content "${content}")
 
-        set(array_definition "static const std::vector<unsigned char> ${variable_name} =\n{\n${content}\n};")
-        
+        set(array_definition "alignas(4) inline constexpr uint32_t ${variable_name}[] =\n{\n${content}\n};")
+
         get_filename_component(file_name ${source_file_name} NAME)
-        set(source "/**\n * @file ${file_name}\n * @brief Auto generated file.\n */\n#include <vector>\n${array_definition}\n")
+        set(source "/**\n * @file ${file_name}\n * @brief Auto generated file.\n */\n#pragma once\n\n#include <cstdint>\n\n${array_definition}\n")
 
         file(WRITE "${source_file_name}" "${source}")
     else()
@@ -4,6 +4,8 @@ function(compile_shader SHADERS TARGET_NAME SHADER_INCLUDE_FOLDER GENERATED_DIR
 
     set(ALL_GENERATED_SPV_FILES "")
     set(ALL_GENERATED_CPP_FILES "")
+    set(REGISTRY_INCLUDES "")
+    set(REGISTRY_ENTRIES "")
 
     if(UNIX)
         execute_process(COMMAND chmod a+x ${GLSLANG_BIN})
@@ -30,14 +32,149 @@ function(compile_shader SHADERS TARGET_NAME SHADER_INCLUDE_FOLDER GENERATED_DIR
             OUTPUT ${CPP_FILE}
             COMMAND ${CMAKE_COMMAND} -DPATH=${SPV_FILE} -DHEADER="${CPP_FILE}" 
                 -DGLOBAL="${GLOBAL_SHADER_VAR}" -P "${JMENGINE_ROOT_DIR}/cmake/GenerateShaderCPPFile.cmake"
-            DEPENDS ${SPV_FILE}
+            DEPENDS ${SPV_FILE} "${JMENGINE_ROOT_DIR}/cmake/GenerateShaderCPPFile.cmake"
             WORKING_DIRECTORY "${working_dir}")
 
         list(APPEND ALL_GENERATED_CPP_FILES ${CPP_FILE})
 
+        string(APPEND REGISTRY_INCLUDES "#include \"${HEADER_NAME}.h\"\n")
+        string(APPEND REGISTRY_ENTRIES "    {\"${SHADER_NAME}\", ${GLOBAL_SHADER_VAR}, std::size(${GLOBAL_SHADER_VAR})},\n")
+
     endforeach()
 
+    # every embedded shader keyed by its source file name, only rewritten when the shader list changes
+    set(REGISTRY_FILE "${CMAKE_CURRENT_SOURCE_DIR}/${GENERATED_DIR}/cpp/shader_registry.h")
+    file(CONFIGURE OUTPUT ${REGISTRY_FILE} CONTENT
+"/**
+ * @file shader_registry.h
+ * @brief Auto generated file.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+@REGISTRY_INCLUDES@
+struct EmbeddedShader
+{
+    const char *name;
+    const uint32_t *words;
+    size_t wordCount;
+};
+
+inline constexpr EmbeddedShader EMBEDDED_SHADERS[] =
+{
+@REGISTRY_ENTRIES@};
+" @ONLY)
+
     add_custom_target(${TARGET_NAME}
         DEPENDS ${ALL_GENERATED_SPV_FILES} ${ALL_GENERATED_CPP_FILES} SOURCES ${SHADERS})
 
-endfunction()
\ No newline at end of file
+endfunction()
+# turns the permutation manifest into shader_permutations.h, one line per prewarmed pipeline:
+#   <vertex shader> <fragment shader> [<constant_id>=<value> ...]
+# values are integers or true/false, every other specialization constant keeps its default
+function(generate_shader_permutations SHADERS MANIFEST GENERATED_DIR)
+
+    set_property(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${MANIFEST})
+
+    set(SHADER_NAMES "")
+    foreach(SHADER ${SHADERS})
+        get_filename_component(SHADER_NAME ${SHADER} NAME)
+        list(APPEND SHADER_NAMES ${SHADER_NAME})
+    endforeach()
+
+    set(PERMUTATION_CONSTANTS "")
+    set(PERMUTATION_ENTRIES "")
+    set(CONSTANT_COUNT 0)
+    set(PERMUTATION_COUNT 0)
+
+    if(EXISTS ${MANIFEST})
+        file(STRINGS ${MANIFEST} MANIFEST_LINES)
+    else()
+        set(MANIFEST_LINES "")
+    endif()
+
+    foreach(LINE ${MANIFEST_LINES})
+        string(STRIP "${LINE}" LINE)
+        if(LINE STREQUAL "" OR LINE MATCHES "^#")
+            continue()
+        endif()
+
+        separate_arguments(FIELDS UNIX_COMMAND "${LINE}")
+        list(LENGTH FIELDS FIELD_COUNT)
+        if(FIELD_COUNT LESS 2)
+            message(FATAL_ERROR "${MANIFEST}: expected '<vertex> <fragment> [id=value ...]' in '${LINE}'")
+        endif()
+
+        list(GET FIELDS 0 VERTEX_SHADER)
+        list(GET FIELDS 1 FRAGMENT_SHADER)
+        foreach(STAGE_SHADER ${VERTEX_SHADER} ${FRAGMENT_SHADER})
+            if(NOT STAGE_SHADER IN_LIST SHADER_NAMES)
+                message(FATAL_ERROR "${MANIFEST}: unknown shader '${STAGE_SHADER}'")
+            endif()
+        endforeach()
+
+        set(FIRST_CONSTANT ${CONSTANT_COUNT})
+        set(CONSTANTS "")
+        if(FIELD_COUNT GREATER 2)
+            list(SUBLIST FIELDS 2 -1 CONSTANTS)
+        endif()
+        foreach(CONSTANT ${CONSTANTS})
+            if(NOT CONSTANT MATCHES "^([0-9]+)=(-?[0-9]+|true|false)$")
+                message(FATAL_ERROR "${MANIFEST}: malformed specialization constant '${CONSTANT}'")
+            endif()
+            set(CONSTANT_ID ${CMAKE_MATCH_1})
+            set(CONSTANT_VALUE ${CMAKE_MATCH_2})
+            if(CONSTANT_VALUE STREQUAL "true")
+                set(CONSTANT_VALUE 1)
+            elseif(CONSTANT_VALUE STREQUAL "false")
+                set(CONSTANT_VALUE 0)
+            endif()
+            string(APPEND PERMUTATION_CONSTANTS "    ShaderPermutationConstant{${CONSTANT_ID}, static_cast<uint32_t>(${CONSTANT_VALUE})},\n")
+            math(EXPR CONSTANT_COUNT "${CONSTANT_COUNT} + 1")
+        endforeach()
+        math(EXPR LOCAL_COUNT "${CONSTANT_COUNT} - ${FIRST_CONSTANT}")
+
+        string(APPEND PERMUTATION_ENTRIES "    ShaderPermutation{\"${VERTEX_SHADER}\", \"${FRAGMENT_SHADER}\", ${FIRST_CONSTANT}, ${LOCAL_COUNT}},\n")
+        math(EXPR PERMUTATION_COUNT "${PERMUTATION_COUNT} + 1")
+    endforeach()
+
+    set(PERMUTATION_FILE "${CMAKE_CURRENT_SOURCE_DIR}/${GENERATED_DIR}/cpp/shader_permutations.h")
+    file(CONFIGURE OUTPUT ${PERMUTATION_FILE} CONTENT
+"/**
+ * @file shader_permutations.h
+ * @brief Auto generated file.
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+struct ShaderPermutationConstant
+{
+    uint32_t constantId;
+    uint32_t value;
+};
+
+struct ShaderPermutation
+{
+    const char *vertexShader;
+    const char *fragmentShader;
+    // range in SHADER_PERMUTATION_CONSTANTS
+    size_t firstConstant;
+    size_t constantCount;
+};
+
+inline constexpr std::array<ShaderPermutationConstant, @CONSTANT_COUNT@> SHADER_PERMUTATION_CONSTANTS =
+{
+@PERMUTATION_CONSTANTS@};
+
+inline constexpr std::array<ShaderPermutation, @PERMUTATION_COUNT@> SHADER_PERMUTATIONS =
+{
+@PERMUTATION_ENTRIES@};
+" @ONLY)
+
+endfunction()
@@ -1,21 +1,114 @@
 ﻿#include "source/vulkan_rhi.h"
+#include "source/global/profiler.h"
 
+#include <glm/glm.hpp>
+
+#include <cstring>
 #include <memory>
+#include <string>
 
-int main(int, char **)
+int main(int argc, char **argv)
 {
 	JMEngine::WindowInfo windowInfo;
-	std::shared_ptr<JMEngine::WindowSystem> window = std::make_shared<JMEngine::WindowSystem>();
+	JMEngine::RHIInfo rhiInfo;
+
+	// --headless renders --frames offscreen frames without opening a window,
+	// --shader-dir loads freshly compiled .spv files over the embedded shaders,
+	// --hot-reload recompiles and swaps shaders while running,
+	// --trace writes cpu scope timings to a chrome trace json file,
+	// --hud shows the performance overlay,
+	// --msaa renders the main pass with 2, 4 or 8 samples,
+	// --depth-prepass lays down depth before shading
+	uint32_t headlessFrameCount = 100;
+	std::string tracePath;
+	for (int i = 1; i < argc; i++)
+	{
+		if (strcmp(argv[i], "--headless") == 0)
+		{
+			rhiInfo.isHeadless = true;
+		}
+		else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+		{
+			headlessFrameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--shader-dir") == 0 && i + 1 < argc)
+		{
+			rhiInfo.shaderOverrideDirectory = argv[++i];
+		}
+		else if (strcmp(argv[i], "--hot-reload") == 0)
+		{
+			rhiInfo.isShaderHotReloadEnabled = true;
+		}
+		else if (strcmp(argv[i], "--hud") == 0)
+		{
+			rhiInfo.isPerformanceHudEnabled = true;
+		}
+		else if (strcmp(argv[i], "--depth-prepass") == 0)
+		{
+			rhiInfo.isDepthPrepassEnabled = true;
+		}
+		else if (strcmp(argv[i], "--msaa") == 0 && i + 1 < argc)
+		{
+			rhiInfo.msaaSampleCount = static_cast<VkSampleCountFlagBits>(std::stoul(argv[++i]));
+		}
+		else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc)
+		{
+			tracePath = argv[++i];
+		}
+	}
+
+	if (!tracePath.empty())
+	{
+		PROFILE_THREAD_NAME("main");
+		PROFILE_BEGIN_SESSION(tracePath);
+	}
+
+	std::shared_ptr<JMEngine::WindowSystem> window;
 	std::shared_ptr<JMEngine::VulkanRHI> kulkanRHI = std::make_shared<JMEngine::VulkanRHI>();
-	window->Initialize(windowInfo);
-	kulkanRHI->Initialize(window);
-	GLFWwindow *mainWindow = window->GetWindow();
+	if (!rhiInfo.isHeadless)
+	{
+		window = std::make_shared<JMEngine::WindowSystem>();
+		window->Initialize(windowInfo);
+	}
+	kulkanRHI->Initialize(window, rhiInfo);
 
-	while (!glfwWindowShouldClose(mainWindow))
+	const JMEngine::Vertex triangleVertices[] = {
+		{{0.0f, -0.5f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+		{{0.5f, 0.5f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+		{{-0.5f, 0.5f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+	};
+	const uint32_t triangleIndices[] = {0, 1, 2};
+	JMEngine::MeshId triangle = kulkanRHI->CreateMesh(triangleVertices, triangleIndices);
+
+	auto drawTriangle = [&kulkanRHI, triangle]()
 	{
-		glfwPollEvents();
+		PROFILE_SCOPE("Frame");
+		kulkanRHI->BeginFrame();
+		JMEngine::DrawCall drawCall{3, 1, 0, 0};
+		drawCall.mesh = triangle;
+		drawCall.uniformOffset = kulkanRHI->PushUniform(glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+		kulkanRHI->SubmitDraw(drawCall);
 		kulkanRHI->DrawFrame();
+	};
+
+	if (rhiInfo.isHeadless)
+	{
+		for (uint32_t frame = 0; frame < headlessFrameCount; frame++)
+		{
+			drawTriangle();
+		}
+	}
+	else
+	{
+		GLFWwindow *mainWindow = window->GetWindow();
+		while (!glfwWindowShouldClose(mainWindow))
+		{
+			glfwPollEvents();
+			drawTriangle();
+		}
 	}
+	kulkanRHI->DestroyMesh(triangle);
 	kulkanRHI->Clear();
+	PROFILE_END_SESSION();
 	return 0;
 }
@@ -0,0 +1,25 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+layout(push_constant) uniform Transform {
+    // imgui display coordinates to clip space
+    vec2 scale;
+    vec2 translate;
+} transform;
+
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inUV;
+layout(location = 2) in vec4 inColor;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragUV;
+
+void main() {
+    fragColor = inColor;
+    fragUV = inUV;
+    gl_Position = vec4(inPosition * transform.scale + transform.translate, 0.0, 1.0);
+}
@@ -2,24 +2,21 @@
 #extension GL_ARB_separate_shader_objects : enable
 
 out gl_PerVertex {
-    vec4 gl_Position;
+    // the depth pre-pass and the main pass must agree exactly for the equal depth test
+    invariant vec4 gl_Position;
 };
 
-layout(location = 0) out vec3 fragColor;
+layout(set = 0, binding = 0) uniform PerDraw {
+    // xy offset, zw scale
+    vec4 offsetScale;
+} perDraw;
 
-vec2 positions[3] = vec2[](
-    vec2(0.0, -0.5),
-    vec2(0.5, 0.5),
-    vec2(-0.5, 0.5)
-);
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
 
-vec3 colors[3] = vec3[](
-    vec3(1.0, 0.0, 0.0),
-    vec3(0.0, 1.0, 0.0),
-    vec3(0.0, 0.0, 1.0)
-);
+layout(location = 0) out vec3 fragColor;
 
 void main() {
-    gl_Position = vec4(positions[gl_VertexIndex], 0.0, 1.0);
-    fragColor = colors[gl_VertexIndex];
-}
\ No newline at end of file
+    gl_Position = vec4(inPosition.xy * perDraw.offsetScale.zw + perDraw.offsetScale.xy, inPosition.z, 1.0);
+    fragColor = inColor;
+}
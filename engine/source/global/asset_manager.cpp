@@ -1,10 +1,12 @@
 #include "source/global/asset_manager.h"
 #include "source/global/log_system.h"
+#include "source/global/profiler.h"
 
 namespace JMEngine
 {
     std::vector<char> AssetManager::ReadFile(const std::string &filename)
     {
+        PROFILE_FUNCTION();
 
         std::ifstream file(filename, std::ios::ate | std::ios::binary);
 
@@ -0,0 +1,180 @@
+#include "source/global/profiler.h"
+#include "source/global/log_system.h"
+
+#include <cstdio>
+
+namespace JMEngine
+{
+	namespace
+	{
+		thread_local void *t_threadBuffer = nullptr;
+
+		void WriteEscaped(std::ofstream &file, const char *text)
+		{
+			for (; *text; text++)
+			{
+				if (*text == '"' || *text == '\\')
+				{
+					file.put('\\');
+				}
+				file.put(*text);
+			}
+		}
+	}
+
+	std::atomic<bool> Profiler::s_isRecording{false};
+
+	Profiler::~Profiler()
+	{
+		EndSession();
+	}
+
+	bool Profiler::BeginSession(const std::string &path)
+	{
+		EndSession();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_file.open(path, std::ios::binary | std::ios::trunc);
+		if (!m_file.is_open())
+		{
+			LOG_ERROR("failed to open trace file: " + path);
+			return false;
+		}
+		m_file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+		m_hasWrittenEvent = false;
+
+		// the flush thread is not running, leftovers of a previous session can be discarded
+		for (auto &buffer : m_threadBuffers)
+		{
+			buffer->tail.store(buffer->head.load(std::memory_order_acquire), std::memory_order_release);
+			buffer->droppedCount.store(0, std::memory_order_relaxed);
+		}
+
+		m_sessionBeginNs = Now();
+		m_isStopping = false;
+		m_flushThread = std::thread(&Profiler::FlushLoop, this);
+		s_isRecording.store(true, std::memory_order_release);
+		return true;
+	}
+
+	void Profiler::EndSession()
+	{
+		if (!m_flushThread.joinable())
+		{
+			return;
+		}
+		s_isRecording.store(false, std::memory_order_release);
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isStopping = true;
+		}
+		m_condition.notify_all();
+		m_flushThread.join();
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		uint64_t droppedCount = 0;
+		for (auto &buffer : m_threadBuffers)
+		{
+			droppedCount += buffer->droppedCount.load(std::memory_order_relaxed);
+			if (buffer->threadName.empty())
+			{
+				continue;
+			}
+			m_file << (m_hasWrittenEvent ? ",\n" : "\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadId
+				   << ",\"args\":{\"name\":\"";
+			WriteEscaped(m_file, buffer->threadName.c_str());
+			m_file << "\"}}";
+			m_hasWrittenEvent = true;
+		}
+		m_file << "\n]}\n";
+		m_file.close();
+
+		if (droppedCount > 0)
+		{
+			LOG_WARN("the profiler dropped " + std::to_string(droppedCount) + " events, the flush thread could not keep up");
+		}
+	}
+
+	void Profiler::Record(const char *name, int64_t beginNs, int64_t endNs)
+	{
+		ThreadBuffer &buffer = GetThreadBuffer();
+		uint32_t head = buffer.head.load(std::memory_order_relaxed);
+		if (head - buffer.cachedTail >= k_eventsPerThread)
+		{
+			buffer.cachedTail = buffer.tail.load(std::memory_order_acquire);
+			if (head - buffer.cachedTail >= k_eventsPerThread)
+			{
+				buffer.droppedCount.fetch_add(1, std::memory_order_relaxed);
+				return;
+			}
+		}
+		buffer.events[head & (k_eventsPerThread - 1)] = {name, beginNs, endNs};
+		buffer.head.store(head + 1, std::memory_order_release);
+	}
+
+	void Profiler::SetThreadName(const std::string &name)
+	{
+		ThreadBuffer &buffer = GetThreadBuffer();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		buffer.threadName = name;
+	}
+
+	Profiler::ThreadBuffer &Profiler::GetThreadBuffer()
+	{
+		// buffers outlive their threads so events of a finished thread are still flushed
+		if (!t_threadBuffer)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_threadBuffers.push_back(std::make_unique<ThreadBuffer>());
+			m_threadBuffers.back()->threadId = static_cast<uint32_t>(m_threadBuffers.size());
+			t_threadBuffer = m_threadBuffers.back().get();
+		}
+		return *static_cast<ThreadBuffer *>(t_threadBuffer);
+	}
+
+	void Profiler::FlushLoop()
+	{
+		PROFILE_THREAD_NAME("profiler flush");
+
+		std::vector<ThreadBuffer *> buffers;
+		bool isStopping = false;
+		while (!isStopping)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait_for(lock, std::chrono::milliseconds(10), [this]
+									 { return m_isStopping; });
+				isStopping = m_isStopping;
+				buffers.clear();
+				for (auto &buffer : m_threadBuffers)
+				{
+					buffers.push_back(buffer.get());
+				}
+			}
+			// only this thread writes the file while the session runs
+			Drain(buffers);
+		}
+	}
+
+	void Profiler::Drain(const std::vector<ThreadBuffer *> &buffers)
+	{
+		char line[64];
+		for (ThreadBuffer *buffer : buffers)
+		{
+			uint32_t tail = buffer->tail.load(std::memory_order_relaxed);
+			uint32_t head = buffer->head.load(std::memory_order_acquire);
+			for (; tail != head; tail++)
+			{
+				const ProfileEvent &event = buffer->events[tail & (k_eventsPerThread - 1)];
+				// complete events, microseconds since the session began
+				m_file << (m_hasWrittenEvent ? ",\n" : "\n") << "{\"name\":\"";
+				WriteEscaped(m_file, event.name);
+				snprintf(line, sizeof(line), "\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f", (event.beginNs - m_sessionBeginNs) * 1e-3,
+						 (event.endNs - event.beginNs) * 1e-3);
+				m_file << line << ",\"pid\":1,\"tid\":" << buffer->threadId << "}";
+				m_hasWrittenEvent = true;
+			}
+			buffer->tail.store(tail, std::memory_order_release);
+		}
+	}
+}
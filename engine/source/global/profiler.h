@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace JMEngine
+{
+	struct ProfileEvent
+	{
+		// a string literal or another name that outlives the session
+		const char *name;
+		int64_t beginNs;
+		int64_t endNs;
+	};
+
+	// scopes are appended to a ring owned by the recording thread, a background thread drains
+	// every ring into a chrome trace json file that chrome://tracing and perfetto both open
+	class Profiler final
+	{
+	private:
+		Profiler() = default;
+		~Profiler();
+		Profiler(const Profiler &profiler) = delete;
+		Profiler &operator=(const Profiler &profiler) = delete;
+
+		static constexpr uint32_t k_eventsPerThread = 1 << 14;
+
+		// single producer, the owning thread, and single consumer, the flush thread
+		struct ThreadBuffer
+		{
+			std::array<ProfileEvent, k_eventsPerThread> events;
+			// apart so the two threads do not bounce one cache line, the producer rereads tail only when it looks full
+			alignas(64) std::atomic<uint32_t> head{0};
+			uint32_t cachedTail{0};
+			std::atomic<uint64_t> droppedCount{0};
+			alignas(64) std::atomic<uint32_t> tail{0};
+			uint32_t threadId{0};
+			std::string threadName;
+		};
+
+		static std::atomic<bool> s_isRecording;
+
+		std::mutex m_mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> m_threadBuffers;
+		std::ofstream m_file;
+		std::thread m_flushThread;
+		std::condition_variable m_condition;
+		bool m_isStopping{false};
+		bool m_hasWrittenEvent{false};
+		int64_t m_sessionBeginNs{0};
+
+		ThreadBuffer &GetThreadBuffer();
+		void FlushLoop();
+		void Drain(const std::vector<ThreadBuffer *> &buffers);
+
+	public:
+		[[nodiscard]] inline static Profiler &GetInstance()
+		{
+			static Profiler g_profiler;
+			return g_profiler;
+		}
+
+		[[nodiscard]] inline static int64_t Now()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+		[[nodiscard]] inline static bool IsRecording() { return s_isRecording.load(std::memory_order_relaxed); }
+
+		// scopes ending between these two calls are written to path
+		bool BeginSession(const std::string &path);
+		void EndSession();
+
+		// a full ring drops the event rather than blocking the recording thread
+		void Record(const char *name, int64_t beginNs, int64_t endNs);
+		// the label of the calling thread's track in the trace
+		void SetThreadName(const std::string &name);
+	};
+
+	class ProfileScope final
+	{
+	public:
+		explicit ProfileScope(const char *name)
+			: m_name(Profiler::IsRecording() ? name : nullptr), m_beginNs(m_name ? Profiler::Now() : 0)
+		{
+		}
+		~ProfileScope()
+		{
+			if (m_name)
+			{
+				Profiler::GetInstance().Record(m_name, m_beginNs, Profiler::Now());
+			}
+		}
+		ProfileScope(const ProfileScope &profileScope) = delete;
+		ProfileScope &operator=(const ProfileScope &profileScope) = delete;
+
+	private:
+		const char *m_name;
+		int64_t m_beginNs;
+	};
+
+#define PROFILE_CONCAT_IMPL(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef JMENGINE_ENABLE_PROFILER
+#define PROFILE_SCOPE(name) JMEngine::ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__FUNCTION__)
+#define PROFILE_THREAD_NAME(name) JMEngine::Profiler::GetInstance().SetThreadName(name)
+#define PROFILE_BEGIN_SESSION(path) JMEngine::Profiler::GetInstance().BeginSession(path)
+#define PROFILE_END_SESSION() JMEngine::Profiler::GetInstance().EndSession()
+#else
+#define PROFILE_SCOPE(name)
+#define PROFILE_FUNCTION()
+#define PROFILE_THREAD_NAME(name)
+#define PROFILE_BEGIN_SESSION(path) ((void)(path))
+#define PROFILE_END_SESSION()
+#endif
+}
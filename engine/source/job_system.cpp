@@ -0,0 +1,129 @@
+#include "source/job_system.h"
+#include "source/global/profiler.h"
+
+#include <algorithm>
+
+namespace JMEngine
+{
+	JobSystem::~JobSystem()
+	{
+		Clear();
+	}
+
+	void JobSystem::Initialize(uint32_t workerCount)
+	{
+		m_isStopping = false;
+		for (uint32_t i = 0; i < workerCount; i++)
+		{
+			m_workers.emplace_back(&JobSystem::WorkerLoop, this, i + 1);
+		}
+	}
+
+	void JobSystem::Clear()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_isStopping = true;
+		}
+		m_condition.notify_all();
+
+		for (auto &worker : m_workers)
+		{
+			worker.join();
+		}
+		m_workers.clear();
+	}
+
+	std::future<void> JobSystem::Submit(std::function<void(uint32_t)> job)
+	{
+		auto task = std::make_shared<std::packaged_task<void(uint32_t)>>(std::move(job));
+		std::future<void> future = task->get_future();
+
+		if (m_workers.empty())
+		{
+			(*task)(0);
+			return future;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_jobs.push([task](uint32_t threadIndex)
+						{ (*task)(threadIndex); });
+		}
+		m_condition.notify_one();
+
+		return future;
+	}
+
+	void JobSystem::Dispatch(uint32_t jobCount, const std::function<void(uint32_t, uint32_t)> &job)
+	{
+		if (jobCount == 0)
+		{
+			return;
+		}
+
+		// helpers may pick this up after Dispatch has returned, so the state is shared
+		struct DispatchState
+		{
+			std::function<void(uint32_t, uint32_t)> job;
+			uint32_t jobCount;
+			std::atomic<uint32_t> nextJob{0};
+			std::atomic<uint32_t> finishedJobs{0};
+		};
+		auto state = std::make_shared<DispatchState>();
+		state->job = job;
+		state->jobCount = jobCount;
+
+		auto runJobs = [state](uint32_t threadIndex)
+		{
+			uint32_t jobIndex;
+			while ((jobIndex = state->nextJob.fetch_add(1)) < state->jobCount)
+			{
+				state->job(jobIndex, threadIndex);
+				state->finishedJobs.fetch_add(1, std::memory_order_release);
+			}
+		};
+
+		uint32_t helperCount = std::min(GetWorkerCount(), jobCount - 1);
+		if (helperCount > 0)
+		{
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				for (uint32_t i = 0; i < helperCount; i++)
+				{
+					m_jobs.push(runJobs);
+				}
+			}
+			m_condition.notify_all();
+		}
+
+		runJobs(0);
+
+		while (state->finishedJobs.load(std::memory_order_acquire) < jobCount)
+		{
+			std::this_thread::yield();
+		}
+	}
+
+	void JobSystem::WorkerLoop(uint32_t threadIndex)
+	{
+		PROFILE_THREAD_NAME("worker " + std::to_string(threadIndex));
+		while (true)
+		{
+			std::function<void(uint32_t)> job;
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				m_condition.wait(lock, [this]
+								 { return m_isStopping || !m_jobs.empty(); });
+				if (m_isStopping && m_jobs.empty())
+				{
+					return;
+				}
+				job = std::move(m_jobs.front());
+				m_jobs.pop();
+			}
+			PROFILE_SCOPE("Job");
+			job(threadIndex);
+		}
+	}
+}
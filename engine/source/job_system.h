@@ -0,0 +1,40 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace JMEngine
+{
+	class JobSystem final
+	{
+	public:
+		~JobSystem();
+		void Initialize(uint32_t workerCount);
+		void Clear();
+
+		// run on any worker, the argument is the worker's thread index starting from 1
+		std::future<void> Submit(std::function<void(uint32_t)> job);
+
+		// run job(jobIndex, threadIndex) for every index and return when all are done,
+		// the calling thread takes part as thread index 0 so this never waits on busy workers
+		void Dispatch(uint32_t jobCount, const std::function<void(uint32_t, uint32_t)> &job);
+
+		inline uint32_t GetWorkerCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+	private:
+		std::vector<std::thread> m_workers;
+		std::queue<std::function<void(uint32_t)>> m_jobs;
+		std::mutex m_mutex;
+		std::condition_variable m_condition;
+		bool m_isStopping{false};
+
+		void WorkerLoop(uint32_t threadIndex);
+	};
+}
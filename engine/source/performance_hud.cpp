@@ -0,0 +1,178 @@
+#include "source/performance_hud.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstdio>
+
+namespace JMEngine
+{
+	namespace
+	{
+		float BytesToMiB(VkDeviceSize bytes)
+		{
+			return static_cast<float>(bytes) / (1024.0f * 1024.0f);
+		}
+	}
+
+	void PerformanceHud::Initialize(uint32_t historyLength)
+	{
+		historyLength = std::max(historyLength, 2u);
+		m_cpuFrameMs.assign(historyLength, 0.0f);
+		m_gpuFrameMs.assign(historyLength, 0.0f);
+		m_historyHead = 0;
+		m_historyCount = 0;
+	}
+
+	void PerformanceHud::AddFrame(const HudFrameStats &stats, const GpuFrameTimings &gpuTimings)
+	{
+		if (m_cpuFrameMs.empty())
+		{
+			Initialize();
+		}
+
+		// the gpu timings lag a few frames behind, a frame whose results are not in yet repeats the last value
+		if (gpuTimings.frameNumber != m_lastGpuFrameNumber)
+		{
+			m_lastGpuFrameNumber = gpuTimings.frameNumber;
+			m_latestGpuTimings = gpuTimings;
+		}
+
+		m_cpuFrameMs[m_historyHead] = static_cast<float>(stats.cpuFrameMs);
+		m_gpuFrameMs[m_historyHead] = static_cast<float>(m_latestGpuTimings.frameMs);
+		m_historyHead = (m_historyHead + 1) % static_cast<uint32_t>(m_cpuFrameMs.size());
+		m_historyCount = std::min(m_historyCount + 1, static_cast<uint32_t>(m_cpuFrameMs.size()));
+
+		if (stats.cpuFrameMs > 0.0)
+		{
+			double bandwidth = static_cast<double>(stats.uploadBytes) * 1000.0 / stats.cpuFrameMs;
+			m_uploadBandwidth += (bandwidth - m_uploadBandwidth) * 0.1;
+		}
+		m_latestStats = stats;
+	}
+
+	PerformanceHud::Percentiles PerformanceHud::ComputePercentiles(const std::vector<float> &samples)
+	{
+		Percentiles percentiles;
+		if (m_historyCount == 0)
+		{
+			return percentiles;
+		}
+
+		// the ring holds m_historyCount valid samples ending just before the head
+		m_sortScratch.clear();
+		uint32_t size = static_cast<uint32_t>(samples.size());
+		for (uint32_t i = 0; i < m_historyCount; i++)
+		{
+			m_sortScratch.push_back(samples[(m_historyHead + size - 1 - i) % size]);
+		}
+		std::sort(m_sortScratch.begin(), m_sortScratch.end());
+
+		auto at = [this](float fraction)
+		{ return m_sortScratch[std::min(static_cast<size_t>(fraction * m_sortScratch.size()), m_sortScratch.size() - 1)]; };
+		percentiles.p50 = at(0.50f);
+		percentiles.p95 = at(0.95f);
+		percentiles.p99 = at(0.99f);
+		return percentiles;
+	}
+
+	void PerformanceHud::DrawFrameTimes(const char *label, const std::vector<float> &samples)
+	{
+		Percentiles percentiles = ComputePercentiles(samples);
+		ImGui::Text("%s  p50 %.2f  p95 %.2f  p99 %.2f ms", label, percentiles.p50, percentiles.p95, percentiles.p99);
+
+		// scaled to the p99 so a single spike does not flatten the graph
+		float scaleMax = std::max(percentiles.p99 * 1.5f, 1.0f);
+		uint32_t offset = m_historyCount < samples.size() ? 0 : m_historyHead;
+		ImGui::PushID(label);
+		ImGui::PlotLines("##frameTimes", samples.data(), static_cast<int>(m_historyCount), static_cast<int>(offset),
+						 nullptr, 0.0f, scaleMax, ImVec2(0.0f, 48.0f));
+		ImGui::PopID();
+	}
+
+	void PerformanceHud::Draw()
+	{
+		if (!m_isVisible)
+		{
+			return;
+		}
+
+		ImGui::SetNextWindowPos(ImVec2(8.0f, 8.0f), ImGuiCond_FirstUseEver);
+		ImGui::SetNextWindowBgAlpha(0.75f);
+		if (!ImGui::Begin("Performance", &m_isVisible, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoFocusOnAppearing))
+		{
+			ImGui::End();
+			return;
+		}
+
+		DrawFrameTimes("cpu frame", m_cpuFrameMs);
+		DrawFrameTimes("gpu frame", m_gpuFrameMs);
+
+		if (ImGui::CollapsingHeader("CPU", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			ImGui::Text("fence wait %.3f ms", m_latestStats.fenceWaitMs);
+			ImGui::Text("record     %.3f ms", m_latestStats.recordMs);
+			ImGui::Text("submit     %.3f ms", m_latestStats.submitMs);
+		}
+
+		if (ImGui::CollapsingHeader("GPU", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			if (m_latestGpuTimings.passes.empty())
+			{
+				ImGui::TextUnformatted("no timestamps");
+			}
+			for (const GpuPassTiming &pass : m_latestGpuTimings.passes)
+			{
+				ImGui::Text("%-12s %.3f ms", pass.name.c_str(), pass.durationMs);
+				if (pass.vertexInvocations > 0 || pass.fragmentInvocations > 0)
+				{
+					ImGui::SameLine();
+					ImGui::Text(" vs %llu  fs %llu", static_cast<unsigned long long>(pass.vertexInvocations),
+								static_cast<unsigned long long>(pass.fragmentInvocations));
+				}
+			}
+		}
+
+		if (ImGui::CollapsingHeader("Rendering", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			ImGui::Text("draws %u", m_latestStats.drawCount);
+			ImGui::Text("pipelines %zu (%u compiling)", m_latestStats.pipelineCount, m_latestStats.pendingPipelineCount);
+			ImGui::Text("upload %.2f / %.2f MiB per frame, %.1f MiB/s", BytesToMiB(m_latestStats.uploadBytes),
+						BytesToMiB(m_latestStats.uploadCapacity), m_uploadBandwidth / (1024.0 * 1024.0));
+			const UploadManagerStats &streaming = m_latestStats.streaming;
+			ImGui::Text("streaming %.2f / %.2f MiB staged, %.2f MiB waiting, %u batches on the %s queue", BytesToMiB(streaming.stagingUsed),
+						BytesToMiB(streaming.stagingCapacity), BytesToMiB(streaming.pendingBytes), streaming.batchesInFlight,
+						streaming.isDedicatedQueue ? "transfer" : "graphics");
+			const AsyncComputeStats &asyncCompute = m_latestStats.asyncCompute;
+			ImGui::Text("compute %u dispatches, %u ownership transfers on the %s queue%s", asyncCompute.dispatchCount,
+						asyncCompute.ownershipTransferCount, asyncCompute.isDedicatedQueue ? "compute" : "graphics",
+						asyncCompute.isWaitingOnGraphics ? ", waited on graphics" : "");
+			const RenderGraphStats &graph = m_latestStats.renderGraph;
+			ImGui::Text("graph %u passes (%u culled), %u barrier batches, %u image %u buffer barriers", graph.passCount, graph.culledPassCount,
+						graph.barrierBatchCount, graph.imageBarrierCount, graph.bufferBarrierCount);
+			ImGui::Text("transients %u (%u lazy), %.2f MiB aliased from %.2f MiB", graph.transientTextureCount, graph.lazyTextureCount,
+						BytesToMiB(graph.transientBytes), BytesToMiB(graph.unaliasedTransientBytes));
+		}
+
+		if (ImGui::CollapsingHeader("Memory", ImGuiTreeNodeFlags_DefaultOpen))
+		{
+			for (const MemoryHeapStats &heap : m_heapStats)
+			{
+				if (heap.blockCount == 0 && heap.dedicatedCount == 0)
+				{
+					continue;
+				}
+				bool isDeviceLocal = (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+				VkDeviceSize allocatedBytes = heap.blockBytes + heap.dedicatedBytes;
+				ImGui::Text("heap %u %s", heap.heapIndex, isDeviceLocal ? "device" : "host");
+				char overlay[64];
+				snprintf(overlay, sizeof(overlay), "%.1f / %.1f MiB", BytesToMiB(allocatedBytes), BytesToMiB(heap.heapSize));
+				ImGui::ProgressBar(heap.heapSize > 0 ? static_cast<float>(allocatedBytes) / heap.heapSize : 0.0f, ImVec2(240.0f, 0.0f), overlay);
+				ImGui::Text("  %u allocations, %.1f MiB used, fragmentation %.2f", heap.allocationCount + heap.dedicatedCount, BytesToMiB(heap.usedBytes + heap.dedicatedBytes),
+							heap.fragmentation);
+			}
+		}
+
+		ImGui::End();
+	}
+}
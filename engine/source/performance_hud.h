@@ -0,0 +1,72 @@
+#pragma once
+
+#include "source/rhi/render_graph.h"
+#include "source/rhi/vulkan_async_compute.h"
+#include "source/rhi/vulkan_gpu_profiler.h"
+#include "source/rhi/vulkan_memory_allocator.h"
+#include "source/rhi/vulkan_upload_manager.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace JMEngine
+{
+	// what the render thread measured for one frame
+	struct HudFrameStats
+	{
+		double cpuFrameMs{0.0};
+		double fenceWaitMs{0.0};
+		double recordMs{0.0};
+		double submitMs{0.0};
+		uint32_t drawCount{0};
+		size_t pipelineCount{0};
+		uint32_t pendingPipelineCount{0};
+		VkDeviceSize uploadBytes{0};
+		VkDeviceSize uploadCapacity{0};
+		RenderGraphStats renderGraph;
+		UploadManagerStats streaming;
+		AsyncComputeStats asyncCompute;
+	};
+
+	// keeps a short history of frame stats and lays them out as an imgui window
+	class PerformanceHud final
+	{
+	public:
+		void Initialize(uint32_t historyLength = 240);
+
+		void AddFrame(const HudFrameStats &stats, const GpuFrameTimings &gpuTimings);
+		inline void SetHeapStats(std::vector<MemoryHeapStats> &&heapStats) { m_heapStats = std::move(heapStats); }
+
+		// between ImGui::NewFrame and ImGui::Render
+		void Draw();
+
+		inline bool IsVisible() const { return m_isVisible; }
+		inline void SetVisible(bool isVisible) { m_isVisible = isVisible; }
+
+	private:
+		struct Percentiles
+		{
+			float p50{0.0f};
+			float p95{0.0f};
+			float p99{0.0f};
+		};
+
+		bool m_isVisible{true};
+		// rings indexed by m_historyHead, the oldest sample is at the head once they are full
+		std::vector<float> m_cpuFrameMs;
+		std::vector<float> m_gpuFrameMs;
+		uint32_t m_historyHead{0};
+		uint32_t m_historyCount{0};
+		std::vector<float> m_sortScratch;
+
+		HudFrameStats m_latestStats;
+		GpuFrameTimings m_latestGpuTimings;
+		uint64_t m_lastGpuFrameNumber{0};
+		// bytes per second, smoothed over a few frames
+		double m_uploadBandwidth{0.0};
+		std::vector<MemoryHeapStats> m_heapStats;
+
+		Percentiles ComputePercentiles(const std::vector<float> &samples);
+		void DrawFrameTimes(const char *label, const std::vector<float> &samples);
+	};
+}
@@ -0,0 +1,1227 @@
+#include "source/rhi/render_graph.h"
+#include "source/global/macro.h"
+
+#include <algorithm>
+
+namespace JMEngine
+{
+	namespace
+	{
+		struct UsageInfo
+		{
+			VkImageLayout layout;
+			VkPipelineStageFlags stages;
+			VkAccessFlags readAccess;
+			VkAccessFlags writeAccess;
+			VkImageUsageFlags imageUsage;
+		};
+
+		UsageInfo GetUsageInfo(RenderGraphUsage usage, VkPipelineStageFlags stages)
+		{
+			const VkPipelineStageFlags k_depthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			switch (usage)
+			{
+			case RenderGraphUsage::ColorAttachment:
+			case RenderGraphUsage::ResolveAttachment:
+				return {VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+						VK_ACCESS_COLOR_ATTACHMENT_READ_BIT, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT};
+			case RenderGraphUsage::DepthAttachment:
+				return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, k_depthStages,
+						VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT};
+			case RenderGraphUsage::DepthRead:
+				return {VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL, k_depthStages,
+						VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT, 0, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT};
+			case RenderGraphUsage::Sampled:
+				return {VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, stages ? stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT),
+						VK_ACCESS_SHADER_READ_BIT, 0, VK_IMAGE_USAGE_SAMPLED_BIT};
+			case RenderGraphUsage::StorageRead:
+				return {VK_IMAGE_LAYOUT_GENERAL, stages ? stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT),
+						VK_ACCESS_SHADER_READ_BIT, 0, VK_IMAGE_USAGE_STORAGE_BIT};
+			case RenderGraphUsage::StorageWrite:
+				return {VK_IMAGE_LAYOUT_GENERAL, stages ? stages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT),
+						VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT, VK_IMAGE_USAGE_STORAGE_BIT};
+			case RenderGraphUsage::TransferSrc:
+				return {VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+						VK_ACCESS_TRANSFER_READ_BIT, 0, VK_IMAGE_USAGE_TRANSFER_SRC_BIT};
+			case RenderGraphUsage::TransferDst:
+				return {VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_PIPELINE_STAGE_TRANSFER_BIT,
+						0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_IMAGE_USAGE_TRANSFER_DST_BIT};
+			case RenderGraphUsage::UniformBuffer:
+				return {VK_IMAGE_LAYOUT_UNDEFINED, stages ? stages : VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+						VK_ACCESS_UNIFORM_READ_BIT, 0, 0};
+			case RenderGraphUsage::VertexBuffer:
+				return {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, 0, 0};
+			case RenderGraphUsage::IndexBuffer:
+				return {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, 0, 0};
+			case RenderGraphUsage::IndirectBuffer:
+				return {VK_IMAGE_LAYOUT_UNDEFINED, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, 0, 0};
+			}
+			return {};
+		}
+
+		bool IsAttachment(RenderGraphUsage usage)
+		{
+			return usage == RenderGraphUsage::ColorAttachment || usage == RenderGraphUsage::ResolveAttachment ||
+				   usage == RenderGraphUsage::DepthAttachment || usage == RenderGraphUsage::DepthRead;
+		}
+
+		bool HasStencil(VkFormat format)
+		{
+			return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
+				   format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_S8_UINT;
+		}
+
+		bool IsDepthFormat(VkFormat format)
+		{
+			return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_X8_D24_UNORM_PACK32 || format == VK_FORMAT_D32_SFLOAT ||
+				   (HasStencil(format) && format != VK_FORMAT_S8_UINT);
+		}
+
+		VkImageAspectFlags GetAspectMask(VkFormat format)
+		{
+			if (format == VK_FORMAT_S8_UINT)
+			{
+				return VK_IMAGE_ASPECT_STENCIL_BIT;
+			}
+			if (IsDepthFormat(format))
+			{
+				return HasStencil(format) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+			}
+			return VK_IMAGE_ASPECT_COLOR_BIT;
+		}
+
+		// the legacy stage and access bits keep their values in the 2 variants
+		VkImageMemoryBarrier2KHR ToBarrier2(const VkImageMemoryBarrier &barrier, VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages)
+		{
+			VkImageMemoryBarrier2KHR barrier2 = {};
+			barrier2.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+			barrier2.srcStageMask = srcStages;
+			barrier2.srcAccessMask = barrier.srcAccessMask;
+			barrier2.dstStageMask = dstStages;
+			barrier2.dstAccessMask = barrier.dstAccessMask;
+			barrier2.oldLayout = barrier.oldLayout;
+			barrier2.newLayout = barrier.newLayout;
+			barrier2.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+			barrier2.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+			barrier2.image = barrier.image;
+			barrier2.subresourceRange = barrier.subresourceRange;
+			return barrier2;
+		}
+
+		VkBufferMemoryBarrier2KHR ToBarrier2(const VkBufferMemoryBarrier &barrier, VkPipelineStageFlags srcStages, VkPipelineStageFlags dstStages)
+		{
+			VkBufferMemoryBarrier2KHR barrier2 = {};
+			barrier2.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+			barrier2.srcStageMask = srcStages;
+			barrier2.srcAccessMask = barrier.srcAccessMask;
+			barrier2.dstStageMask = dstStages;
+			barrier2.dstAccessMask = barrier.dstAccessMask;
+			barrier2.srcQueueFamilyIndex = barrier.srcQueueFamilyIndex;
+			barrier2.dstQueueFamilyIndex = barrier.dstQueueFamilyIndex;
+			barrier2.buffer = barrier.buffer;
+			barrier2.offset = barrier.offset;
+			barrier2.size = barrier.size;
+			return barrier2;
+		}
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::WriteColor(RenderGraphResource texture, VkAttachmentLoadOp loadOp, VkClearColorValue clearValue)
+	{
+		RenderGraph::ResourceAccess access;
+		access.resource = texture;
+		access.usage = RenderGraphUsage::ColorAttachment;
+		access.isWrite = true;
+		access.loadOp = loadOp;
+		access.clearValue.color = clearValue;
+		m_graph.m_passes[m_passIndex].accesses.push_back(access);
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::WriteDepth(RenderGraphResource texture, VkAttachmentLoadOp loadOp, VkClearDepthStencilValue clearValue)
+	{
+		RenderGraph::ResourceAccess access;
+		access.resource = texture;
+		access.usage = RenderGraphUsage::DepthAttachment;
+		access.isWrite = true;
+		access.loadOp = loadOp;
+		access.clearValue.depthStencil = clearValue;
+		m_graph.m_passes[m_passIndex].accesses.push_back(access);
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::ReadDepth(RenderGraphResource texture)
+	{
+		RenderGraph::ResourceAccess access;
+		access.resource = texture;
+		access.usage = RenderGraphUsage::DepthRead;
+		access.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		m_graph.m_passes[m_passIndex].accesses.push_back(access);
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::ResolveColor(RenderGraphResource source, RenderGraphResource target)
+	{
+		RenderGraph::ResourceAccess access;
+		access.resource = target;
+		access.usage = RenderGraphUsage::ResolveAttachment;
+		access.isWrite = true;
+		access.resolveSource = source;
+		m_graph.m_passes[m_passIndex].accesses.push_back(access);
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::Read(RenderGraphResource resource, RenderGraphUsage usage, VkPipelineStageFlags stages)
+	{
+		RenderGraph::ResourceAccess access;
+		access.resource = resource;
+		access.usage = usage;
+		access.stages = stages;
+		m_graph.m_passes[m_passIndex].accesses.push_back(access);
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::Write(RenderGraphResource resource, RenderGraphUsage usage, VkPipelineStageFlags stages)
+	{
+		RenderGraph::ResourceAccess access;
+		access.resource = resource;
+		access.usage = usage;
+		access.stages = stages;
+		access.isWrite = true;
+		// partial writes keep what was there, so they depend on the previous writer
+		access.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+		m_graph.m_passes[m_passIndex].accesses.push_back(access);
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::SetSideEffect()
+	{
+		m_graph.m_passes[m_passIndex].hasSideEffect = true;
+		return *this;
+	}
+
+	RenderGraphPassBuilder &RenderGraphPassBuilder::SetSecondaryContents()
+	{
+		m_graph.m_passes[m_passIndex].isSecondaryContents = true;
+		return *this;
+	}
+
+	void RenderGraph::Initialize(VkDevice device, VulkanMemoryAllocator *memoryAllocator, bool isDynamicRenderingEnabled, DeferDestroyFunction &&deferDestroy)
+	{
+		m_device = device;
+		m_memoryAllocator = memoryAllocator;
+		m_deferDestroy = std::move(deferDestroy);
+		m_isLazyMemorySupported = m_memoryAllocator->HasMemoryType(VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+
+		_vkCmdPipelineBarrier = (PFN_vkCmdPipelineBarrier)vkGetDeviceProcAddr(m_device, "vkCmdPipelineBarrier");
+		_vkCmdBeginRenderPass = (PFN_vkCmdBeginRenderPass)vkGetDeviceProcAddr(m_device, "vkCmdBeginRenderPass");
+		_vkCmdEndRenderPass = (PFN_vkCmdEndRenderPass)vkGetDeviceProcAddr(m_device, "vkCmdEndRenderPass");
+		m_isDynamicRenderingEnabled = isDynamicRenderingEnabled;
+		if (m_isDynamicRenderingEnabled)
+		{
+			_vkCmdPipelineBarrier2KHR = (PFN_vkCmdPipelineBarrier2KHR)vkGetDeviceProcAddr(m_device, "vkCmdPipelineBarrier2KHR");
+			_vkCmdBeginRenderingKHR = (PFN_vkCmdBeginRenderingKHR)vkGetDeviceProcAddr(m_device, "vkCmdBeginRenderingKHR");
+			_vkCmdEndRenderingKHR = (PFN_vkCmdEndRenderingKHR)vkGetDeviceProcAddr(m_device, "vkCmdEndRenderingKHR");
+		}
+	}
+
+	void RenderGraph::Clear()
+	{
+		for (TransientTexture &transient : m_transients)
+		{
+			vkDestroyImageView(m_device, transient.view, nullptr);
+			vkDestroyImage(m_device, transient.image, nullptr);
+		}
+		m_transients.clear();
+		for (MemorySlot &slot : m_memorySlots)
+		{
+			m_memoryAllocator->Free(slot.allocation);
+		}
+		m_memorySlots.clear();
+		m_transientSignature.clear();
+
+		for (auto &[key, framebuffer] : m_framebuffers)
+		{
+			vkDestroyFramebuffer(m_device, framebuffer, nullptr);
+		}
+		m_framebuffers.clear();
+		for (auto &[key, renderPass] : m_renderPasses)
+		{
+			vkDestroyRenderPass(m_device, renderPass, nullptr);
+		}
+		m_renderPasses.clear();
+		Reset();
+	}
+
+	void RenderGraph::Reset()
+	{
+		m_resources.clear();
+		m_passes.clear();
+		m_finalBarriers.clear();
+		m_finalBarriers2.clear();
+	}
+
+	RenderGraphResource RenderGraph::ImportTexture(const std::string &name, const RenderGraphImportedTexture &texture)
+	{
+		Resource resource;
+		resource.name = name;
+		resource.isImported = true;
+		resource.imported = texture;
+		resource.desc = {texture.format, texture.extent, texture.samples};
+		resource.image = texture.image;
+		resource.view = texture.view;
+		m_resources.push_back(std::move(resource));
+		return static_cast<RenderGraphResource>(m_resources.size() - 1);
+	}
+
+	RenderGraphResource RenderGraph::ImportBuffer(const std::string &name, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+	{
+		Resource resource;
+		resource.name = name;
+		resource.isTexture = false;
+		resource.isImported = true;
+		resource.buffer = buffer;
+		resource.bufferOffset = offset;
+		resource.bufferSize = size;
+		m_resources.push_back(std::move(resource));
+		return static_cast<RenderGraphResource>(m_resources.size() - 1);
+	}
+
+	RenderGraphResource RenderGraph::CreateTexture(const std::string &name, const RenderGraphTextureDesc &desc)
+	{
+		Resource resource;
+		resource.name = name;
+		resource.desc = desc;
+		m_resources.push_back(std::move(resource));
+		return static_cast<RenderGraphResource>(m_resources.size() - 1);
+	}
+
+	RenderGraphPassBuilder RenderGraph::AddPass(const std::string &name, RenderGraphExecute &&execute)
+	{
+		Pass pass;
+		pass.name = name;
+		pass.execute = std::move(execute);
+		m_passes.push_back(std::move(pass));
+		return RenderGraphPassBuilder(*this, static_cast<uint32_t>(m_passes.size() - 1));
+	}
+
+	void RenderGraph::Compile()
+	{
+		m_stats = {};
+		m_stats.passCount = static_cast<uint32_t>(m_passes.size());
+
+		CullPasses();
+		ComputeLifetimes();
+		ResolveAttachmentOps();
+		RealizeTransients();
+		ComputeBarriers();
+		PrepareRenderPasses();
+	}
+
+	void RenderGraph::CullPasses()
+	{
+		// walking backwards from the outputs, a pass lives when a later live pass or an output needs what it writes
+		std::vector<bool> isNeeded(m_resources.size(), false);
+		for (size_t i = 0; i < m_resources.size(); i++)
+		{
+			isNeeded[i] = m_resources[i].isImported;
+		}
+
+		for (size_t i = m_passes.size(); i-- > 0;)
+		{
+			Pass &pass = m_passes[i];
+			pass.isAlive = pass.hasSideEffect;
+			for (const ResourceAccess &access : pass.accesses)
+			{
+				pass.isAlive |= access.isWrite && isNeeded[access.resource];
+			}
+			if (!pass.isAlive)
+			{
+				m_stats.culledPassCount++;
+				continue;
+			}
+
+			// a full overwrite hides every earlier write from the passes after this one
+			for (const ResourceAccess &access : pass.accesses)
+			{
+				if (access.isWrite && access.loadOp != VK_ATTACHMENT_LOAD_OP_LOAD && !m_resources[access.resource].isImported)
+				{
+					isNeeded[access.resource] = false;
+				}
+			}
+			for (const ResourceAccess &access : pass.accesses)
+			{
+				if (!access.isWrite || access.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+				{
+					isNeeded[access.resource] = true;
+				}
+			}
+		}
+	}
+
+	void RenderGraph::ComputeLifetimes()
+	{
+		for (uint32_t i = 0; i < m_passes.size(); i++)
+		{
+			if (!m_passes[i].isAlive)
+			{
+				continue;
+			}
+			for (const ResourceAccess &access : m_passes[i].accesses)
+			{
+				Resource &resource = m_resources[access.resource];
+				resource.firstPass = std::min(resource.firstPass, i);
+				resource.lastPass = std::max(resource.lastPass, i);
+				if (!access.isWrite || access.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD)
+				{
+					resource.lastReadPass = std::max(resource.lastReadPass, i);
+				}
+				resource.usage |= GetUsageInfo(access.usage, access.stages).imageUsage;
+			}
+		}
+	}
+
+	void RenderGraph::ResolveAttachmentOps()
+	{
+		for (uint32_t i = 0; i < m_passes.size(); i++)
+		{
+			if (!m_passes[i].isAlive)
+			{
+				continue;
+			}
+			for (ResourceAccess &access : m_passes[i].accesses)
+			{
+				if (!IsAttachment(access.usage))
+				{
+					continue;
+				}
+				const Resource &resource = m_resources[access.resource];
+				// nothing was written before the first use, loading would only fetch garbage
+				bool hasContents = i != resource.firstPass || (resource.isImported && resource.imported.initialLayout != VK_IMAGE_LAYOUT_UNDEFINED);
+				if (access.loadOp == VK_ATTACHMENT_LOAD_OP_LOAD && !hasContents)
+				{
+					access.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				}
+				// on tilers a dont care store never leaves tile memory, a multisampled target is resolved regardless
+				access.storeOp = resource.isImported || resource.lastReadPass > i ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			}
+		}
+	}
+
+	void RenderGraph::RealizeTransients()
+	{
+		// the transients of a frame are usually the same as the last one's, then the images are reused as they are
+		std::vector<uint32_t> transientResources;
+		std::vector<uint64_t> signature;
+		for (uint32_t i = 0; i < m_resources.size(); i++)
+		{
+			const Resource &resource = m_resources[i];
+			if (resource.isImported || !resource.isTexture || resource.firstPass == UINT32_MAX)
+			{
+				continue;
+			}
+			transientResources.push_back(i);
+			signature.insert(signature.end(), {static_cast<uint64_t>(resource.desc.format), resource.desc.extent.width, resource.desc.extent.height,
+											   static_cast<uint64_t>(resource.desc.samples), resource.usage, resource.firstPass, resource.lastPass});
+		}
+
+		if (signature != m_transientSignature)
+		{
+			DestroyTransients();
+			m_transientSignature = signature;
+
+			std::vector<VkMemoryRequirements> requirements(transientResources.size());
+			m_transients.resize(transientResources.size());
+			for (size_t i = 0; i < transientResources.size(); i++)
+			{
+				const Resource &resource = m_resources[transientResources[i]];
+				TransientTexture &transient = m_transients[i];
+				transient.desc = resource.desc;
+				transient.usage = resource.usage;
+				// an attachment that lives inside one pass is never stored, so it needs no memory outside of tile memory
+				const VkImageUsageFlags k_attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+														   VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+				if ((resource.usage & ~k_attachmentUsage) == 0 && resource.firstPass == resource.lastPass)
+				{
+					transient.usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+					transient.isLazy = m_isLazyMemorySupported;
+				}
+
+				VkImageCreateInfo imageInfo = {};
+				imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+				imageInfo.imageType = VK_IMAGE_TYPE_2D;
+				imageInfo.format = resource.desc.format;
+				imageInfo.extent = {resource.desc.extent.width, resource.desc.extent.height, 1};
+				imageInfo.mipLevels = 1;
+				imageInfo.arrayLayers = 1;
+				imageInfo.samples = resource.desc.samples;
+				imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+				imageInfo.usage = transient.usage;
+				imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+				imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+				if (vkCreateImage(m_device, &imageInfo, nullptr, &transient.image) != VK_SUCCESS)
+				{
+					LOG_ERROR("failed to create transient image " + resource.name);
+				}
+				vkGetImageMemoryRequirements(m_device, transient.image, &requirements[i]);
+			}
+
+			// first fit in order of first use, a slot is free once its last occupant's last pass is behind
+			std::vector<size_t> order(transientResources.size());
+			for (size_t i = 0; i < order.size(); i++)
+			{
+				order[i] = i;
+			}
+			std::sort(order.begin(), order.end(), [&](size_t a, size_t b)
+					  { return m_resources[transientResources[a]].firstPass < m_resources[transientResources[b]].firstPass; });
+
+			std::vector<VkMemoryRequirements> slotRequirements;
+			std::vector<uint32_t> slotBusyUntil;
+			std::vector<bool> slotIsLazy;
+			for (size_t i : order)
+			{
+				const Resource &resource = m_resources[transientResources[i]];
+				const VkMemoryRequirements &required = requirements[i];
+				uint32_t chosenSlot = UINT32_MAX;
+				for (uint32_t slot = 0; slot < slotRequirements.size(); slot++)
+				{
+					bool isFree = slotBusyUntil[slot] < resource.firstPass;
+					bool isCompatible = (slotRequirements[slot].memoryTypeBits & required.memoryTypeBits) != 0 && slotIsLazy[slot] == m_transients[i].isLazy;
+					if (!isFree || !isCompatible)
+					{
+						continue;
+					}
+					// prefer a slot that already has the room
+					if (chosenSlot == UINT32_MAX || (slotRequirements[slot].size >= required.size && slotRequirements[chosenSlot].size < required.size))
+					{
+						chosenSlot = slot;
+					}
+				}
+				if (chosenSlot == UINT32_MAX)
+				{
+					chosenSlot = static_cast<uint32_t>(slotRequirements.size());
+					slotRequirements.push_back(required);
+					slotBusyUntil.push_back(resource.lastPass);
+					slotIsLazy.push_back(m_transients[i].isLazy);
+				}
+				else
+				{
+					VkMemoryRequirements &slotRequired = slotRequirements[chosenSlot];
+					slotRequired.size = std::max(slotRequired.size, required.size);
+					slotRequired.alignment = std::max(slotRequired.alignment, required.alignment);
+					slotRequired.memoryTypeBits &= required.memoryTypeBits;
+					slotBusyUntil[chosenSlot] = resource.lastPass;
+				}
+				m_transients[i].memorySlot = chosenSlot;
+			}
+
+			m_memorySlots.resize(slotRequirements.size());
+			for (size_t slot = 0; slot < slotRequirements.size(); slot++)
+			{
+				// its own allocation, aliased images must not share a block with unrelated resources
+				m_memorySlots[slot].isLazy = slotIsLazy[slot];
+				VkMemoryPropertyFlags preferredFlags = slotIsLazy[slot] ? VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT : 0;
+				if (!m_memoryAllocator->Allocate(slotRequirements[slot], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, preferredFlags, false, true, m_memorySlots[slot].allocation))
+				{
+					LOG_ERROR("failed to allocate transient memory!");
+				}
+			}
+
+			for (size_t i = 0; i < m_transients.size(); i++)
+			{
+				TransientTexture &transient = m_transients[i];
+				const VulkanAllocation &allocation = m_memorySlots[transient.memorySlot].allocation;
+				vkBindImageMemory(m_device, transient.image, allocation.memory, allocation.offset);
+
+				VkImageViewCreateInfo viewInfo = {};
+				viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+				viewInfo.image = transient.image;
+				viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+				viewInfo.format = transient.desc.format;
+				// sampling a depth stencil image reads depth
+				viewInfo.subresourceRange.aspectMask = GetAspectMask(transient.desc.format) & ~(IsDepthFormat(transient.desc.format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+				viewInfo.subresourceRange.levelCount = 1;
+				viewInfo.subresourceRange.layerCount = 1;
+				if (vkCreateImageView(m_device, &viewInfo, nullptr, &transient.view) != VK_SUCCESS)
+				{
+					LOG_ERROR("failed to create transient image view!");
+				}
+			}
+
+			m_transientBytes = 0;
+			m_unaliasedTransientBytes = 0;
+			m_lazyTextureCount = 0;
+			for (const TransientTexture &transient : m_transients)
+			{
+				m_lazyTextureCount += transient.isLazy ? 1 : 0;
+			}
+			for (const VkMemoryRequirements &required : slotRequirements)
+			{
+				m_transientBytes += required.size;
+			}
+			for (const VkMemoryRequirements &required : requirements)
+			{
+				m_unaliasedTransientBytes += required.size;
+			}
+		}
+
+		for (size_t i = 0; i < transientResources.size(); i++)
+		{
+			Resource &resource = m_resources[transientResources[i]];
+			resource.transientIndex = static_cast<uint32_t>(i);
+			resource.image = m_transients[i].image;
+			resource.view = m_transients[i].view;
+		}
+		m_stats.transientTextureCount = static_cast<uint32_t>(m_transients.size());
+		m_stats.lazyTextureCount = m_lazyTextureCount;
+		m_stats.transientBytes = m_transientBytes;
+		m_stats.unaliasedTransientBytes = m_unaliasedTransientBytes;
+	}
+
+	void RenderGraph::DestroyTransients()
+	{
+		if (m_transients.empty() && m_memorySlots.empty())
+		{
+			return;
+		}
+
+		// frames in flight may still use them, and every framebuffer may reference one
+		ReleaseFramebuffers();
+		std::vector<TransientTexture> transients = std::move(m_transients);
+		std::vector<MemorySlot> memorySlots = std::move(m_memorySlots);
+		m_transients.clear();
+		m_memorySlots.clear();
+		m_deferDestroy([this, transients, memorySlots]() mutable
+					   {
+						   for (TransientTexture &transient : transients)
+						   {
+							   vkDestroyImageView(m_device, transient.view, nullptr);
+							   vkDestroyImage(m_device, transient.image, nullptr);
+						   }
+						   for (MemorySlot &slot : memorySlots)
+						   {
+							   m_memoryAllocator->Free(slot.allocation);
+						   } });
+	}
+
+	void RenderGraph::ComputeBarriers()
+	{
+		for (Resource &resource : m_resources)
+		{
+			resource.state = {};
+			if (resource.isImported && resource.isTexture)
+			{
+				resource.state.layout = resource.imported.initialLayout;
+				resource.state.writeStages = resource.imported.initialStage;
+			}
+		}
+
+		for (uint32_t passIndex = 0; passIndex < m_passes.size(); passIndex++)
+		{
+			Pass &pass = m_passes[passIndex];
+			pass.srcStages = 0;
+			pass.dstStages = 0;
+			pass.imageBarriers.clear();
+			pass.bufferBarriers.clear();
+			pass.imageBarriers2.clear();
+			pass.bufferBarriers2.clear();
+			if (!pass.isAlive)
+			{
+				continue;
+			}
+
+			for (const ResourceAccess &access : pass.accesses)
+			{
+				Resource &resource = m_resources[access.resource];
+				ResourceState &state = resource.state;
+				UsageInfo info = GetUsageInfo(access.usage, access.stages);
+				MemorySlot *memorySlot = resource.transientIndex != UINT32_MAX ? &m_memorySlots[m_transients[resource.transientIndex].memorySlot] : nullptr;
+
+				// the memory's previous occupant, possibly from the last frame, has to be done with it
+				if (memorySlot && resource.firstPass == passIndex)
+				{
+					state.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+					state.writeStages = memorySlot->lastStages;
+					state.writeAccess = memorySlot->lastAccess;
+				}
+
+				VkAccessFlags dstAccess = access.isWrite ? info.readAccess | info.writeAccess : info.readAccess;
+				bool isTransition = resource.isTexture && info.layout != state.layout;
+				bool isBarrier = isTransition;
+				VkPipelineStageFlags srcStages = state.writeStages | state.readStages;
+				VkAccessFlags srcAccess = state.writeAccess;
+				if (!isTransition && access.isWrite)
+				{
+					// write after write or after read
+					isBarrier = srcStages != 0;
+				}
+				else if (!isTransition)
+				{
+					// read after write, once per stage that has not seen the write yet
+					srcStages = state.writeStages;
+					isBarrier = state.writeStages != 0 && (info.stages & ~state.visibleStages) != 0;
+				}
+
+				if (isBarrier)
+				{
+					// one batch per pass, with synchronization2 each barrier only waits for the stages it needs
+					srcStages = srcStages ? srcStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+					pass.srcStages |= srcStages;
+					pass.dstStages |= info.stages;
+					if (resource.isTexture)
+					{
+						VkImageMemoryBarrier barrier = {};
+						barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+						barrier.srcAccessMask = srcAccess;
+						barrier.dstAccessMask = dstAccess;
+						// contents that are about to be cleared or discarded need not be kept through the transition
+						bool isDiscarded = access.isWrite && IsAttachment(access.usage) && access.loadOp != VK_ATTACHMENT_LOAD_OP_LOAD;
+						barrier.oldLayout = isDiscarded ? VK_IMAGE_LAYOUT_UNDEFINED : state.layout;
+						barrier.newLayout = info.layout;
+						barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+						barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+						barrier.image = resource.image;
+						barrier.subresourceRange.aspectMask = GetAspectMask(resource.desc.format);
+						barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+						barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+						if (m_isDynamicRenderingEnabled)
+						{
+							pass.imageBarriers2.push_back(ToBarrier2(barrier, srcStages, info.stages));
+						}
+						else
+						{
+							pass.imageBarriers.push_back(barrier);
+						}
+					}
+					else
+					{
+						VkBufferMemoryBarrier barrier = {};
+						barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+						barrier.srcAccessMask = srcAccess;
+						barrier.dstAccessMask = dstAccess;
+						barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+						barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+						barrier.buffer = resource.buffer;
+						barrier.offset = resource.bufferOffset;
+						barrier.size = resource.bufferSize;
+						if (m_isDynamicRenderingEnabled)
+						{
+							pass.bufferBarriers2.push_back(ToBarrier2(barrier, srcStages, info.stages));
+						}
+						else
+						{
+							pass.bufferBarriers.push_back(barrier);
+						}
+					}
+				}
+
+				// a layout transition counts as a write that later stages have to wait for
+				if (access.isWrite || isTransition)
+				{
+					state.writeStages = info.stages;
+					state.writeAccess = access.isWrite ? info.writeAccess : 0;
+					state.readStages = access.isWrite ? 0 : info.stages;
+					state.visibleStages = info.stages;
+				}
+				else
+				{
+					state.readStages |= info.stages;
+					state.visibleStages |= isBarrier ? info.stages : 0;
+				}
+				// a dont care store may still write to a read only depth attachment, whoever reuses the memory waits for it
+				if (access.usage == RenderGraphUsage::DepthRead && access.storeOp == VK_ATTACHMENT_STORE_OP_DONT_CARE)
+				{
+					state.writeStages |= info.stages;
+					state.writeAccess |= VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+				}
+				if (resource.isTexture)
+				{
+					state.layout = info.layout;
+				}
+				if (memorySlot)
+				{
+					memorySlot->lastStages = state.writeStages | state.readStages;
+					memorySlot->lastAccess = state.writeAccess;
+				}
+			}
+
+			uint32_t imageBarrierCount = static_cast<uint32_t>(pass.imageBarriers.size() + pass.imageBarriers2.size());
+			uint32_t bufferBarrierCount = static_cast<uint32_t>(pass.bufferBarriers.size() + pass.bufferBarriers2.size());
+			if (imageBarrierCount != 0 || bufferBarrierCount != 0)
+			{
+				m_stats.barrierBatchCount++;
+				m_stats.imageBarrierCount += imageBarrierCount;
+				m_stats.bufferBarrierCount += bufferBarrierCount;
+			}
+		}
+
+		// hand imported textures over in the layout their next user expects
+		m_finalSrcStages = 0;
+		m_finalDstStages = 0;
+		for (Resource &resource : m_resources)
+		{
+			if (!resource.isImported || !resource.isTexture || resource.firstPass == UINT32_MAX ||
+				resource.imported.finalLayout == VK_IMAGE_LAYOUT_UNDEFINED || resource.imported.finalLayout == resource.state.layout)
+			{
+				continue;
+			}
+			VkImageMemoryBarrier barrier = {};
+			barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			barrier.srcAccessMask = resource.state.writeAccess;
+			barrier.dstAccessMask = resource.imported.finalAccess;
+			barrier.oldLayout = resource.state.layout;
+			barrier.newLayout = resource.imported.finalLayout;
+			barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			barrier.image = resource.image;
+			barrier.subresourceRange.aspectMask = GetAspectMask(resource.desc.format);
+			barrier.subresourceRange.levelCount = VK_REMAINING_MIP_LEVELS;
+			barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+			VkPipelineStageFlags srcStages = resource.state.writeStages | resource.state.readStages;
+			srcStages = srcStages ? srcStages : static_cast<VkPipelineStageFlags>(VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+			m_finalSrcStages |= srcStages;
+			m_finalDstStages |= resource.imported.finalStage;
+			if (m_isDynamicRenderingEnabled)
+			{
+				m_finalBarriers2.push_back(ToBarrier2(barrier, srcStages, resource.imported.finalStage));
+			}
+			else
+			{
+				m_finalBarriers.push_back(barrier);
+			}
+		}
+		if (!m_finalBarriers.empty() || !m_finalBarriers2.empty())
+		{
+			m_stats.barrierBatchCount++;
+			m_stats.imageBarrierCount += static_cast<uint32_t>(m_finalBarriers.size() + m_finalBarriers2.size());
+		}
+	}
+
+	void RenderGraph::PrepareRenderPasses()
+	{
+		for (Pass &pass : m_passes)
+		{
+			pass.isGraphics = false;
+			pass.renderPass = VK_NULL_HANDLE;
+			pass.framebuffer = VK_NULL_HANDLE;
+			pass.clearValues.clear();
+			pass.colorAttachments.clear();
+			pass.colorFormats.clear();
+			pass.depthFormat = VK_FORMAT_UNDEFINED;
+			if (!pass.isAlive)
+			{
+				continue;
+			}
+
+			// colors first, then depth, then resolve targets, in declaration order
+			std::vector<RenderGraphAttachment> colorAttachments;
+			std::vector<RenderGraphResource> colorResources;
+			RenderGraphAttachment depthAttachment;
+			bool hasDepth = false;
+			std::vector<VkImageView> views;
+			std::vector<VkClearValue> colorClears;
+			VkClearValue depthClear = {};
+			VkImageView depthView = VK_NULL_HANDLE;
+			VkExtent2D extent = {UINT32_MAX, UINT32_MAX};
+			for (const ResourceAccess &access : pass.accesses)
+			{
+				if (!IsAttachment(access.usage) || access.usage == RenderGraphUsage::ResolveAttachment)
+				{
+					continue;
+				}
+				const Resource &resource = m_resources[access.resource];
+				RenderGraphAttachment attachment;
+				attachment.format = resource.desc.format;
+				attachment.samples = resource.desc.samples;
+				attachment.loadOp = access.loadOp;
+				attachment.storeOp = access.storeOp;
+				attachment.isReadOnly = !access.isWrite;
+				extent.width = std::min(extent.width, resource.desc.extent.width);
+				extent.height = std::min(extent.height, resource.desc.extent.height);
+
+				if (access.usage == RenderGraphUsage::ColorAttachment)
+				{
+					colorAttachments.push_back(attachment);
+					colorResources.push_back(access.resource);
+					views.push_back(resource.view);
+					colorClears.push_back(access.clearValue);
+				}
+				else
+				{
+					depthAttachment = attachment;
+					depthView = resource.view;
+					depthClear = access.clearValue;
+					hasDepth = true;
+				}
+			}
+			if (colorAttachments.empty() && !hasDepth)
+			{
+				continue;
+			}
+			if (hasDepth)
+			{
+				views.push_back(depthView);
+			}
+
+			std::vector<RenderGraphAttachment> resolveAttachments;
+			std::vector<VkImageView> resolveViews;
+			for (const ResourceAccess &access : pass.accesses)
+			{
+				if (access.usage != RenderGraphUsage::ResolveAttachment)
+				{
+					continue;
+				}
+				auto it = std::find(colorResources.begin(), colorResources.end(), access.resolveSource);
+				if (it == colorResources.end())
+				{
+					LOG_ERROR("resolve source of " + m_resources[access.resource].name + " is not a color attachment of pass " + pass.name);
+					continue;
+				}
+				const Resource &resource = m_resources[access.resource];
+				resolveAttachments.resize(colorAttachments.size());
+				resolveViews.resize(colorAttachments.size(), VK_NULL_HANDLE);
+				resolveViews[it - colorResources.begin()] = resource.view;
+				RenderGraphAttachment &attachment = resolveAttachments[it - colorResources.begin()];
+				attachment.format = resource.desc.format;
+				attachment.samples = resource.desc.samples;
+				attachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				attachment.storeOp = access.storeOp;
+			}
+
+			pass.isGraphics = true;
+			pass.extent = extent;
+			pass.samples = colorAttachments.empty() ? depthAttachment.samples : colorAttachments[0].samples;
+			for (const RenderGraphAttachment &attachment : colorAttachments)
+			{
+				pass.colorFormats.push_back(attachment.format);
+			}
+			pass.depthFormat = hasDepth ? depthAttachment.format : VK_FORMAT_UNDEFINED;
+			if (m_isDynamicRenderingEnabled)
+			{
+				// layouts are the ones the barriers moved the attachments to, a resolve always writes its target
+				for (size_t i = 0; i < colorAttachments.size(); i++)
+				{
+					VkRenderingAttachmentInfoKHR attachmentInfo = {};
+					attachmentInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+					attachmentInfo.imageView = views[i];
+					attachmentInfo.imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+					attachmentInfo.loadOp = colorAttachments[i].loadOp;
+					attachmentInfo.storeOp = colorAttachments[i].storeOp;
+					attachmentInfo.clearValue = colorClears[i];
+					if (i < resolveViews.size() && resolveViews[i] != VK_NULL_HANDLE)
+					{
+						attachmentInfo.resolveMode = VK_RESOLVE_MODE_AVERAGE_BIT;
+						attachmentInfo.resolveImageView = resolveViews[i];
+						attachmentInfo.resolveImageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+					}
+					pass.colorAttachments.push_back(attachmentInfo);
+				}
+				pass.depthAttachment = {};
+				pass.depthAttachment.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+				if (hasDepth)
+				{
+					pass.depthAttachment.imageView = depthView;
+					pass.depthAttachment.imageLayout = depthAttachment.isReadOnly ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+					pass.depthAttachment.loadOp = depthAttachment.loadOp;
+					pass.depthAttachment.storeOp = depthAttachment.storeOp;
+					pass.depthAttachment.clearValue = depthClear;
+				}
+				continue;
+			}
+
+			// framebuffer order follows the render pass, unused resolve slots take no attachment
+			for (VkImageView view : resolveViews)
+			{
+				if (view != VK_NULL_HANDLE)
+				{
+					views.push_back(view);
+				}
+			}
+
+			pass.renderPass = GetRenderPass(colorAttachments, hasDepth ? &depthAttachment : nullptr, resolveAttachments);
+			pass.framebuffer = GetFramebuffer(pass.renderPass, views, extent);
+			pass.clearValues = std::move(colorClears);
+			if (hasDepth)
+			{
+				pass.clearValues.push_back(depthClear);
+			}
+		}
+	}
+
+	void RenderGraph::Execute(VkCommandBuffer commandBuffer, GpuProfiler *profiler)
+	{
+		RenderGraphPassContext context;
+		context.commandBuffer = commandBuffer;
+		context.graph = this;
+
+		for (Pass &pass : m_passes)
+		{
+			if (!pass.isAlive)
+			{
+				continue;
+			}
+			if (profiler)
+			{
+				profiler->BeginPass(commandBuffer, pass.name.c_str());
+			}
+
+			if (!pass.imageBarriers.empty() || !pass.bufferBarriers.empty())
+			{
+				_vkCmdPipelineBarrier(commandBuffer, pass.srcStages, pass.dstStages, 0, 0, nullptr,
+									  static_cast<uint32_t>(pass.bufferBarriers.size()), pass.bufferBarriers.data(),
+									  static_cast<uint32_t>(pass.imageBarriers.size()), pass.imageBarriers.data());
+			}
+			RecordBarriers2(commandBuffer, pass.imageBarriers2, pass.bufferBarriers2);
+
+			context.renderPass = pass.renderPass;
+			context.framebuffer = pass.framebuffer;
+			context.extent = pass.extent;
+			context.colorFormats = pass.colorFormats;
+			context.depthFormat = pass.depthFormat;
+			context.samples = pass.samples;
+			if (pass.isGraphics && m_isDynamicRenderingEnabled)
+			{
+				VkRenderingInfoKHR renderingInfo = {};
+				renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+				renderingInfo.flags = pass.isSecondaryContents ? VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT_KHR : 0;
+				renderingInfo.renderArea.offset = {0, 0};
+				renderingInfo.renderArea.extent = pass.extent;
+				renderingInfo.layerCount = 1;
+				renderingInfo.colorAttachmentCount = static_cast<uint32_t>(pass.colorAttachments.size());
+				renderingInfo.pColorAttachments = pass.colorAttachments.data();
+				bool hasDepth = pass.depthFormat != VK_FORMAT_UNDEFINED;
+				renderingInfo.pDepthAttachment = hasDepth && IsDepthFormat(pass.depthFormat) ? &pass.depthAttachment : nullptr;
+				renderingInfo.pStencilAttachment = hasDepth && HasStencil(pass.depthFormat) ? &pass.depthAttachment : nullptr;
+				_vkCmdBeginRenderingKHR(commandBuffer, &renderingInfo);
+				pass.execute(context);
+				_vkCmdEndRenderingKHR(commandBuffer);
+			}
+			else if (pass.renderPass != VK_NULL_HANDLE)
+			{
+				VkRenderPassBeginInfo renderPassInfo = {};
+				renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+				renderPassInfo.renderPass = pass.renderPass;
+				renderPassInfo.framebuffer = pass.framebuffer;
+				renderPassInfo.renderArea.offset = {0, 0};
+				renderPassInfo.renderArea.extent = pass.extent;
+				renderPassInfo.clearValueCount = static_cast<uint32_t>(pass.clearValues.size());
+				renderPassInfo.pClearValues = pass.clearValues.data();
+				_vkCmdBeginRenderPass(commandBuffer, &renderPassInfo,
+									  pass.isSecondaryContents ? VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS : VK_SUBPASS_CONTENTS_INLINE);
+				pass.execute(context);
+				_vkCmdEndRenderPass(commandBuffer);
+			}
+			else
+			{
+				pass.execute(context);
+			}
+
+			if (profiler)
+			{
+				profiler->EndPass(commandBuffer);
+			}
+		}
+
+		if (!m_finalBarriers.empty())
+		{
+			_vkCmdPipelineBarrier(commandBuffer, m_finalSrcStages, m_finalDstStages, 0, 0, nullptr, 0, nullptr,
+								  static_cast<uint32_t>(m_finalBarriers.size()), m_finalBarriers.data());
+		}
+		RecordBarriers2(commandBuffer, m_finalBarriers2, {});
+	}
+
+	void RenderGraph::RecordBarriers2(VkCommandBuffer commandBuffer, const std::vector<VkImageMemoryBarrier2KHR> &imageBarriers,
+									  const std::vector<VkBufferMemoryBarrier2KHR> &bufferBarriers) const
+	{
+		if (imageBarriers.empty() && bufferBarriers.empty())
+		{
+			return;
+		}
+		VkDependencyInfoKHR dependencyInfo = {};
+		dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+		dependencyInfo.bufferMemoryBarrierCount = static_cast<uint32_t>(bufferBarriers.size());
+		dependencyInfo.pBufferMemoryBarriers = bufferBarriers.data();
+		dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+		dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+		_vkCmdPipelineBarrier2KHR(commandBuffer, &dependencyInfo);
+	}
+
+	VkImage RenderGraph::GetImage(RenderGraphResource texture) const
+	{
+		return texture < m_resources.size() ? m_resources[texture].image : VK_NULL_HANDLE;
+	}
+
+	VkImageView RenderGraph::GetImageView(RenderGraphResource texture) const
+	{
+		return texture < m_resources.size() ? m_resources[texture].view : VK_NULL_HANDLE;
+	}
+
+	VkBuffer RenderGraph::GetBuffer(RenderGraphResource buffer) const
+	{
+		return buffer < m_resources.size() ? m_resources[buffer].buffer : VK_NULL_HANDLE;
+	}
+
+	VkRenderPass RenderGraph::GetRenderPass(const std::vector<RenderGraphAttachment> &colorAttachments, const RenderGraphAttachment *depthAttachment,
+											const std::vector<RenderGraphAttachment> &resolveAttachments)
+	{
+		std::vector<uint64_t> key;
+		auto appendKey = [&key](const RenderGraphAttachment &attachment)
+		{
+			key.push_back(static_cast<uint64_t>(attachment.format) | static_cast<uint64_t>(attachment.samples) << 32);
+			key.push_back(static_cast<uint64_t>(attachment.loadOp) | static_cast<uint64_t>(attachment.storeOp) << 16 |
+						  static_cast<uint64_t>(attachment.isReadOnly) << 48);
+		};
+		for (const RenderGraphAttachment &attachment : colorAttachments)
+		{
+			appendKey(attachment);
+		}
+		key.push_back(depthAttachment ? 1 : 0);
+		if (depthAttachment)
+		{
+			appendKey(*depthAttachment);
+		}
+		for (const RenderGraphAttachment &attachment : resolveAttachments)
+		{
+			appendKey(attachment);
+		}
+
+		auto it = m_renderPasses.find(key);
+		if (it != m_renderPasses.end())
+		{
+			return it->second;
+		}
+
+		// layouts stay the same through the pass, the graph transitions attachments with its own barriers
+		std::vector<VkAttachmentDescription> attachments;
+		std::vector<VkAttachmentReference> colorReferences;
+		for (const RenderGraphAttachment &attachment : colorAttachments)
+		{
+			VkAttachmentDescription description = {};
+			description.format = attachment.format;
+			description.samples = attachment.samples;
+			description.loadOp = attachment.loadOp;
+			description.storeOp = attachment.storeOp;
+			description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			description.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			description.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			colorReferences.push_back({static_cast<uint32_t>(attachments.size()), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+			attachments.push_back(description);
+		}
+
+		VkAttachmentReference depthReference = {};
+		if (depthAttachment)
+		{
+			VkImageLayout layout = depthAttachment->isReadOnly ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			VkAttachmentDescription description = {};
+			description.format = depthAttachment->format;
+			description.samples = depthAttachment->samples;
+			description.loadOp = depthAttachment->loadOp;
+			description.storeOp = depthAttachment->storeOp;
+			description.stencilLoadOp = HasStencil(depthAttachment->format) ? depthAttachment->loadOp : VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			description.stencilStoreOp = HasStencil(depthAttachment->format) ? depthAttachment->storeOp : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			description.initialLayout = layout;
+			description.finalLayout = layout;
+			depthReference = {static_cast<uint32_t>(attachments.size()), layout};
+			attachments.push_back(description);
+		}
+
+		std::vector<VkAttachmentReference> resolveReferences;
+		for (const RenderGraphAttachment &attachment : resolveAttachments)
+		{
+			if (attachment.format == VK_FORMAT_UNDEFINED)
+			{
+				resolveReferences.push_back({VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED});
+				continue;
+			}
+			VkAttachmentDescription description = {};
+			description.format = attachment.format;
+			description.samples = attachment.samples;
+			description.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			description.storeOp = attachment.storeOp;
+			description.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+			description.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+			description.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			description.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			resolveReferences.push_back({static_cast<uint32_t>(attachments.size()), VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL});
+			attachments.push_back(description);
+		}
+
+		VkSubpassDescription subpass = {};
+		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+		subpass.colorAttachmentCount = static_cast<uint32_t>(colorReferences.size());
+		subpass.pColorAttachments = colorReferences.data();
+		subpass.pResolveAttachments = resolveReferences.empty() ? nullptr : resolveReferences.data();
+		subpass.pDepthStencilAttachment = depthAttachment ? &depthReference : nullptr;
+
+		VkRenderPassCreateInfo renderPassInfo = {};
+		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+		renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+		renderPassInfo.pAttachments = attachments.data();
+		renderPassInfo.subpassCount = 1;
+		renderPassInfo.pSubpasses = &subpass;
+
+		VkRenderPass renderPass = VK_NULL_HANDLE;
+		if (vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create render pass!");
+		}
+		m_renderPasses.emplace(std::move(key), renderPass);
+		return renderPass;
+	}
+
+	VkFramebuffer RenderGraph::GetFramebuffer(VkRenderPass renderPass, const std::vector<VkImageView> &views, VkExtent2D extent)
+	{
+		std::vector<uint64_t> key;
+		key.reserve(views.size() + 2);
+		key.push_back(reinterpret_cast<uint64_t>(renderPass));
+		key.push_back(static_cast<uint64_t>(extent.width) | static_cast<uint64_t>(extent.height) << 32);
+		for (VkImageView view : views)
+		{
+			key.push_back(reinterpret_cast<uint64_t>(view));
+		}
+
+		auto it = m_framebuffers.find(key);
+		if (it != m_framebuffers.end())
+		{
+			return it->second;
+		}
+
+		VkFramebufferCreateInfo framebufferInfo = {};
+		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass = renderPass;
+		framebufferInfo.attachmentCount = static_cast<uint32_t>(views.size());
+		framebufferInfo.pAttachments = views.data();
+		framebufferInfo.width = extent.width;
+		framebufferInfo.height = extent.height;
+		framebufferInfo.layers = 1;
+
+		VkFramebuffer framebuffer = VK_NULL_HANDLE;
+		if (vkCreateFramebuffer(m_device, &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create framebuffer!");
+		}
+		m_framebuffers.emplace(std::move(key), framebuffer);
+		return framebuffer;
+	}
+
+	void RenderGraph::ReleaseFramebuffers()
+	{
+		if (m_framebuffers.empty())
+		{
+			return;
+		}
+		std::vector<VkFramebuffer> framebuffers;
+		for (auto &[key, framebuffer] : m_framebuffers)
+		{
+			framebuffers.push_back(framebuffer);
+		}
+		m_framebuffers.clear();
+		m_deferDestroy([this, framebuffers]()
+					   {
+						   for (VkFramebuffer framebuffer : framebuffers)
+						   {
+							   vkDestroyFramebuffer(m_device, framebuffer, nullptr);
+						   } });
+	}
+}
@@ -0,0 +1,325 @@
+#pragma once
+
+#include "source/rhi/vulkan_gpu_profiler.h"
+#include "source/rhi/vulkan_memory_allocator.h"
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <map>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace JMEngine
+{
+	// index of a texture or buffer declared in the current frame's graph
+	using RenderGraphResource = uint32_t;
+	constexpr RenderGraphResource k_invalidRenderGraphResource = UINT32_MAX;
+
+	enum class RenderGraphUsage : uint8_t
+	{
+		ColorAttachment,
+		// the single sample target a multisampled color attachment resolves into
+		ResolveAttachment,
+		DepthAttachment,
+		// depth test without depth writes
+		DepthRead,
+		Sampled,
+		StorageRead,
+		StorageWrite,
+		TransferSrc,
+		TransferDst,
+		UniformBuffer,
+		VertexBuffer,
+		IndexBuffer,
+		IndirectBuffer,
+	};
+
+	// one attachment of a render pass, the ops are baked into it while only format and samples
+	// decide which pipelines it is compatible with
+	struct RenderGraphAttachment
+	{
+		VkFormat format{VK_FORMAT_UNDEFINED};
+		VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+		VkAttachmentLoadOp loadOp{VK_ATTACHMENT_LOAD_OP_LOAD};
+		VkAttachmentStoreOp storeOp{VK_ATTACHMENT_STORE_OP_STORE};
+		bool isReadOnly{false};
+
+		bool operator==(const RenderGraphAttachment &other) const = default;
+	};
+
+	// created by the graph, memory is shared with other transients whose passes do not overlap
+	struct RenderGraphTextureDesc
+	{
+		VkFormat format{VK_FORMAT_UNDEFINED};
+		VkExtent2D extent{0, 0};
+		VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+
+		bool operator==(const RenderGraphTextureDesc &other) const = default;
+	};
+
+	// owned outside of the graph, the graph moves it from the initial state to finalLayout
+	struct RenderGraphImportedTexture
+	{
+		VkImage image{VK_NULL_HANDLE};
+		VkImageView view{VK_NULL_HANDLE};
+		VkFormat format{VK_FORMAT_UNDEFINED};
+		VkExtent2D extent{0, 0};
+		VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+		VkImageLayout initialLayout{VK_IMAGE_LAYOUT_UNDEFINED};
+		// the stage the image becomes available at, a swapchain image at the acquire semaphore's wait stage
+		VkPipelineStageFlags initialStage{VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT};
+		VkImageLayout finalLayout{VK_IMAGE_LAYOUT_UNDEFINED};
+		// the first use after the graph, the defaults suit presentation
+		VkPipelineStageFlags finalStage{VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT};
+		VkAccessFlags finalAccess{0};
+	};
+
+	struct RenderGraphStats
+	{
+		uint32_t passCount{0};
+		uint32_t culledPassCount{0};
+		uint32_t barrierBatchCount{0};
+		uint32_t imageBarrierCount{0};
+		uint32_t bufferBarrierCount{0};
+		uint32_t transientTextureCount{0};
+		// transients that never leave their pass, backed by lazily allocated memory where the device has it
+		uint32_t lazyTextureCount{0};
+		VkDeviceSize transientBytes{0};
+		// what the transients would take without aliasing
+		VkDeviceSize unaliasedTransientBytes{0};
+	};
+
+	class RenderGraph;
+
+	struct RenderGraphPassContext
+	{
+		VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+		// null outside of graphics passes, and always with dynamic rendering
+		VkRenderPass renderPass{VK_NULL_HANDLE};
+		VkFramebuffer framebuffer{VK_NULL_HANDLE};
+		VkExtent2D extent{0, 0};
+		// the attachments of graphics passes, what pipelines and secondary command buffers are built against
+		// when there is no render pass
+		std::span<const VkFormat> colorFormats;
+		VkFormat depthFormat{VK_FORMAT_UNDEFINED};
+		VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+		const RenderGraph *graph{nullptr};
+	};
+
+	using RenderGraphExecute = std::function<void(const RenderGraphPassContext &)>;
+
+	class RenderGraphPassBuilder final
+	{
+	public:
+		RenderGraphPassBuilder(RenderGraph &graph, uint32_t passIndex) : m_graph(graph), m_passIndex(passIndex) {}
+
+		// attachments are bound in the order they are declared
+		RenderGraphPassBuilder &WriteColor(RenderGraphResource texture, VkAttachmentLoadOp loadOp, VkClearColorValue clearValue = {});
+		RenderGraphPassBuilder &WriteDepth(RenderGraphResource texture, VkAttachmentLoadOp loadOp, VkClearDepthStencilValue clearValue = {});
+		RenderGraphPassBuilder &ReadDepth(RenderGraphResource texture);
+		// source must be a color attachment of the same pass
+		RenderGraphPassBuilder &ResolveColor(RenderGraphResource source, RenderGraphResource target);
+		// stages only matter for shader accesses, the other usages imply theirs
+		RenderGraphPassBuilder &Read(RenderGraphResource resource, RenderGraphUsage usage, VkPipelineStageFlags stages = 0);
+		RenderGraphPassBuilder &Write(RenderGraphResource resource, RenderGraphUsage usage, VkPipelineStageFlags stages = 0);
+		// never culled, for passes whose results leave the graph some other way
+		RenderGraphPassBuilder &SetSideEffect();
+		// the render pass is begun for vkCmdExecuteCommands instead of inline commands
+		RenderGraphPassBuilder &SetSecondaryContents();
+
+	private:
+		RenderGraph &m_graph;
+		uint32_t m_passIndex;
+	};
+
+	// rebuilt every frame: resources and passes are declared in execution order, Compile drops passes nothing
+	// depends on, places transient textures in shared memory and works out one barrier batch per pass,
+	// Execute records it all. render passes, framebuffers and transient textures persist between frames.
+	// attachments load only what an earlier pass wrote and store only what a later pass or the outside reads.
+	// with dynamic rendering, passes begin rendering straight on the views and barriers carry their own
+	// stages through synchronization2, no render pass or framebuffer is ever created
+	class RenderGraph final
+	{
+	public:
+		using DeferDestroyFunction = std::function<void(std::function<void()> &&)>;
+
+		// deferDestroy runs its argument once the frames in flight have completed, isDynamicRenderingEnabled needs
+		// VK_KHR_dynamic_rendering and VK_KHR_synchronization2 enabled on the device
+		void Initialize(VkDevice device, VulkanMemoryAllocator *memoryAllocator, bool isDynamicRenderingEnabled, DeferDestroyFunction &&deferDestroy);
+		// the device must be idle
+		void Clear();
+
+		// starts a new frame's declarations
+		void Reset();
+
+		// imported textures are the graph's outputs, passes that do not lead to one are culled
+		RenderGraphResource ImportTexture(const std::string &name, const RenderGraphImportedTexture &texture);
+		RenderGraphResource ImportBuffer(const std::string &name, VkBuffer buffer, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+		RenderGraphResource CreateTexture(const std::string &name, const RenderGraphTextureDesc &desc);
+
+		RenderGraphPassBuilder AddPass(const std::string &name, RenderGraphExecute &&execute);
+
+		void Compile();
+		// each pass is timed when profiler is given
+		void Execute(VkCommandBuffer commandBuffer, GpuProfiler *profiler = nullptr);
+
+		VkImage GetImage(RenderGraphResource texture) const;
+		VkImageView GetImageView(RenderGraphResource texture) const;
+		VkBuffer GetBuffer(RenderGraphResource buffer) const;
+		inline const RenderGraphStats &GetStats() const { return m_stats; }
+		inline bool IsDynamicRenderingEnabled() const { return m_isDynamicRenderingEnabled; }
+
+		// cached by content, also used to build pipelines ahead of the first frame, unused with dynamic rendering
+		// resolveAttachments is empty or has one entry per color attachment, VK_FORMAT_UNDEFINED where it does not resolve
+		VkRenderPass GetRenderPass(const std::vector<RenderGraphAttachment> &colorAttachments, const RenderGraphAttachment *depthAttachment = nullptr,
+								   const std::vector<RenderGraphAttachment> &resolveAttachments = {});
+		// for images that are about to be destroyed, the framebuffers are rebuilt on demand
+		void ReleaseFramebuffers();
+
+	private:
+		friend class RenderGraphPassBuilder;
+
+		struct ResourceAccess
+		{
+			RenderGraphResource resource{k_invalidRenderGraphResource};
+			RenderGraphUsage usage{RenderGraphUsage::Sampled};
+			VkPipelineStageFlags stages{0};
+			bool isWrite{false};
+			// attachments only, the ops are narrowed by Compile
+			VkAttachmentLoadOp loadOp{VK_ATTACHMENT_LOAD_OP_DONT_CARE};
+			VkAttachmentStoreOp storeOp{VK_ATTACHMENT_STORE_OP_STORE};
+			VkClearValue clearValue{};
+			RenderGraphResource resolveSource{k_invalidRenderGraphResource};
+		};
+
+		struct Pass
+		{
+			std::string name;
+			RenderGraphExecute execute;
+			std::vector<ResourceAccess> accesses;
+			bool hasSideEffect{false};
+			bool isSecondaryContents{false};
+			bool isAlive{false};
+
+			// filled by Compile
+			VkPipelineStageFlags srcStages{0};
+			VkPipelineStageFlags dstStages{0};
+			std::vector<VkImageMemoryBarrier> imageBarriers;
+			std::vector<VkBufferMemoryBarrier> bufferBarriers;
+			// with synchronization2, instead of the above
+			std::vector<VkImageMemoryBarrier2KHR> imageBarriers2;
+			std::vector<VkBufferMemoryBarrier2KHR> bufferBarriers2;
+			bool isGraphics{false};
+			VkRenderPass renderPass{VK_NULL_HANDLE};
+			VkFramebuffer framebuffer{VK_NULL_HANDLE};
+			VkExtent2D extent{0, 0};
+			std::vector<VkClearValue> clearValues;
+			// with dynamic rendering, instead of the render pass and framebuffer
+			std::vector<VkRenderingAttachmentInfoKHR> colorAttachments;
+			VkRenderingAttachmentInfoKHR depthAttachment{};
+			std::vector<VkFormat> colorFormats;
+			VkFormat depthFormat{VK_FORMAT_UNDEFINED};
+			VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+		};
+
+		// synchronization state of a resource while passes are walked in order
+		struct ResourceState
+		{
+			VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+			VkPipelineStageFlags writeStages{0};
+			VkAccessFlags writeAccess{0};
+			// stages that read since the last write, and stages the last write is visible to
+			VkPipelineStageFlags readStages{0};
+			VkPipelineStageFlags visibleStages{0};
+		};
+
+		struct Resource
+		{
+			std::string name;
+			bool isTexture{true};
+			bool isImported{false};
+			RenderGraphTextureDesc desc;
+			RenderGraphImportedTexture imported;
+			VkBuffer buffer{VK_NULL_HANDLE};
+			VkDeviceSize bufferOffset{0};
+			VkDeviceSize bufferSize{VK_WHOLE_SIZE};
+
+			// filled by Compile
+			VkImageUsageFlags usage{0};
+			uint32_t firstPass{UINT32_MAX};
+			uint32_t lastPass{0};
+			// the last pass that depends on the contents written before it
+			uint32_t lastReadPass{0};
+			uint32_t transientIndex{UINT32_MAX};
+			VkImage image{VK_NULL_HANDLE};
+			VkImageView view{VK_NULL_HANDLE};
+			ResourceState state;
+		};
+
+		// a transient texture as realized, kept while the graph's transients stay the same
+		struct TransientTexture
+		{
+			RenderGraphTextureDesc desc;
+			VkImageUsageFlags usage{0};
+			uint32_t memorySlot{0};
+			bool isLazy{false};
+			VkImage image{VK_NULL_HANDLE};
+			VkImageView view{VK_NULL_HANDLE};
+		};
+
+		// one allocation shared by transients with disjoint lifetimes, the last access is carried over
+		// frames so reusing the memory next frame waits for this frame's use of it
+		struct MemorySlot
+		{
+			VulkanAllocation allocation;
+			bool isLazy{false};
+			VkPipelineStageFlags lastStages{VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT};
+			VkAccessFlags lastAccess{0};
+		};
+
+		VkDevice m_device{nullptr};
+		VulkanMemoryAllocator *m_memoryAllocator{nullptr};
+		DeferDestroyFunction m_deferDestroy;
+		bool m_isLazyMemorySupported{false};
+		bool m_isDynamicRenderingEnabled{false};
+
+		std::vector<Resource> m_resources;
+		std::vector<Pass> m_passes;
+		// final transitions of imported textures
+		VkPipelineStageFlags m_finalSrcStages{0};
+		VkPipelineStageFlags m_finalDstStages{0};
+		std::vector<VkImageMemoryBarrier> m_finalBarriers;
+		std::vector<VkImageMemoryBarrier2KHR> m_finalBarriers2;
+
+		std::vector<TransientTexture> m_transients;
+		std::vector<MemorySlot> m_memorySlots;
+		// formats, extents, usages and lifetimes the transients were realized for
+		std::vector<uint64_t> m_transientSignature;
+		VkDeviceSize m_transientBytes{0};
+		VkDeviceSize m_unaliasedTransientBytes{0};
+		uint32_t m_lazyTextureCount{0};
+		std::map<std::vector<uint64_t>, VkRenderPass> m_renderPasses;
+		std::map<std::vector<uint64_t>, VkFramebuffer> m_framebuffers;
+		RenderGraphStats m_stats;
+
+		void CullPasses();
+		void ComputeLifetimes();
+		void ResolveAttachmentOps();
+		void RealizeTransients();
+		void DestroyTransients();
+		void ComputeBarriers();
+		void PrepareRenderPasses();
+		VkFramebuffer GetFramebuffer(VkRenderPass renderPass, const std::vector<VkImageView> &views, VkExtent2D extent);
+		void RecordBarriers2(VkCommandBuffer commandBuffer, const std::vector<VkImageMemoryBarrier2KHR> &imageBarriers,
+							 const std::vector<VkBufferMemoryBarrier2KHR> &bufferBarriers) const;
+
+		PFN_vkCmdPipelineBarrier _vkCmdPipelineBarrier;
+		PFN_vkCmdBeginRenderPass _vkCmdBeginRenderPass;
+		PFN_vkCmdEndRenderPass _vkCmdEndRenderPass;
+		PFN_vkCmdPipelineBarrier2KHR _vkCmdPipelineBarrier2KHR{nullptr};
+		PFN_vkCmdBeginRenderingKHR _vkCmdBeginRenderingKHR{nullptr};
+		PFN_vkCmdEndRenderingKHR _vkCmdEndRenderingKHR{nullptr};
+	};
+}
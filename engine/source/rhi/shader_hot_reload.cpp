@@ -0,0 +1,232 @@
+#include "source/rhi/shader_hot_reload.h"
+#include "source/global/macro.h"
+#include "source/global/profiler.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <set>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace JMEngine
+{
+	ShaderHotReloader::~ShaderHotReloader()
+	{
+		Clear();
+	}
+
+	bool ShaderHotReloader::Initialize(const std::string &sourceDirectory, const std::string &includeDirectory,
+									   const std::string &outputDirectory, const std::string &compilerPath)
+	{
+#ifdef __linux__
+		m_sourceDirectory = sourceDirectory;
+		m_includeDirectory = includeDirectory;
+		m_outputDirectory = outputDirectory;
+		m_compilerPath = compilerPath;
+
+		std::error_code error;
+		std::filesystem::create_directories(m_outputDirectory, error);
+
+		// modules left by an earlier run predate the embedded spir-v of the current build and would shadow it
+		for (const auto &file : std::filesystem::directory_iterator(m_outputDirectory, error))
+		{
+			if (file.path().extension() == ".spv")
+			{
+				std::filesystem::remove(file.path(), error);
+			}
+		}
+
+		m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (m_inotifyFd < 0)
+		{
+			LOG_WARN("failed to initialize inotify, shader hot reload is disabled");
+			return false;
+		}
+
+		// editors either rewrite in place or rename a temporary file over the original
+		const uint32_t mask = IN_CLOSE_WRITE | IN_MOVED_TO;
+		if (inotify_add_watch(m_inotifyFd, m_sourceDirectory.c_str(), mask) < 0)
+		{
+			LOG_WARN("failed to watch " + m_sourceDirectory + ", shader hot reload is disabled");
+			close(m_inotifyFd);
+			m_inotifyFd = -1;
+			return false;
+		}
+		if (std::filesystem::exists(m_includeDirectory))
+		{
+			inotify_add_watch(m_inotifyFd, m_includeDirectory.c_str(), mask);
+		}
+
+		m_isStopping = false;
+		m_thread = std::thread(&ShaderHotReloader::WatchLoop, this);
+		LOG_INFO("watching " + m_sourceDirectory + " for shader changes");
+		return true;
+#else
+		LOG_WARN("shader hot reload needs inotify and is only available on linux");
+		return false;
+#endif
+	}
+
+	void ShaderHotReloader::Clear()
+	{
+		m_isStopping = true;
+		if (m_thread.joinable())
+		{
+			m_thread.join();
+		}
+#ifdef __linux__
+		if (m_inotifyFd >= 0)
+		{
+			close(m_inotifyFd);
+			m_inotifyFd = -1;
+		}
+#endif
+	}
+
+	std::vector<std::string> ShaderHotReloader::PollCompiled()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		std::vector<std::string> compiled;
+		compiled.swap(m_compiled);
+		return compiled;
+	}
+
+	void ShaderHotReloader::WatchLoop()
+	{
+#ifdef __linux__
+		std::set<std::string> changed;
+		bool isIncludeChanged = false;
+		auto lastEvent = std::chrono::steady_clock::now();
+		alignas(inotify_event) std::array<char, 4096> buffer;
+
+		while (!m_isStopping)
+		{
+			// wake up regularly to notice Clear
+			pollfd descriptor = {m_inotifyFd, POLLIN, 0};
+			if (poll(&descriptor, 1, 50) > 0)
+			{
+				ssize_t length;
+				while ((length = read(m_inotifyFd, buffer.data(), buffer.size())) > 0)
+				{
+					for (ssize_t offset = 0; offset < length;)
+					{
+						const inotify_event *event = reinterpret_cast<const inotify_event *>(buffer.data() + offset);
+						offset += sizeof(inotify_event) + event->len;
+						if (event->len == 0)
+						{
+							continue;
+						}
+						std::string name = event->name;
+						if (IsShaderFile(name))
+						{
+							changed.insert(name);
+						}
+						else if (name.ends_with(".h") || name.ends_with(".glsl"))
+						{
+							isIncludeChanged = true;
+						}
+						lastEvent = std::chrono::steady_clock::now();
+					}
+				}
+				continue;
+			}
+
+			// an editor save is a burst of events, compile once it has settled
+			if ((changed.empty() && !isIncludeChanged) || std::chrono::steady_clock::now() - lastEvent < std::chrono::milliseconds(100))
+			{
+				continue;
+			}
+
+			// shaders do not list their includes, so an include change recompiles everything
+			if (isIncludeChanged)
+			{
+				std::error_code error;
+				for (const auto &entry : std::filesystem::directory_iterator(m_sourceDirectory, error))
+				{
+					std::string name = entry.path().filename().string();
+					if (IsShaderFile(name))
+					{
+						changed.insert(name);
+					}
+				}
+				isIncludeChanged = false;
+			}
+
+			for (const std::string &name : changed)
+			{
+				if (Compile(name))
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					if (std::find(m_compiled.begin(), m_compiled.end(), name) == m_compiled.end())
+					{
+						m_compiled.push_back(name);
+					}
+				}
+			}
+			changed.clear();
+		}
+#endif
+	}
+
+	bool ShaderHotReloader::Compile(const std::string &name)
+	{
+		PROFILE_FUNCTION();
+#ifdef __linux__
+		std::string source = m_sourceDirectory + "/" + name;
+		std::string output = m_outputDirectory + "/" + name + ".spv";
+		std::string temporary = output + ".tmp";
+		std::string command = "\"" + m_compilerPath + "\" -I\"" + m_includeDirectory + "\" -V100 -o \"" + temporary + "\" \"" + source + "\" 2>&1";
+
+		FILE *pipe = popen(command.c_str(), "r");
+		if (!pipe)
+		{
+			LOG_ERROR("failed to run " + m_compilerPath);
+			return false;
+		}
+		std::string log;
+		std::array<char, 256> line;
+		while (fgets(line.data(), static_cast<int>(line.size()), pipe))
+		{
+			log += line.data();
+		}
+		if (pclose(pipe) != 0)
+		{
+			LOG_ERROR("failed to compile " + name + ":\n" + log);
+			return false;
+		}
+
+		// the renderer never sees a half written module
+		std::error_code error;
+		std::filesystem::rename(temporary, output, error);
+		if (error)
+		{
+			LOG_ERROR("failed to move " + temporary + ": " + error.message());
+			return false;
+		}
+		LOG_INFO("recompiled " + name);
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	bool ShaderHotReloader::IsShaderFile(const std::string &name)
+	{
+		static const char *k_extensions[] = {".vert", ".frag", ".comp", ".geom", ".tesc", ".tese", ".mesh", ".task"};
+		for (const char *extension : k_extensions)
+		{
+			if (name.ends_with(extension))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace JMEngine
+{
+	// development only, watches the glsl sources with inotify and recompiles changed shaders into
+	// outputDirectory on a background thread, the render thread collects finished names once a frame
+	class ShaderHotReloader final
+	{
+	public:
+		~ShaderHotReloader();
+		// returns false where file watching is unsupported, .spv files already in outputDirectory are deleted
+		bool Initialize(const std::string &sourceDirectory, const std::string &includeDirectory,
+						const std::string &outputDirectory, const std::string &compilerPath);
+		void Clear();
+
+		// shader names as in "test.vert" whose <outputDirectory>/<name>.spv has been rewritten since the last call
+		std::vector<std::string> PollCompiled();
+
+	private:
+		std::string m_sourceDirectory;
+		std::string m_includeDirectory;
+		std::string m_outputDirectory;
+		std::string m_compilerPath;
+
+		std::thread m_thread;
+		std::atomic<bool> m_isStopping{false};
+		int m_inotifyFd{-1};
+
+		std::mutex m_mutex;
+		std::vector<std::string> m_compiled;
+
+		void WatchLoop();
+		bool Compile(const std::string &name);
+		static bool IsShaderFile(const std::string &name);
+	};
+}
@@ -0,0 +1,58 @@
+#include "source/rhi/shader_library.h"
+#include "source/global/macro.h"
+#include "source/global/profiler.h"
+
+#include "shader/generated/cpp/shader_registry.h"
+
+#include <cstring>
+#include <filesystem>
+#include <string_view>
+
+namespace JMEngine
+{
+	void ShaderLibrary::Initialize(const std::string &overrideDirectory)
+	{
+		m_overrideDirectory = overrideDirectory;
+	}
+
+	void ShaderLibrary::Clear()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_overrides.clear();
+	}
+
+	std::span<const uint32_t> ShaderLibrary::Load(const std::string &name)
+	{
+		PROFILE_FUNCTION();
+		if (!m_overrideDirectory.empty())
+		{
+			std::string path = m_overrideDirectory + "/" + name + ".spv";
+			if (std::filesystem::exists(path))
+			{
+				std::vector<char> code = AssetManager::ReadFile(path);
+				if (!code.empty() && code.size() % sizeof(uint32_t) == 0)
+				{
+					std::vector<uint32_t> words(code.size() / sizeof(uint32_t));
+					memcpy(words.data(), code.data(), code.size());
+
+					std::lock_guard<std::mutex> lock(m_mutex);
+					std::vector<uint32_t> &storage = m_overrides.emplace_back(std::move(words));
+					LOG_INFO("shader overridden from " + path);
+					return storage;
+				}
+				LOG_WARN("ignoring malformed shader override: " + path);
+			}
+		}
+
+		for (const EmbeddedShader &shader : EMBEDDED_SHADERS)
+		{
+			if (std::string_view(shader.name) == name)
+			{
+				return {shader.words, shader.wordCount};
+			}
+		}
+
+		LOG_ERROR("unknown shader: " + name);
+		return {};
+	}
+}
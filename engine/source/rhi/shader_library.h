@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace JMEngine
+{
+	// spir-v compiled into the binary by the shader build step, looked up by glsl file name
+	// without touching the disk, a development override directory may shadow single shaders
+	class ShaderLibrary final
+	{
+	public:
+		// <overrideDirectory>/<name>.spv replaces the embedded module when it exists, empty disables overrides
+		void Initialize(const std::string &overrideDirectory);
+		void Clear();
+
+		// name as in "test.vert", empty when the shader is unknown,
+		// embedded words live for the whole program, overrides until Clear, even after a reload of the same name
+		std::span<const uint32_t> Load(const std::string &name);
+
+	private:
+		std::string m_overrideDirectory;
+		std::mutex m_mutex;
+		// every override ever loaded, reloads append so spans handed out earlier stay valid
+		std::deque<std::vector<uint32_t>> m_overrides;
+	};
+}
@@ -0,0 +1,550 @@
+#include "source/rhi/spirv_reflection.h"
+#include "source/global/macro.h"
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace JMEngine
+{
+	namespace
+	{
+		constexpr uint32_t k_spirvMagic = 0x07230203;
+
+		// the subset of the spir-v grammar the interface depends on
+		enum SpirvOp : uint32_t
+		{
+			OpEntryPoint = 15,
+			OpTypeBool = 20,
+			OpTypeInt = 21,
+			OpTypeFloat = 22,
+			OpTypeVector = 23,
+			OpTypeMatrix = 24,
+			OpTypeImage = 25,
+			OpTypeSampler = 26,
+			OpTypeSampledImage = 27,
+			OpTypeArray = 28,
+			OpTypeRuntimeArray = 29,
+			OpTypeStruct = 30,
+			OpTypePointer = 32,
+			OpConstant = 43,
+			OpSpecConstantTrue = 48,
+			OpSpecConstantFalse = 49,
+			OpSpecConstant = 50,
+			OpVariable = 59,
+			OpDecorate = 71,
+			OpMemberDecorate = 72,
+			OpTypeAccelerationStructureKHR = 5341,
+		};
+
+		enum SpirvDecoration : uint32_t
+		{
+			DecorationSpecId = 1,
+			DecorationBlock = 2,
+			DecorationBufferBlock = 3,
+			DecorationArrayStride = 6,
+			DecorationMatrixStride = 7,
+			DecorationBuiltIn = 11,
+			DecorationLocation = 30,
+			DecorationBinding = 33,
+			DecorationDescriptorSet = 34,
+			DecorationOffset = 35,
+		};
+
+		enum SpirvStorageClass : uint32_t
+		{
+			StorageClassUniformConstant = 0,
+			StorageClassInput = 1,
+			StorageClassUniform = 2,
+			StorageClassPushConstant = 9,
+			StorageClassStorageBuffer = 12,
+		};
+
+		enum SpirvDim : uint32_t
+		{
+			DimBuffer = 5,
+			DimSubpassData = 6,
+		};
+
+		struct SpirvId
+		{
+			uint32_t opcode{0};
+			// type operands, meaning depends on opcode
+			uint32_t typeId{0};
+			uint32_t width{0};
+			uint32_t count{0};
+			uint32_t storageClass{0};
+			uint32_t dim{0};
+			uint32_t sampled{0};
+			uint32_t constantValue{0};
+			bool isSigned{false};
+			std::vector<uint32_t> members;
+
+			uint32_t set{0};
+			uint32_t binding{0};
+			uint32_t location{0};
+			uint32_t specId{0};
+			uint32_t arrayStride{0};
+			bool hasBinding{false};
+			bool hasLocation{false};
+			bool hasSpecId{false};
+			bool isBlock{false};
+			bool isBufferBlock{false};
+			bool isBuiltIn{false};
+
+			// per struct member
+			std::vector<uint32_t> memberOffsets;
+			std::vector<uint32_t> memberMatrixStrides;
+			bool hasBuiltInMember{false};
+		};
+
+		VkShaderStageFlagBits ToShaderStage(uint32_t executionModel)
+		{
+			switch (executionModel)
+			{
+			case 0:
+				return VK_SHADER_STAGE_VERTEX_BIT;
+			case 1:
+				return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+			case 2:
+				return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+			case 3:
+				return VK_SHADER_STAGE_GEOMETRY_BIT;
+			case 4:
+				return VK_SHADER_STAGE_FRAGMENT_BIT;
+			case 5:
+				return VK_SHADER_STAGE_COMPUTE_BIT;
+			default:
+				return VK_SHADER_STAGE_ALL;
+			}
+		}
+
+		class SpirvParser
+		{
+		public:
+			SpirvParser(const uint32_t *words, size_t wordCount) : m_words(words), m_wordCount(wordCount) {}
+
+			bool Parse(ShaderReflection &reflection)
+			{
+				if (m_wordCount < 5 || m_words[0] != k_spirvMagic)
+				{
+					LOG_ERROR("invalid spir-v module");
+					return false;
+				}
+				m_ids.resize(m_words[3]);
+
+				size_t cursor = 5;
+				while (cursor < m_wordCount)
+				{
+					uint32_t wordCount = m_words[cursor] >> 16;
+					uint32_t opcode = m_words[cursor] & 0xffff;
+					if (wordCount == 0 || cursor + wordCount > m_wordCount)
+					{
+						LOG_ERROR("truncated spir-v instruction");
+						return false;
+					}
+					if (!ParseInstruction(opcode, m_words + cursor + 1, wordCount - 1, reflection))
+					{
+						return false;
+					}
+					cursor += wordCount;
+				}
+
+				CollectVariables(reflection);
+				return true;
+			}
+
+		private:
+			const uint32_t *m_words;
+			size_t m_wordCount;
+			std::vector<SpirvId> m_ids;
+			std::vector<uint32_t> m_variables;
+
+			SpirvId *Id(uint32_t id) { return id < m_ids.size() ? &m_ids[id] : nullptr; }
+
+			bool ParseInstruction(uint32_t opcode, const uint32_t *operands, uint32_t operandCount, ShaderReflection &reflection)
+			{
+				// every opcode below carries at least its result or target id
+				if (operandCount == 0)
+				{
+					return true;
+				}
+
+				switch (opcode)
+				{
+				case OpEntryPoint:
+					reflection.stage = ToShaderStage(operands[0]);
+					break;
+				case OpTypeBool:
+				case OpTypeSampler:
+				case OpTypeAccelerationStructureKHR:
+					if (SpirvId *id = Id(operands[0]))
+					{
+						id->opcode = opcode;
+						id->width = 32;
+					}
+					break;
+				case OpTypeInt:
+				case OpTypeFloat:
+					if (SpirvId *id = Id(operands[0]); id && operandCount >= 2)
+					{
+						id->opcode = opcode;
+						id->width = operands[1];
+						id->isSigned = opcode == OpTypeInt && operandCount >= 3 && operands[2] != 0;
+					}
+					break;
+				case OpTypeVector:
+				case OpTypeMatrix:
+				case OpTypeSampledImage:
+				case OpTypeRuntimeArray:
+					if (SpirvId *id = Id(operands[0]); id && operandCount >= 2)
+					{
+						id->opcode = opcode;
+						id->typeId = operands[1];
+						id->count = operandCount >= 3 ? operands[2] : 0;
+					}
+					break;
+				case OpTypeImage:
+					if (SpirvId *id = Id(operands[0]); id && operandCount >= 7)
+					{
+						id->opcode = opcode;
+						id->typeId = operands[1];
+						id->dim = operands[2];
+						id->sampled = operands[6];
+					}
+					break;
+				case OpTypeArray:
+					if (SpirvId *id = Id(operands[0]); id && operandCount >= 3)
+					{
+						id->opcode = opcode;
+						id->typeId = operands[1];
+						// the length is a constant id, resolved once every constant is known
+						id->count = operands[2];
+					}
+					break;
+				case OpTypeStruct:
+					if (SpirvId *id = Id(operands[0]))
+					{
+						id->opcode = opcode;
+						id->members.assign(operands + 1, operands + operandCount);
+					}
+					break;
+				case OpTypePointer:
+					if (SpirvId *id = Id(operands[0]); id && operandCount >= 3)
+					{
+						id->opcode = opcode;
+						id->storageClass = operands[1];
+						id->typeId = operands[2];
+					}
+					break;
+				case OpConstant:
+				case OpSpecConstant:
+				case OpSpecConstantTrue:
+				case OpSpecConstantFalse:
+					if (SpirvId *id = Id(operandCount >= 2 ? operands[1] : 0); id && operandCount >= 2)
+					{
+						id->opcode = opcode;
+						id->typeId = operands[0];
+						id->constantValue = operandCount >= 3 ? operands[2] : (opcode == OpSpecConstantTrue ? 1 : 0);
+					}
+					break;
+				case OpVariable:
+					if (SpirvId *id = Id(operandCount >= 2 ? operands[1] : 0); id && operandCount >= 3)
+					{
+						id->opcode = opcode;
+						id->typeId = operands[0];
+						id->storageClass = operands[2];
+						m_variables.push_back(operands[1]);
+					}
+					break;
+				case OpDecorate:
+					if (SpirvId *id = Id(operands[0]); id && operandCount >= 2)
+					{
+						Decorate(*id, operands[1], operandCount >= 3 ? operands[2] : 0);
+					}
+					break;
+				case OpMemberDecorate:
+					if (SpirvId *id = Id(operands[0]); id && operandCount >= 3)
+					{
+						MemberDecorate(*id, operands[1], operands[2], operandCount >= 4 ? operands[3] : 0);
+					}
+					break;
+				default:
+					break;
+				}
+				return true;
+			}
+
+			void Decorate(SpirvId &id, uint32_t decoration, uint32_t value)
+			{
+				switch (decoration)
+				{
+				case DecorationSpecId:
+					id.specId = value;
+					id.hasSpecId = true;
+					break;
+				case DecorationBlock:
+					id.isBlock = true;
+					break;
+				case DecorationBufferBlock:
+					id.isBufferBlock = true;
+					break;
+				case DecorationArrayStride:
+					id.arrayStride = value;
+					break;
+				case DecorationBuiltIn:
+					id.isBuiltIn = true;
+					break;
+				case DecorationLocation:
+					id.location = value;
+					id.hasLocation = true;
+					break;
+				case DecorationBinding:
+					id.binding = value;
+					id.hasBinding = true;
+					break;
+				case DecorationDescriptorSet:
+					id.set = value;
+					break;
+				default:
+					break;
+				}
+			}
+
+			void MemberDecorate(SpirvId &id, uint32_t member, uint32_t decoration, uint32_t value)
+			{
+				if (decoration == DecorationBuiltIn)
+				{
+					id.hasBuiltInMember = true;
+					return;
+				}
+				if (decoration != DecorationOffset && decoration != DecorationMatrixStride)
+				{
+					return;
+				}
+				std::vector<uint32_t> &values = decoration == DecorationOffset ? id.memberOffsets : id.memberMatrixStrides;
+				if (values.size() <= member)
+				{
+					values.resize(member + 1, 0);
+				}
+				values[member] = value;
+			}
+
+			uint32_t ArrayLength(const SpirvId &array)
+			{
+				SpirvId *length = Id(array.count);
+				return length && length->opcode != 0 ? length->constantValue : 1;
+			}
+
+			// byte size of a type laid out with explicit offsets and strides
+			uint32_t TypeSize(uint32_t typeId, uint32_t matrixStride = 0)
+			{
+				SpirvId *type = Id(typeId);
+				if (!type)
+				{
+					return 0;
+				}
+				switch (type->opcode)
+				{
+				case OpTypeBool:
+				case OpTypeInt:
+				case OpTypeFloat:
+					return type->width / 8;
+				case OpTypeVector:
+					return TypeSize(type->typeId) * type->count;
+				case OpTypeMatrix:
+					return matrixStride != 0 ? matrixStride * type->count : TypeSize(type->typeId) * type->count;
+				case OpTypeArray:
+				{
+					uint32_t stride = type->arrayStride != 0 ? type->arrayStride : TypeSize(type->typeId, matrixStride);
+					return stride * ArrayLength(*type);
+				}
+				case OpTypeStruct:
+				{
+					uint32_t size = 0;
+					for (size_t i = 0; i < type->members.size(); i++)
+					{
+						uint32_t offset = i < type->memberOffsets.size() ? type->memberOffsets[i] : size;
+						uint32_t stride = i < type->memberMatrixStrides.size() ? type->memberMatrixStrides[i] : 0;
+						size = std::max(size, offset + TypeSize(type->members[i], stride));
+					}
+					return size;
+				}
+				default:
+					return 0;
+				}
+			}
+
+			VkFormat VertexFormat(uint32_t typeId)
+			{
+				SpirvId *type = Id(typeId);
+				if (!type)
+				{
+					return VK_FORMAT_UNDEFINED;
+				}
+				uint32_t componentCount = 1;
+				if (type->opcode == OpTypeVector)
+				{
+					componentCount = type->count;
+					type = Id(type->typeId);
+				}
+				if (!type || componentCount < 1 || componentCount > 4)
+				{
+					return VK_FORMAT_UNDEFINED;
+				}
+
+				static const VkFormat k_float32[] = {VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT};
+				static const VkFormat k_float64[] = {VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT};
+				static const VkFormat k_sint32[] = {VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT};
+				static const VkFormat k_uint32[] = {VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT};
+				if (type->opcode == OpTypeFloat && type->width == 32)
+				{
+					return k_float32[componentCount - 1];
+				}
+				if (type->opcode == OpTypeFloat && type->width == 64)
+				{
+					return k_float64[componentCount - 1];
+				}
+				if (type->opcode == OpTypeInt && type->width == 32)
+				{
+					return type->isSigned ? k_sint32[componentCount - 1] : k_uint32[componentCount - 1];
+				}
+				return VK_FORMAT_UNDEFINED;
+			}
+
+			VkDescriptorType DescriptorType(const SpirvId &type, uint32_t storageClass)
+			{
+				if (storageClass == StorageClassStorageBuffer)
+				{
+					return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+				}
+				if (storageClass == StorageClassUniform)
+				{
+					return type.isBufferBlock ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+				}
+
+				switch (type.opcode)
+				{
+				case OpTypeSampler:
+					return VK_DESCRIPTOR_TYPE_SAMPLER;
+				case OpTypeSampledImage:
+				{
+					SpirvId *image = Id(type.typeId);
+					return image && image->dim == DimBuffer ? VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+				}
+				case OpTypeImage:
+					if (type.dim == DimSubpassData)
+					{
+						return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+					}
+					if (type.dim == DimBuffer)
+					{
+						return type.sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+					}
+					return type.sampled == 2 ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+				case OpTypeAccelerationStructureKHR:
+					return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+				default:
+					return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+				}
+			}
+
+			void CollectVariables(ShaderReflection &reflection)
+			{
+				for (uint32_t variableId : m_variables)
+				{
+					SpirvId &variable = m_ids[variableId];
+					SpirvId *pointer = Id(variable.typeId);
+					SpirvId *type = pointer ? Id(pointer->typeId) : nullptr;
+					if (!type)
+					{
+						continue;
+					}
+
+					switch (variable.storageClass)
+					{
+					case StorageClassUniformConstant:
+					case StorageClassUniform:
+					case StorageClassStorageBuffer:
+					{
+						if (!variable.hasBinding)
+						{
+							break;
+						}
+						ShaderResourceBinding binding;
+						binding.set = variable.set;
+						binding.binding = variable.binding;
+						binding.stages = reflection.stage;
+						// arrays of resources take one descriptor per element
+						while (type && (type->opcode == OpTypeArray || type->opcode == OpTypeRuntimeArray))
+						{
+							binding.count *= type->opcode == OpTypeArray ? ArrayLength(*type) : 0;
+							type = Id(type->typeId);
+						}
+						if (!type)
+						{
+							break;
+						}
+						binding.type = DescriptorType(*type, variable.storageClass);
+						if (binding.type == VK_DESCRIPTOR_TYPE_MAX_ENUM)
+						{
+							LOG_WARN("unsupported descriptor type at set " + std::to_string(binding.set) + " binding " + std::to_string(binding.binding));
+							break;
+						}
+						reflection.bindings.push_back(binding);
+						break;
+					}
+					case StorageClassPushConstant:
+					{
+						VkPushConstantRange range = {};
+						range.stageFlags = reflection.stage;
+						range.offset = type->memberOffsets.empty() ? 0 : *std::min_element(type->memberOffsets.begin(), type->memberOffsets.end());
+						range.size = TypeSize(pointer->typeId) - range.offset;
+						reflection.pushConstantRanges.push_back(range);
+						break;
+					}
+					case StorageClassInput:
+					{
+						if (reflection.stage != VK_SHADER_STAGE_VERTEX_BIT || variable.isBuiltIn || type->hasBuiltInMember || !variable.hasLocation)
+						{
+							break;
+						}
+						reflection.vertexInputs.push_back({variable.location, VertexFormat(pointer->typeId)});
+						break;
+					}
+					default:
+						break;
+					}
+				}
+
+				for (SpirvId &id : m_ids)
+				{
+					if (id.hasSpecId && (id.opcode == OpSpecConstant || id.opcode == OpSpecConstantTrue || id.opcode == OpSpecConstantFalse))
+					{
+						// spec constant bools are passed as VkBool32
+						uint32_t size = id.opcode == OpSpecConstant ? TypeSize(id.typeId) : 4;
+						SpirvId *type = Id(id.typeId);
+						if (type && type->opcode == OpTypeBool)
+						{
+							size = 4;
+						}
+						reflection.specializationConstants.push_back({id.specId, size});
+					}
+				}
+
+				std::sort(reflection.bindings.begin(), reflection.bindings.end(), [](const ShaderResourceBinding &a, const ShaderResourceBinding &b)
+						  { return a.set != b.set ? a.set < b.set : a.binding < b.binding; });
+				std::sort(reflection.vertexInputs.begin(), reflection.vertexInputs.end(), [](const ShaderVertexInput &a, const ShaderVertexInput &b)
+						  { return a.location < b.location; });
+				std::sort(reflection.specializationConstants.begin(), reflection.specializationConstants.end(), [](const ShaderSpecializationConstant &a, const ShaderSpecializationConstant &b)
+						  { return a.constantId < b.constantId; });
+			}
+		};
+	}
+
+	bool SpirvReflection::Reflect(std::span<const uint32_t> words, ShaderReflection &reflection)
+	{
+		reflection = ShaderReflection{};
+		SpirvParser parser(words.data(), words.size());
+		return parser.Parse(reflection);
+	}
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <span>
+#include <vector>
+
+namespace JMEngine
+{
+	struct ShaderResourceBinding
+	{
+		uint32_t set{0};
+		uint32_t binding{0};
+		VkDescriptorType type{VK_DESCRIPTOR_TYPE_MAX_ENUM};
+		// 0 for runtime sized arrays
+		uint32_t count{1};
+		VkShaderStageFlags stages{0};
+	};
+
+	struct ShaderVertexInput
+	{
+		uint32_t location{0};
+		VkFormat format{VK_FORMAT_UNDEFINED};
+	};
+
+	struct ShaderSpecializationConstant
+	{
+		uint32_t constantId{0};
+		// bools occupy 4 bytes like VkBool32
+		uint32_t size{0};
+	};
+
+	struct ShaderReflection
+	{
+		VkShaderStageFlagBits stage{VK_SHADER_STAGE_ALL};
+		std::vector<ShaderResourceBinding> bindings;
+		std::vector<VkPushConstantRange> pushConstantRanges;
+		// vertex shaders only, built-ins excluded
+		std::vector<ShaderVertexInput> vertexInputs;
+		std::vector<ShaderSpecializationConstant> specializationConstants;
+	};
+
+	// reads the interface of a spir-v module straight from its words, the module must have a single entry point
+	class SpirvReflection final
+	{
+	public:
+		static bool Reflect(std::span<const uint32_t> words, ShaderReflection &reflection);
+	};
+}
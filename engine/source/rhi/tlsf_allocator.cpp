@@ -0,0 +1,274 @@
+#include "source/rhi/tlsf_allocator.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace JMEngine
+{
+	void TlsfAllocator::Initialize(uint64_t size)
+	{
+		Clear();
+		m_size = size;
+
+		uint32_t blockIndex = NewBlock();
+		m_blocks[blockIndex].offset = 0;
+		m_blocks[blockIndex].size = size;
+		InsertFreeBlock(blockIndex);
+	}
+
+	void TlsfAllocator::Clear()
+	{
+		m_size = 0;
+		m_usedSize = 0;
+		m_allocationCount = 0;
+		m_blocks.clear();
+		m_unusedBlocks.clear();
+		m_firstLevelMap = 0;
+		std::fill(std::begin(m_secondLevelMaps), std::end(m_secondLevelMaps), 0u);
+		for (auto &heads : m_freeHeads)
+		{
+			std::fill(std::begin(heads), std::end(heads), k_invalidHandle);
+		}
+	}
+
+	uint32_t TlsfAllocator::Allocate(uint64_t size, uint64_t alignment, uint64_t &offset)
+	{
+		if (size == 0)
+		{
+			size = 1;
+		}
+		alignment = std::max<uint64_t>(alignment, 1);
+
+		// worst case padding, so any block found is guaranteed to fit once aligned
+		uint32_t blockIndex = FindFreeBlock(size + alignment - 1);
+		if (blockIndex == k_invalidHandle)
+		{
+			return k_invalidHandle;
+		}
+		RemoveFreeBlock(blockIndex);
+
+		Block block = m_blocks[blockIndex];
+		uint64_t alignedOffset = (block.offset + alignment - 1) / alignment * alignment;
+		uint64_t padding = alignedOffset - block.offset;
+
+		// give the padding in front back as its own free block
+		if (padding > 0)
+		{
+			uint32_t paddingIndex = NewBlock();
+			Block &paddingBlock = m_blocks[paddingIndex];
+			paddingBlock.offset = block.offset;
+			paddingBlock.size = padding;
+			paddingBlock.prevPhysical = block.prevPhysical;
+			paddingBlock.nextPhysical = blockIndex;
+			if (block.prevPhysical != k_invalidHandle)
+			{
+				m_blocks[block.prevPhysical].nextPhysical = paddingIndex;
+			}
+
+			Block &alignedBlock = m_blocks[blockIndex];
+			alignedBlock.prevPhysical = paddingIndex;
+			alignedBlock.offset = alignedOffset;
+			alignedBlock.size -= padding;
+			InsertFreeBlock(paddingIndex);
+		}
+
+		// and the tail behind
+		if (m_blocks[blockIndex].size > size)
+		{
+			uint32_t tailIndex = NewBlock();
+			Block &tailBlock = m_blocks[tailIndex];
+			Block &usedBlock = m_blocks[blockIndex];
+			tailBlock.offset = alignedOffset + size;
+			tailBlock.size = usedBlock.size - size;
+			tailBlock.prevPhysical = blockIndex;
+			tailBlock.nextPhysical = usedBlock.nextPhysical;
+			if (usedBlock.nextPhysical != k_invalidHandle)
+			{
+				m_blocks[usedBlock.nextPhysical].prevPhysical = tailIndex;
+			}
+			usedBlock.nextPhysical = tailIndex;
+			usedBlock.size = size;
+			InsertFreeBlock(tailIndex);
+		}
+
+		m_blocks[blockIndex].isFree = false;
+		m_usedSize += size;
+		m_allocationCount++;
+		offset = alignedOffset;
+		return blockIndex;
+	}
+
+	void TlsfAllocator::Free(uint32_t handle)
+	{
+		Block &block = m_blocks[handle];
+		m_usedSize -= block.size;
+		m_allocationCount--;
+
+		uint32_t blockIndex = handle;
+		if (block.nextPhysical != k_invalidHandle && m_blocks[block.nextPhysical].isFree)
+		{
+			RemoveFreeBlock(block.nextPhysical);
+			MergeWithNext(blockIndex);
+		}
+		uint32_t prevIndex = m_blocks[blockIndex].prevPhysical;
+		if (prevIndex != k_invalidHandle && m_blocks[prevIndex].isFree)
+		{
+			RemoveFreeBlock(prevIndex);
+			MergeWithNext(prevIndex);
+			blockIndex = prevIndex;
+		}
+		InsertFreeBlock(blockIndex);
+	}
+
+	uint64_t TlsfAllocator::GetLargestFreeRange() const
+	{
+		if (m_firstLevelMap == 0)
+		{
+			return 0;
+		}
+
+		// the largest block lives in the highest non-empty list
+		uint32_t firstLevel = 63 - std::countl_zero(m_firstLevelMap);
+		uint32_t secondLevel = 31 - std::countl_zero(m_secondLevelMaps[firstLevel]);
+
+		uint64_t largest = 0;
+		for (uint32_t blockIndex = m_freeHeads[firstLevel][secondLevel]; blockIndex != k_invalidHandle; blockIndex = m_blocks[blockIndex].nextFree)
+		{
+			largest = std::max(largest, m_blocks[blockIndex].size);
+		}
+		return largest;
+	}
+
+	void TlsfAllocator::Mapping(uint64_t size, uint32_t &firstLevel, uint32_t &secondLevel)
+	{
+		if (size < k_secondLevelCount)
+		{
+			firstLevel = 0;
+			secondLevel = static_cast<uint32_t>(size);
+			return;
+		}
+
+		uint32_t highestBit = 63 - std::countl_zero(size);
+		secondLevel = static_cast<uint32_t>(size >> (highestBit - k_secondLevelLog2)) ^ k_secondLevelCount;
+		firstLevel = highestBit - k_secondLevelLog2 + 1;
+	}
+
+	uint32_t TlsfAllocator::FindFreeBlock(uint64_t size) const
+	{
+		// round up to the next list so every block in it is large enough
+		if (size >= k_secondLevelCount)
+		{
+			uint32_t highestBit = 63 - std::countl_zero(size);
+			uint64_t roundUp = (uint64_t(1) << (highestBit - k_secondLevelLog2)) - 1;
+			if (size > UINT64_MAX - roundUp)
+			{
+				return k_invalidHandle;
+			}
+			size += roundUp;
+		}
+
+		uint32_t firstLevel, secondLevel;
+		Mapping(size, firstLevel, secondLevel);
+		if (firstLevel >= k_firstLevelCount)
+		{
+			return k_invalidHandle;
+		}
+
+		uint32_t secondLevelMap = secondLevel < 32 ? m_secondLevelMaps[firstLevel] & (~0u << secondLevel) : 0;
+		if (secondLevelMap == 0)
+		{
+			uint64_t firstLevelMap = firstLevel + 1 < 64 ? m_firstLevelMap & (~uint64_t(0) << (firstLevel + 1)) : 0;
+			if (firstLevelMap == 0)
+			{
+				return k_invalidHandle;
+			}
+			firstLevel = std::countr_zero(firstLevelMap);
+			secondLevelMap = m_secondLevelMaps[firstLevel];
+		}
+		secondLevel = std::countr_zero(secondLevelMap);
+
+		return m_freeHeads[firstLevel][secondLevel];
+	}
+
+	uint32_t TlsfAllocator::NewBlock()
+	{
+		if (!m_unusedBlocks.empty())
+		{
+			uint32_t blockIndex = m_unusedBlocks.back();
+			m_unusedBlocks.pop_back();
+			m_blocks[blockIndex] = Block{};
+			return blockIndex;
+		}
+
+		m_blocks.emplace_back();
+		return static_cast<uint32_t>(m_blocks.size() - 1);
+	}
+
+	void TlsfAllocator::InsertFreeBlock(uint32_t blockIndex)
+	{
+		Block &block = m_blocks[blockIndex];
+		uint32_t firstLevel, secondLevel;
+		Mapping(block.size, firstLevel, secondLevel);
+
+		uint32_t &head = m_freeHeads[firstLevel][secondLevel];
+		block.isFree = true;
+		block.prevFree = k_invalidHandle;
+		block.nextFree = head;
+		if (head != k_invalidHandle)
+		{
+			m_blocks[head].prevFree = blockIndex;
+		}
+		head = blockIndex;
+
+		m_firstLevelMap |= uint64_t(1) << firstLevel;
+		m_secondLevelMaps[firstLevel] |= 1u << secondLevel;
+	}
+
+	void TlsfAllocator::RemoveFreeBlock(uint32_t blockIndex)
+	{
+		Block &block = m_blocks[blockIndex];
+		uint32_t firstLevel, secondLevel;
+		Mapping(block.size, firstLevel, secondLevel);
+
+		if (block.prevFree != k_invalidHandle)
+		{
+			m_blocks[block.prevFree].nextFree = block.nextFree;
+		}
+		else
+		{
+			m_freeHeads[firstLevel][secondLevel] = block.nextFree;
+		}
+		if (block.nextFree != k_invalidHandle)
+		{
+			m_blocks[block.nextFree].prevFree = block.prevFree;
+		}
+
+		if (m_freeHeads[firstLevel][secondLevel] == k_invalidHandle)
+		{
+			m_secondLevelMaps[firstLevel] &= ~(1u << secondLevel);
+			if (m_secondLevelMaps[firstLevel] == 0)
+			{
+				m_firstLevelMap &= ~(uint64_t(1) << firstLevel);
+			}
+		}
+
+		block.isFree = false;
+		block.prevFree = k_invalidHandle;
+		block.nextFree = k_invalidHandle;
+	}
+
+	void TlsfAllocator::MergeWithNext(uint32_t blockIndex)
+	{
+		Block &block = m_blocks[blockIndex];
+		uint32_t nextIndex = block.nextPhysical;
+		Block &next = m_blocks[nextIndex];
+
+		block.size += next.size;
+		block.nextPhysical = next.nextPhysical;
+		if (next.nextPhysical != k_invalidHandle)
+		{
+			m_blocks[next.nextPhysical].prevPhysical = blockIndex;
+		}
+		m_unusedBlocks.push_back(nextIndex);
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace JMEngine
+{
+	// two level segregated fit allocator over an abstract range [0, size),
+	// allocation and free are O(1) and neighbouring free ranges are always merged
+	class TlsfAllocator final
+	{
+	public:
+		static constexpr uint32_t k_invalidHandle = UINT32_MAX;
+
+		void Initialize(uint64_t size);
+		void Clear();
+
+		// returns k_invalidHandle when no free range fits
+		uint32_t Allocate(uint64_t size, uint64_t alignment, uint64_t &offset);
+		void Free(uint32_t handle);
+
+		inline uint64_t GetSize() const { return m_size; }
+		inline uint64_t GetUsedSize() const { return m_usedSize; }
+		inline uint32_t GetAllocationCount() const { return m_allocationCount; }
+		inline bool IsEmpty() const { return m_allocationCount == 0; }
+		uint64_t GetLargestFreeRange() const;
+
+	private:
+		static constexpr uint32_t k_secondLevelLog2 = 5;
+		static constexpr uint32_t k_secondLevelCount = 1 << k_secondLevelLog2;
+		static constexpr uint32_t k_firstLevelCount = 64 - k_secondLevelLog2 + 1;
+
+		struct Block
+		{
+			uint64_t offset{0};
+			uint64_t size{0};
+			uint32_t prevPhysical{k_invalidHandle};
+			uint32_t nextPhysical{k_invalidHandle};
+			uint32_t prevFree{k_invalidHandle};
+			uint32_t nextFree{k_invalidHandle};
+			bool isFree{false};
+		};
+
+		uint64_t m_size{0};
+		uint64_t m_usedSize{0};
+		uint32_t m_allocationCount{0};
+
+		std::vector<Block> m_blocks;
+		std::vector<uint32_t> m_unusedBlocks;
+
+		uint64_t m_firstLevelMap{0};
+		uint32_t m_secondLevelMaps[k_firstLevelCount]{};
+		uint32_t m_freeHeads[k_firstLevelCount][k_secondLevelCount]{};
+
+		static void Mapping(uint64_t size, uint32_t &firstLevel, uint32_t &secondLevel);
+		uint32_t FindFreeBlock(uint64_t size) const;
+		uint32_t NewBlock();
+		void InsertFreeBlock(uint32_t blockIndex);
+		void RemoveFreeBlock(uint32_t blockIndex);
+		void MergeWithNext(uint32_t blockIndex);
+	};
+}
@@ -0,0 +1,597 @@
+#include "source/rhi/vulkan_async_compute.h"
+#include "source/global/macro.h"
+#include "source/global/profiler.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+namespace JMEngine
+{
+	namespace
+	{
+		// descriptors of each supported type per dispatch, on average
+		constexpr uint32_t k_descriptorsPerDispatch = 4;
+
+		inline bool IsWrite(ComputeAccess access)
+		{
+			return access != ComputeAccess::Read;
+		}
+
+		template <typename T>
+		inline uint64_t HandleKey(T handle)
+		{
+			return reinterpret_cast<uint64_t>(handle);
+		}
+	}
+
+	void AsyncCompute::Initialize(VkDevice device, VkQueue computeQueue, uint32_t computeFamily, uint32_t graphicsFamily, uint32_t framesInFlight,
+								  uint32_t maxDispatchesPerFrame, const TimelineSemaphore *graphicsTimeline)
+	{
+		m_device = device;
+		m_computeQueue = computeQueue;
+		m_computeFamily = computeFamily;
+		m_graphicsFamily = graphicsFamily;
+		m_maxDispatchesPerFrame = std::max(maxDispatchesPerFrame, 1u);
+		if (graphicsTimeline != nullptr && graphicsTimeline->IsValid() && m_timeline.Initialize(m_device))
+		{
+			m_graphicsTimeline = graphicsTimeline;
+		}
+
+		_vkCmdPipelineBarrier = (PFN_vkCmdPipelineBarrier)vkGetDeviceProcAddr(m_device, "vkCmdPipelineBarrier");
+		_vkCmdBindPipeline = (PFN_vkCmdBindPipeline)vkGetDeviceProcAddr(m_device, "vkCmdBindPipeline");
+		_vkCmdBindDescriptorSets = (PFN_vkCmdBindDescriptorSets)vkGetDeviceProcAddr(m_device, "vkCmdBindDescriptorSets");
+		_vkCmdPushConstants = (PFN_vkCmdPushConstants)vkGetDeviceProcAddr(m_device, "vkCmdPushConstants");
+		_vkCmdDispatch = (PFN_vkCmdDispatch)vkGetDeviceProcAddr(m_device, "vkCmdDispatch");
+		_vkWaitForFences = (PFN_vkWaitForFences)vkGetDeviceProcAddr(m_device, "vkWaitForFences");
+		_vkResetFences = (PFN_vkResetFences)vkGetDeviceProcAddr(m_device, "vkResetFences");
+
+		VkDescriptorPoolSize poolSizes[] = {
+			{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, m_maxDispatchesPerFrame * k_descriptorsPerDispatch},
+			{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, m_maxDispatchesPerFrame * k_descriptorsPerDispatch},
+			{VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, m_maxDispatchesPerFrame * k_descriptorsPerDispatch},
+			{VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, m_maxDispatchesPerFrame * k_descriptorsPerDispatch},
+		};
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(std::size(poolSizes));
+		poolInfo.pPoolSizes = poolSizes;
+		poolInfo.maxSets = m_maxDispatchesPerFrame;
+
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+		m_frames.resize(framesInFlight);
+		m_frameNumbers.assign(framesInFlight, 0);
+		for (FrameResources &frame : m_frames)
+		{
+			frame.commandPool.Initialize(m_device, m_computeFamily);
+			// sets live for one frame and are dropped together when the slot comes around again
+			if (vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &frame.descriptorPool) != VK_SUCCESS ||
+				(m_graphicsTimeline == nullptr && vkCreateFence(m_device, &fenceInfo, nullptr, &frame.fence) != VK_SUCCESS))
+			{
+				LOG_ERROR("failed to create async compute frame resources!");
+			}
+		}
+		m_stats.isDedicatedQueue = IsDedicatedQueue();
+	}
+
+	void AsyncCompute::Clear()
+	{
+		for (FrameResources &frame : m_frames)
+		{
+			frame.commandPool.Clear();
+			vkDestroyDescriptorPool(m_device, frame.descriptorPool, nullptr);
+			vkDestroyFence(m_device, frame.fence, nullptr);
+		}
+		m_frames.clear();
+		m_frameNumbers.clear();
+		m_commandBuffer = VK_NULL_HANDLE;
+		m_timeline.Clear();
+		m_graphicsTimeline = nullptr;
+		m_resultNumber = 0;
+
+		for (const InFlightSemaphore &inFlight : m_inFlightSemaphores)
+		{
+			vkDestroySemaphore(m_device, inFlight.semaphore, nullptr);
+		}
+		for (VkSemaphore semaphore : m_resultSemaphores)
+		{
+			vkDestroySemaphore(m_device, semaphore, nullptr);
+		}
+		for (VkSemaphore semaphore : m_freeSemaphores)
+		{
+			vkDestroySemaphore(m_device, semaphore, nullptr);
+		}
+		if (m_graphicsSemaphore != VK_NULL_HANDLE)
+		{
+			vkDestroySemaphore(m_device, m_graphicsSemaphore, nullptr);
+			m_graphicsSemaphore = VK_NULL_HANDLE;
+		}
+		m_inFlightSemaphores.clear();
+		m_resultSemaphores.clear();
+		m_freeSemaphores.clear();
+
+		m_computeOwned.clear();
+		m_touched.clear();
+		m_bufferReleases.clear();
+		m_imageReleases.clear();
+		m_handBacks.clear();
+		m_bufferAcquires.clear();
+		m_imageAcquires.clear();
+	}
+
+	void AsyncCompute::BeginFrame(uint32_t frameIndex)
+	{
+		// the previous frame was dropped before its graphics submission, its dispatches go with this one
+		if (m_commandBuffer != VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		m_currentFrame = frameIndex;
+		FrameResources &frame = m_frames[frameIndex];
+		if (frame.isSubmitted)
+		{
+			PROFILE_SCOPE("WaitForComputeFence");
+			if (m_timeline.IsValid())
+			{
+				m_timeline.Wait(m_frameNumbers[frameIndex]);
+				m_completedComputeNumber = m_timeline.GetCompletedValue();
+			}
+			else
+			{
+				_vkWaitForFences(m_device, 1, &frame.fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+				_vkResetFences(m_device, 1, &frame.fence);
+				m_completedComputeNumber = std::max(m_completedComputeNumber, m_frameNumbers[frameIndex]);
+			}
+			frame.isSubmitted = false;
+		}
+		frame.commandPool.Reset();
+		vkResetDescriptorPool(m_device, frame.descriptorPool, 0);
+	}
+
+	VkDescriptorType AsyncCompute::GetBindingType(const ComputePipeline &pipeline, uint32_t binding) const
+	{
+		return binding < pipeline.bindingTypes.size() ? pipeline.bindingTypes[binding] : VK_DESCRIPTOR_TYPE_MAX_ENUM;
+	}
+
+	void AsyncCompute::Dispatch(const ComputeDispatch &dispatch)
+	{
+		PROFILE_FUNCTION();
+		const ComputePipeline *pipeline = dispatch.pipeline;
+		if (pipeline == nullptr || !pipeline->IsValid())
+		{
+			LOG_WARN("dispatch without a compute pipeline is skipped");
+			return;
+		}
+		if (m_dispatchCount >= m_maxDispatchesPerFrame)
+		{
+			LOG_ERROR("too many compute dispatches in one frame, raise RHIInfo::maxComputeDispatchesPerFrame");
+			return;
+		}
+
+		FrameResources &frame = m_frames[m_currentFrame];
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = frame.descriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &pipeline->setLayout;
+		VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+		if (vkAllocateDescriptorSets(m_device, &allocInfo, &descriptorSet) != VK_SUCCESS)
+		{
+			LOG_ERROR("out of compute descriptors, raise RHIInfo::maxComputeDispatchesPerFrame");
+			return;
+		}
+
+		// the previous submission on this queue may still be writing what this one reads
+		bool isHazard = false;
+		if (m_commandBuffer == VK_NULL_HANDLE)
+		{
+			m_commandBuffer = frame.commandPool.Acquire(VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+			VkCommandBufferBeginInfo beginInfo = {};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			if (vkBeginCommandBuffer(m_commandBuffer, &beginInfo) != VK_SUCCESS)
+			{
+				LOG_ERROR("failed to begin recording compute command buffer!");
+			}
+			isHazard = true;
+		}
+
+		bool isDedicated = IsDedicatedQueue();
+		std::vector<VkBufferMemoryBarrier> bufferBarriers;
+		std::vector<VkImageMemoryBarrier> imageBarriers;
+		std::vector<std::pair<uint64_t, bool>> usedResources;
+		std::vector<VkDescriptorBufferInfo> bufferInfos;
+		std::vector<VkDescriptorImageInfo> imageInfos;
+		bufferInfos.reserve(dispatch.buffers.size());
+		imageInfos.reserve(dispatch.images.size());
+		std::vector<VkWriteDescriptorSet> descriptorWrites;
+
+		for (const ComputeBufferBinding &binding : dispatch.buffers)
+		{
+			VkDescriptorType type = GetBindingType(*pipeline, binding.binding);
+			if (type != VK_DESCRIPTOR_TYPE_STORAGE_BUFFER && type != VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+			{
+				LOG_WARN("compute shader has no buffer at binding " + std::to_string(binding.binding));
+				continue;
+			}
+			uint64_t handle = HandleKey(binding.buffer);
+			if (m_computeOwned.insert(handle).second)
+			{
+				// graphics may still use it, and written contents it kept must be released before compute reads them
+				m_isWaitingOnGraphics = true;
+				if (isDedicated && binding.access != ComputeAccess::Write)
+				{
+					VkBufferMemoryBarrier barrier = {};
+					barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+					barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+					barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+					barrier.srcQueueFamilyIndex = m_graphicsFamily;
+					barrier.dstQueueFamilyIndex = m_computeFamily;
+					barrier.buffer = binding.buffer;
+					barrier.offset = 0;
+					barrier.size = VK_WHOLE_SIZE;
+					m_bufferReleases.push_back(barrier);
+					bufferBarriers.push_back(barrier);
+					m_transferCount++;
+				}
+			}
+			usedResources.emplace_back(handle, IsWrite(binding.access));
+			if (binding.graphicsStages != 0)
+			{
+				AddHandBack(handle, {binding.buffer, VK_NULL_HANDLE, binding.graphicsStages, binding.graphicsAccess});
+			}
+
+			bufferInfos.push_back({binding.buffer, binding.offset, binding.range});
+			VkWriteDescriptorSet &write = descriptorWrites.emplace_back();
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = descriptorSet;
+			write.dstBinding = binding.binding;
+			write.descriptorCount = 1;
+			write.descriptorType = type;
+			write.pBufferInfo = &bufferInfos.back();
+		}
+
+		for (const ComputeImageBinding &binding : dispatch.images)
+		{
+			VkDescriptorType type = GetBindingType(*pipeline, binding.binding);
+			if (type != VK_DESCRIPTOR_TYPE_STORAGE_IMAGE && type != VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE)
+			{
+				LOG_WARN("compute shader has no image at binding " + std::to_string(binding.binding));
+				continue;
+			}
+			uint64_t handle = HandleKey(binding.image);
+			if (m_computeOwned.insert(handle).second)
+			{
+				m_isWaitingOnGraphics = true;
+				VkImageMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+				barrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+				barrier.oldLayout = binding.access == ComputeAccess::Write ? VK_IMAGE_LAYOUT_UNDEFINED : binding.graphicsLayout;
+				barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+				barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+				barrier.image = binding.image;
+				barrier.subresourceRange = {binding.range.aspectMask, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+				if (isDedicated && binding.access != ComputeAccess::Write)
+				{
+					barrier.srcQueueFamilyIndex = m_graphicsFamily;
+					barrier.dstQueueFamilyIndex = m_computeFamily;
+					m_imageReleases.push_back(barrier);
+					m_transferCount++;
+				}
+				imageBarriers.push_back(barrier);
+			}
+			usedResources.emplace_back(handle, IsWrite(binding.access));
+			if (binding.graphicsStages != 0)
+			{
+				AddHandBack(handle, {VK_NULL_HANDLE, binding.image, binding.graphicsStages, binding.graphicsAccess, binding.graphicsLayout,
+									 binding.range.aspectMask});
+			}
+
+			imageInfos.push_back({VK_NULL_HANDLE, binding.view, VK_IMAGE_LAYOUT_GENERAL});
+			VkWriteDescriptorSet &write = descriptorWrites.emplace_back();
+			write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			write.dstSet = descriptorSet;
+			write.dstBinding = binding.binding;
+			write.descriptorCount = 1;
+			write.descriptorType = type;
+			write.pImageInfo = &imageInfos.back();
+		}
+		vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+
+		// dispatches only wait for each other when they share a resource one of them writes
+		for (const auto &[handle, isWritten] : usedResources)
+		{
+			auto it = m_touched.find(handle);
+			isHazard = isHazard || (it != m_touched.end() && (it->second || isWritten));
+		}
+		if (isHazard)
+		{
+			m_touched.clear();
+		}
+		for (const auto &[handle, isWritten] : usedResources)
+		{
+			m_touched[handle] |= isWritten;
+		}
+
+		if (isHazard || !bufferBarriers.empty() || !imageBarriers.empty())
+		{
+			VkMemoryBarrier memoryBarrier = {};
+			memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+			memoryBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			memoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+			// compute shader on the source side also chains with the wait on the graphics semaphore
+			_vkCmdPipelineBarrier(m_commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0,
+								  isHazard ? 1 : 0, &memoryBarrier, static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+								  static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+		}
+
+		_vkCmdBindPipeline(m_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->pipeline);
+		_vkCmdBindDescriptorSets(m_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->layout, 0, 1, &descriptorSet, 0, nullptr);
+		uint32_t pushConstantSize = std::min(static_cast<uint32_t>(dispatch.pushConstants.size()), pipeline->pushConstantSize);
+		if (pushConstantSize > 0)
+		{
+			_vkCmdPushConstants(m_commandBuffer, pipeline->layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, pushConstantSize, dispatch.pushConstants.data());
+		}
+		_vkCmdDispatch(m_commandBuffer, dispatch.groupCountX, dispatch.groupCountY, dispatch.groupCountZ);
+		m_dispatchCount++;
+	}
+
+	void AsyncCompute::AddHandBack(uint64_t handle, const HandBack &handBack)
+	{
+		auto [it, isNew] = m_handBacks.try_emplace(handle, handBack);
+		if (!isNew)
+		{
+			it->second.stages |= handBack.stages;
+			it->second.access |= handBack.access;
+		}
+	}
+
+	void AsyncCompute::Forget(VkBuffer buffer)
+	{
+		m_computeOwned.erase(HandleKey(buffer));
+	}
+
+	void AsyncCompute::Forget(VkImage image)
+	{
+		m_computeOwned.erase(HandleKey(image));
+	}
+
+	void AsyncCompute::AcquireResults(VkCommandBuffer commandBuffer, uint64_t frameNumber, std::vector<VkSemaphore> &waitSemaphores,
+									  std::vector<uint64_t> &waitValues, std::vector<VkPipelineStageFlags> &waitStages)
+	{
+		if (m_resultSemaphores.empty() && m_resultNumber == 0)
+		{
+			return;
+		}
+
+		// the source stages chain with the semaphore waits, which happen at the same stages
+		if (!m_bufferAcquires.empty() || !m_imageAcquires.empty())
+		{
+			_vkCmdPipelineBarrier(commandBuffer, m_resultStages, m_resultStages, 0, 0, nullptr,
+								  static_cast<uint32_t>(m_bufferAcquires.size()), m_bufferAcquires.data(),
+								  static_cast<uint32_t>(m_imageAcquires.size()), m_imageAcquires.data());
+		}
+		for (VkSemaphore semaphore : m_resultSemaphores)
+		{
+			waitSemaphores.push_back(semaphore);
+			waitValues.push_back(0);
+			waitStages.push_back(m_resultStages);
+			m_inFlightSemaphores.push_back({semaphore, frameNumber, false});
+		}
+		// the latest submission with results covers the earlier ones
+		if (m_resultNumber != 0)
+		{
+			waitSemaphores.push_back(m_timeline.GetHandle());
+			waitValues.push_back(m_resultNumber);
+			waitStages.push_back(m_resultStages);
+		}
+		m_resultSemaphores.clear();
+		m_resultNumber = 0;
+		m_bufferAcquires.clear();
+		m_imageAcquires.clear();
+		m_resultStages = 0;
+	}
+
+	void AsyncCompute::ReleaseToCompute(VkCommandBuffer commandBuffer, std::vector<VkSemaphore> &signalSemaphores)
+	{
+		if (!m_isWaitingOnGraphics)
+		{
+			return;
+		}
+
+		if (!m_bufferReleases.empty() || !m_imageReleases.empty())
+		{
+			_vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+								  static_cast<uint32_t>(m_bufferReleases.size()), m_bufferReleases.data(),
+								  static_cast<uint32_t>(m_imageReleases.size()), m_imageReleases.data());
+		}
+		// the graphics timeline is signaled by every frame already
+		if (m_graphicsTimeline != nullptr)
+		{
+			return;
+		}
+		if (m_graphicsSemaphore == VK_NULL_HANDLE)
+		{
+			m_graphicsSemaphore = AcquireSemaphore();
+		}
+		signalSemaphores.push_back(m_graphicsSemaphore);
+	}
+
+	void AsyncCompute::RecordHandBacks()
+	{
+		bool isDedicated = IsDedicatedQueue();
+		std::vector<VkBufferMemoryBarrier> bufferReleases;
+		std::vector<VkImageMemoryBarrier> imageReleases;
+		for (const auto &[handle, handBack] : m_handBacks)
+		{
+			m_computeOwned.erase(handle);
+			m_resultStages |= handBack.stages;
+			// only read by the acquire of a transfer, bottom of pipe takes no access on a shared family
+			VkAccessFlags dstAccess = isDedicated ? handBack.access : 0;
+			if (handBack.buffer != VK_NULL_HANDLE)
+			{
+				VkBufferMemoryBarrier release = {};
+				release.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				release.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+				release.dstAccessMask = dstAccess;
+				release.srcQueueFamilyIndex = isDedicated ? m_computeFamily : VK_QUEUE_FAMILY_IGNORED;
+				release.dstQueueFamilyIndex = isDedicated ? m_graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+				release.buffer = handBack.buffer;
+				release.offset = 0;
+				release.size = VK_WHOLE_SIZE;
+				bufferReleases.push_back(release);
+				if (isDedicated)
+				{
+					m_bufferAcquires.push_back(release);
+					m_transferCount++;
+				}
+				continue;
+			}
+
+			VkImageMemoryBarrier release = {};
+			release.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			release.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+			release.dstAccessMask = dstAccess;
+			release.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+			release.newLayout = handBack.layout;
+			release.srcQueueFamilyIndex = isDedicated ? m_computeFamily : VK_QUEUE_FAMILY_IGNORED;
+			release.dstQueueFamilyIndex = isDedicated ? m_graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+			release.image = handBack.image;
+			release.subresourceRange = {handBack.aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+			imageReleases.push_back(release);
+			if (isDedicated)
+			{
+				m_imageAcquires.push_back(release);
+				m_transferCount++;
+			}
+		}
+
+		// on a shared family this is the whole hand over, the semaphore makes the writes visible to graphics
+		_vkCmdPipelineBarrier(m_commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+							  static_cast<uint32_t>(bufferReleases.size()), bufferReleases.data(),
+							  static_cast<uint32_t>(imageReleases.size()), imageReleases.data());
+		m_handBacks.clear();
+	}
+
+	void AsyncCompute::Submit(uint64_t frameNumber)
+	{
+		if (m_commandBuffer == VK_NULL_HANDLE)
+		{
+			m_stats.dispatchCount = 0;
+			m_stats.ownershipTransferCount = 0;
+			m_stats.isWaitingOnGraphics = false;
+			return;
+		}
+		PROFILE_FUNCTION();
+
+		bool hasResults = !m_handBacks.empty();
+		VkSemaphore resultSemaphore = VK_NULL_HANDLE;
+		if (hasResults)
+		{
+			RecordHandBacks();
+			resultSemaphore = m_timeline.IsValid() ? VK_NULL_HANDLE : AcquireSemaphore();
+		}
+		if (vkEndCommandBuffer(m_commandBuffer) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to record compute command buffer!");
+		}
+
+		VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.waitSemaphoreCount = m_graphicsSemaphore != VK_NULL_HANDLE ? 1 : 0;
+		submitInfo.pWaitSemaphores = &m_graphicsSemaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &m_commandBuffer;
+		submitInfo.signalSemaphoreCount = resultSemaphore != VK_NULL_HANDLE ? 1 : 0;
+		submitInfo.pSignalSemaphores = &resultSemaphore;
+
+		// compute waits for the graphics frame of the same number and signals that number when done
+		VkSemaphore graphicsTimeline = m_graphicsTimeline != nullptr ? m_graphicsTimeline->GetHandle() : VK_NULL_HANDLE;
+		VkSemaphore timeline = m_timeline.GetHandle();
+		VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = m_isWaitingOnGraphics ? 1 : 0;
+		timelineInfo.pWaitSemaphoreValues = &frameNumber;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &frameNumber;
+		if (m_timeline.IsValid())
+		{
+			submitInfo.pNext = &timelineInfo;
+			submitInfo.waitSemaphoreCount = m_isWaitingOnGraphics ? 1 : 0;
+			submitInfo.pWaitSemaphores = &graphicsTimeline;
+			submitInfo.signalSemaphoreCount = 1;
+			submitInfo.pSignalSemaphores = &timeline;
+		}
+		FrameResources &frame = m_frames[m_currentFrame];
+		if (vkQueueSubmit(m_computeQueue, 1, &submitInfo, frame.fence) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to submit compute command buffer!");
+		}
+		frame.isSubmitted = true;
+		m_frameNumbers[m_currentFrame] = frameNumber;
+
+		if (m_graphicsSemaphore != VK_NULL_HANDLE)
+		{
+			m_inFlightSemaphores.push_back({m_graphicsSemaphore, frameNumber, true});
+			m_graphicsSemaphore = VK_NULL_HANDLE;
+		}
+		if (resultSemaphore != VK_NULL_HANDLE)
+		{
+			m_resultSemaphores.push_back(resultSemaphore);
+		}
+		else if (hasResults)
+		{
+			m_resultNumber = frameNumber;
+		}
+
+		m_stats.dispatchCount = m_dispatchCount;
+		m_stats.ownershipTransferCount = m_transferCount;
+		m_stats.isWaitingOnGraphics = m_isWaitingOnGraphics;
+		m_commandBuffer = VK_NULL_HANDLE;
+		m_touched.clear();
+		m_bufferReleases.clear();
+		m_imageReleases.clear();
+		m_isWaitingOnGraphics = false;
+		m_dispatchCount = 0;
+		m_transferCount = 0;
+	}
+
+	void AsyncCompute::Update(uint64_t completedFrameNumber)
+	{
+		std::erase_if(m_inFlightSemaphores, [this, completedFrameNumber](const InFlightSemaphore &inFlight)
+					  {
+						  uint64_t completed = inFlight.isWaitedByCompute ? m_completedComputeNumber : completedFrameNumber;
+						  if (inFlight.frameNumber > completed)
+						  {
+							  return false;
+						  }
+						  m_freeSemaphores.push_back(inFlight.semaphore);
+						  return true; });
+	}
+
+	VkSemaphore AsyncCompute::AcquireSemaphore()
+	{
+		if (!m_freeSemaphores.empty())
+		{
+			VkSemaphore semaphore = m_freeSemaphores.back();
+			m_freeSemaphores.pop_back();
+			return semaphore;
+		}
+
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		VkSemaphore semaphore = VK_NULL_HANDLE;
+		if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &semaphore) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create async compute semaphore!");
+		}
+		return semaphore;
+	}
+}
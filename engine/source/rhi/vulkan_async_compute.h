@@ -0,0 +1,209 @@
+#pragma once
+
+#include "source/rhi/vulkan_command_pool.h"
+#include "source/rhi/vulkan_timeline_semaphore.h"
+
+#include <vulkan/vulkan.h>
+
+#include <cstddef>
+#include <deque>
+#include <span>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace JMEngine
+{
+	// a compute pipeline and the interface its dispatches bind, owned by the pipeline library and the layout cache
+	struct ComputePipeline
+	{
+		VkPipeline pipeline{VK_NULL_HANDLE};
+		VkPipelineLayout layout{VK_NULL_HANDLE};
+		// set 0, the only set dispatches bind
+		VkDescriptorSetLayout setLayout{VK_NULL_HANDLE};
+		// indexed by binding number, VK_DESCRIPTOR_TYPE_MAX_ENUM for numbers the shader skips
+		std::vector<VkDescriptorType> bindingTypes;
+		uint32_t pushConstantSize{0};
+
+		inline bool IsValid() const { return pipeline != VK_NULL_HANDLE; }
+	};
+
+	enum class ComputeAccess : uint8_t
+	{
+		Read,
+		// the previous contents are discarded, no ownership transfer is needed to get them
+		Write,
+		ReadWrite,
+	};
+
+	// graphicsStages and graphicsAccess are where graphics uses the resource once compute hands it back,
+	// a resource bound with graphicsStages 0 stays on the compute queue
+	struct ComputeBufferBinding
+	{
+		uint32_t binding{0};
+		VkBuffer buffer{VK_NULL_HANDLE};
+		VkDeviceSize offset{0};
+		VkDeviceSize range{VK_WHOLE_SIZE};
+		ComputeAccess access{ComputeAccess::Read};
+		VkPipelineStageFlags graphicsStages{0};
+		VkAccessFlags graphicsAccess{0};
+	};
+
+	// ownership is tracked per image, compute always uses the whole image in GENERAL
+	struct ComputeImageBinding
+	{
+		uint32_t binding{0};
+		VkImage image{VK_NULL_HANDLE};
+		VkImageView view{VK_NULL_HANDLE};
+		VkImageSubresourceRange range{VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS};
+		ComputeAccess access{ComputeAccess::Read};
+		VkPipelineStageFlags graphicsStages{0};
+		VkAccessFlags graphicsAccess{0};
+		// the layout graphics keeps the image in, and gets it back in
+		VkImageLayout graphicsLayout{VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+	};
+
+	struct ComputeDispatch
+	{
+		const ComputePipeline *pipeline{nullptr};
+		uint32_t groupCountX{1};
+		uint32_t groupCountY{1};
+		uint32_t groupCountZ{1};
+		std::span<const ComputeBufferBinding> buffers;
+		std::span<const ComputeImageBinding> images;
+		// at most pipeline->pushConstantSize bytes
+		std::span<const std::byte> pushConstants;
+	};
+
+	struct AsyncComputeStats
+	{
+		// of the latest submitted frame
+		uint32_t dispatchCount{0};
+		uint32_t ownershipTransferCount{0};
+		bool isWaitingOnGraphics{false};
+		bool isDedicatedQueue{false};
+	};
+
+	// records dispatches into a per frame command buffer that is submitted to the compute queue right after the
+	// frame's graphics work, so it overlaps the next frame's rendering. every resource is owned by one queue,
+	// graphics by default: compute takes what it reads at the end of the frame's graphics submission and waits
+	// on it, and hands back what graphics consumes, which the next graphics frame acquires and waits on at the
+	// stages it declared. results handed back are therefore one frame late, resources compute keeps for itself
+	// never make either queue wait
+	class AsyncCompute final
+	{
+	public:
+		// computeQueue may be the graphics queue when the device has a single family. with a valid graphicsTimeline,
+		// signaled with every graphics frame number, submissions wait on it and signal a compute timeline with the
+		// same numbers, replacing the fences and the binary semaphores
+		void Initialize(VkDevice device, VkQueue computeQueue, uint32_t computeFamily, uint32_t graphicsFamily, uint32_t framesInFlight,
+						uint32_t maxDispatchesPerFrame, const TimelineSemaphore *graphicsTimeline);
+		// the device must be idle
+		void Clear();
+
+		// render thread only, waits for the compute work of the frame that used this slot, a no-op while
+		// dispatches of a dropped frame still wait to be submitted
+		void BeginFrame(uint32_t frameIndex);
+		// render thread only, between BeginFrame and the frame's graphics submission
+		void Dispatch(const ComputeDispatch &dispatch);
+		// the next dispatch treats the resource as graphics owned again, call it before destroying a resource
+		// compute still owns
+		void Forget(VkBuffer buffer);
+		void Forget(VkImage image);
+
+		// at the start of the graphics command buffer, acquires the results handed back by earlier frames,
+		// the submission must wait on the appended semaphores for the appended values at the appended stages
+		void AcquireResults(VkCommandBuffer commandBuffer, uint64_t frameNumber, std::vector<VkSemaphore> &waitSemaphores,
+							std::vector<uint64_t> &waitValues, std::vector<VkPipelineStageFlags> &waitStages);
+		// at the end of the graphics command buffer, releases what this frame's dispatches read, the submission
+		// must signal the appended binary semaphores
+		void ReleaseToCompute(VkCommandBuffer commandBuffer, std::vector<VkSemaphore> &signalSemaphores);
+		// right after the graphics submission numbered frameNumber
+		void Submit(uint64_t frameNumber);
+		// recycles semaphores of completed graphics frames
+		void Update(uint64_t completedFrameNumber);
+
+		inline bool IsDedicatedQueue() const { return m_computeFamily != m_graphicsFamily; }
+		inline const AsyncComputeStats &GetStats() const { return m_stats; }
+
+	private:
+		struct FrameResources
+		{
+			TransientCommandPool commandPool;
+			VkDescriptorPool descriptorPool{VK_NULL_HANDLE};
+			// null with timeline semaphores
+			VkFence fence{VK_NULL_HANDLE};
+			bool isSubmitted{false};
+		};
+
+		struct HandBack
+		{
+			VkBuffer buffer{VK_NULL_HANDLE};
+			VkImage image{VK_NULL_HANDLE};
+			VkPipelineStageFlags stages{0};
+			VkAccessFlags access{0};
+			VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+			VkImageAspectFlags aspect{0};
+		};
+
+		struct InFlightSemaphore
+		{
+			VkSemaphore semaphore;
+			// the graphics frame that waits on it, or whose compute submission does
+			uint64_t frameNumber;
+			bool isWaitedByCompute;
+		};
+
+		VkDescriptorType GetBindingType(const ComputePipeline &pipeline, uint32_t binding) const;
+		void AddHandBack(uint64_t handle, const HandBack &handBack);
+		void RecordHandBacks();
+		VkSemaphore AcquireSemaphore();
+
+		VkDevice m_device{nullptr};
+		VkQueue m_computeQueue{nullptr};
+		uint32_t m_computeFamily{0};
+		uint32_t m_graphicsFamily{0};
+		uint32_t m_maxDispatchesPerFrame{0};
+		const TimelineSemaphore *m_graphicsTimeline{nullptr};
+		TimelineSemaphore m_timeline;
+
+		std::vector<FrameResources> m_frames;
+		std::vector<uint64_t> m_frameNumbers;
+		uint32_t m_currentFrame{0};
+		uint64_t m_completedComputeNumber{0};
+		VkCommandBuffer m_commandBuffer{VK_NULL_HANDLE};
+
+		// handles of the resources compute owns, everything else belongs to graphics
+		std::unordered_set<uint64_t> m_computeOwned;
+		// resources the current command buffer has used, with whether they were written
+		std::unordered_map<uint64_t, bool> m_touched;
+		// the graphics halves of the current frame's hand overs
+		std::vector<VkBufferMemoryBarrier> m_bufferReleases;
+		std::vector<VkImageMemoryBarrier> m_imageReleases;
+		bool m_isWaitingOnGraphics{false};
+		VkSemaphore m_graphicsSemaphore{VK_NULL_HANDLE};
+		std::unordered_map<uint64_t, HandBack> m_handBacks;
+		uint32_t m_dispatchCount{0};
+		uint32_t m_transferCount{0};
+
+		// results submitted but not yet acquired by a graphics frame
+		std::vector<VkBufferMemoryBarrier> m_bufferAcquires;
+		std::vector<VkImageMemoryBarrier> m_imageAcquires;
+		std::vector<VkSemaphore> m_resultSemaphores;
+		// the timeline value to wait for instead, 0 when nothing is waiting to be acquired
+		uint64_t m_resultNumber{0};
+		VkPipelineStageFlags m_resultStages{0};
+
+		std::deque<InFlightSemaphore> m_inFlightSemaphores;
+		std::vector<VkSemaphore> m_freeSemaphores;
+		AsyncComputeStats m_stats;
+
+		PFN_vkCmdPipelineBarrier _vkCmdPipelineBarrier;
+		PFN_vkCmdBindPipeline _vkCmdBindPipeline;
+		PFN_vkCmdBindDescriptorSets _vkCmdBindDescriptorSets;
+		PFN_vkCmdPushConstants _vkCmdPushConstants;
+		PFN_vkCmdDispatch _vkCmdDispatch;
+		PFN_vkWaitForFences _vkWaitForFences;
+		PFN_vkResetFences _vkResetFences;
+	};
+}
@@ -0,0 +1,71 @@
+#include "source/rhi/vulkan_command_pool.h"
+#include "source/global/macro.h"
+
+namespace JMEngine
+{
+	void TransientCommandPool::Initialize(VkDevice device, uint32_t queueFamilyIndex)
+	{
+		m_device = device;
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamilyIndex;
+		// buffers are short lived and never reset one by one
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create command pool!");
+		}
+
+		_vkResetCommandPool = (PFN_vkResetCommandPool)vkGetDeviceProcAddr(m_device, "vkResetCommandPool");
+	}
+
+	void TransientCommandPool::Clear()
+	{
+		// destroying the pool frees every buffer allocated from it
+		vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+		m_commandPool = VK_NULL_HANDLE;
+		m_primaryBuffers.clear();
+		m_secondaryBuffers.clear();
+		m_primaryUsed = 0;
+		m_secondaryUsed = 0;
+	}
+
+	void TransientCommandPool::Reset()
+	{
+		if (m_primaryUsed == 0 && m_secondaryUsed == 0)
+		{
+			return;
+		}
+
+		_vkResetCommandPool(m_device, m_commandPool, 0);
+		m_primaryUsed = 0;
+		m_secondaryUsed = 0;
+	}
+
+	VkCommandBuffer TransientCommandPool::Acquire(VkCommandBufferLevel level)
+	{
+		bool isPrimary = level == VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		std::vector<VkCommandBuffer> &buffers = isPrimary ? m_primaryBuffers : m_secondaryBuffers;
+		uint32_t &used = isPrimary ? m_primaryUsed : m_secondaryUsed;
+
+		if (used == buffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo = {};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = m_commandPool;
+			allocInfo.level = level;
+			allocInfo.commandBufferCount = 1;
+
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+			if (vkAllocateCommandBuffers(m_device, &allocInfo, &commandBuffer) != VK_SUCCESS)
+			{
+				LOG_ERROR("failed to allocate command buffers!");
+			}
+			buffers.push_back(commandBuffer);
+		}
+
+		return buffers[used++];
+	}
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <vector>
+
+namespace JMEngine
+{
+	// a transient command pool owned by one thread for one frame in flight,
+	// command buffers are handed out again after the pool is reset in bulk
+	class TransientCommandPool final
+	{
+	public:
+		void Initialize(VkDevice device, uint32_t queueFamilyIndex);
+		void Clear();
+
+		void Reset();
+		VkCommandBuffer Acquire(VkCommandBufferLevel level);
+
+	private:
+		VkDevice m_device{nullptr};
+		VkCommandPool m_commandPool{VK_NULL_HANDLE};
+
+		std::vector<VkCommandBuffer> m_primaryBuffers;
+		std::vector<VkCommandBuffer> m_secondaryBuffers;
+		uint32_t m_primaryUsed{0};
+		uint32_t m_secondaryUsed{0};
+
+		PFN_vkResetCommandPool _vkResetCommandPool;
+	};
+}
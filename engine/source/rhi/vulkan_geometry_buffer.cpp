@@ -0,0 +1,189 @@
+#include "source/rhi/vulkan_geometry_buffer.h"
+#include "source/global/macro.h"
+
+#include <algorithm>
+
+namespace JMEngine
+{
+	void GeometryBuffer::Initialize(VkDevice device, VulkanMemoryAllocator *memoryAllocator, UploadManager *uploadManager, uint32_t vertexStride,
+									uint32_t vertexCapacity, uint32_t indexCapacity, DeferDestroyFunction &&deferDestroy)
+	{
+		m_device = device;
+		m_memoryAllocator = memoryAllocator;
+		m_uploadManager = uploadManager;
+		m_deferDestroy = std::move(deferDestroy);
+		m_vertexStride = vertexStride;
+
+		_vkCmdBindVertexBuffers = (PFN_vkCmdBindVertexBuffers)vkGetDeviceProcAddr(m_device, "vkCmdBindVertexBuffers");
+		_vkCmdBindIndexBuffer = (PFN_vkCmdBindIndexBuffer)vkGetDeviceProcAddr(m_device, "vkCmdBindIndexBuffer");
+
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = static_cast<VkDeviceSize>(vertexCapacity) * vertexStride;
+		bufferInfo.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (!m_memoryAllocator->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, m_vertexBuffer, m_vertexAllocation))
+		{
+			LOG_ERROR("failed to create vertex buffer!");
+			return;
+		}
+
+		bufferInfo.size = static_cast<VkDeviceSize>(indexCapacity) * sizeof(uint32_t);
+		bufferInfo.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		if (!m_memoryAllocator->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, m_indexBuffer, m_indexAllocation))
+		{
+			LOG_ERROR("failed to create index buffer!");
+			return;
+		}
+
+		// counted in elements rather than bytes, vertex strides are rarely a power of two
+		m_vertexAllocator.Initialize(vertexCapacity);
+		m_indexAllocator.Initialize(indexCapacity);
+	}
+
+	void GeometryBuffer::Clear()
+	{
+		if (m_vertexBuffer != VK_NULL_HANDLE)
+		{
+			m_memoryAllocator->DestroyBuffer(m_vertexBuffer, m_vertexAllocation);
+			m_vertexBuffer = VK_NULL_HANDLE;
+		}
+		if (m_indexBuffer != VK_NULL_HANDLE)
+		{
+			m_memoryAllocator->DestroyBuffer(m_indexBuffer, m_indexAllocation);
+			m_indexBuffer = VK_NULL_HANDLE;
+		}
+		m_vertexAllocator.Clear();
+		m_indexAllocator.Clear();
+		m_meshes.clear();
+		m_freeMeshIds.clear();
+		m_meshCount = 0;
+		m_retiredMeshes.clear();
+	}
+
+	void GeometryBuffer::Update()
+	{
+		std::erase_if(m_retiredMeshes, [this](const RetiredMesh &mesh)
+					  {
+						  if (!m_uploadManager->IsComplete(mesh.ticket))
+						  {
+							  return false;
+						  }
+						  ReleaseRanges(mesh.vertexHandle, mesh.indexHandle);
+						  return true; });
+	}
+
+	MeshId GeometryBuffer::CreateMesh(const void *vertices, uint32_t vertexCount, std::span<const uint32_t> indices)
+	{
+		if (m_vertexBuffer == VK_NULL_HANDLE || m_indexBuffer == VK_NULL_HANDLE || vertexCount == 0 || indices.empty())
+		{
+			return k_invalidMeshId;
+		}
+
+		uint64_t vertexOffset = 0;
+		uint32_t vertexHandle = m_vertexAllocator.Allocate(vertexCount, 1, vertexOffset);
+		if (vertexHandle == TlsfAllocator::k_invalidHandle)
+		{
+			LOG_ERROR("geometry vertex buffer is full, raise RHIInfo::geometryVertexCapacity");
+			return k_invalidMeshId;
+		}
+		uint64_t firstIndex = 0;
+		uint32_t indexHandle = m_indexAllocator.Allocate(indices.size(), 1, firstIndex);
+		if (indexHandle == TlsfAllocator::k_invalidHandle)
+		{
+			m_vertexAllocator.Free(vertexHandle);
+			LOG_ERROR("geometry index buffer is full, raise RHIInfo::geometryIndexCapacity");
+			return k_invalidMeshId;
+		}
+
+		// the index upload is queued after the vertex upload, its ticket completes both
+		VkDeviceSize vertexBytes = static_cast<VkDeviceSize>(vertexCount) * m_vertexStride;
+		UploadTicket vertexTicket = m_uploadManager->UploadBuffer(m_vertexBuffer, vertexOffset * m_vertexStride, vertices, vertexBytes);
+		UploadTicket indexTicket = m_uploadManager->UploadBuffer(m_indexBuffer, firstIndex * sizeof(uint32_t), indices.data(), indices.size_bytes());
+		if (vertexTicket == k_invalidUploadTicket || indexTicket == k_invalidUploadTicket)
+		{
+			// whichever half was queued still writes the ranges
+			m_retiredMeshes.push_back({vertexHandle, indexHandle, std::max(vertexTicket, indexTicket)});
+			return k_invalidMeshId;
+		}
+
+		MeshId id;
+		if (!m_freeMeshIds.empty())
+		{
+			id = m_freeMeshIds.back();
+			m_freeMeshIds.pop_back();
+		}
+		else
+		{
+			m_meshes.emplace_back();
+			id = static_cast<MeshId>(m_meshes.size());
+		}
+
+		Mesh &mesh = m_meshes[id - 1];
+		mesh.range.vertexOffset = static_cast<int32_t>(vertexOffset);
+		mesh.range.firstIndex = static_cast<uint32_t>(firstIndex);
+		mesh.range.indexCount = static_cast<uint32_t>(indices.size());
+		mesh.range.vertexCount = vertexCount;
+		mesh.vertexHandle = vertexHandle;
+		mesh.indexHandle = indexHandle;
+		mesh.ticket = indexTicket;
+		mesh.isAlive = true;
+		m_meshCount++;
+		return id;
+	}
+
+	void GeometryBuffer::DestroyMesh(MeshId id)
+	{
+		if (id == k_invalidMeshId || id > m_meshes.size() || !m_meshes[id - 1].isAlive)
+		{
+			return;
+		}
+
+		Mesh &mesh = m_meshes[id - 1];
+		m_retiredMeshes.push_back({mesh.vertexHandle, mesh.indexHandle, mesh.ticket});
+		mesh = Mesh{};
+		m_freeMeshIds.push_back(id);
+		m_meshCount--;
+	}
+
+	void GeometryBuffer::ReleaseRanges(uint32_t vertexHandle, uint32_t indexHandle)
+	{
+		// frames in flight may still be drawing from the ranges
+		m_deferDestroy([this, vertexHandle, indexHandle]()
+					   {
+						   m_vertexAllocator.Free(vertexHandle);
+						   m_indexAllocator.Free(indexHandle); });
+	}
+
+	const MeshRange *GeometryBuffer::GetMesh(MeshId id) const
+	{
+		if (id == k_invalidMeshId || id > m_meshes.size())
+		{
+			return nullptr;
+		}
+		const Mesh &mesh = m_meshes[id - 1];
+		return mesh.isAlive && m_uploadManager->IsComplete(mesh.ticket) ? &mesh.range : nullptr;
+	}
+
+	void GeometryBuffer::Bind(VkCommandBuffer commandBuffer) const
+	{
+		VkDeviceSize offset = 0;
+		_vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_vertexBuffer, &offset);
+		_vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+	}
+
+	GeometryBufferStats GeometryBuffer::GetStats() const
+	{
+		GeometryBufferStats stats;
+		stats.meshCount = m_meshCount;
+		stats.usedVertices = m_vertexAllocator.GetUsedSize();
+		stats.vertexCapacity = m_vertexAllocator.GetSize();
+		stats.usedIndices = m_indexAllocator.GetUsedSize();
+		stats.indexCapacity = m_indexAllocator.GetSize();
+		for (const Mesh &mesh : m_meshes)
+		{
+			stats.uploadingMeshCount += mesh.isAlive && !m_uploadManager->IsComplete(mesh.ticket) ? 1 : 0;
+		}
+		return stats;
+	}
+}
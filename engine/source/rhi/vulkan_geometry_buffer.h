@@ -0,0 +1,110 @@
+#pragma once
+
+#include "source/rhi/tlsf_allocator.h"
+#include "source/rhi/vulkan_memory_allocator.h"
+#include "source/rhi/vulkan_upload_manager.h"
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <span>
+#include <vector>
+
+namespace JMEngine
+{
+	using MeshId = uint32_t;
+	constexpr MeshId k_invalidMeshId = 0;
+
+	// where a mesh lives in the shared buffers, the arguments of its vkCmdDrawIndexed
+	struct MeshRange
+	{
+		// added to every index, the mesh's first vertex in the vertex buffer
+		int32_t vertexOffset{0};
+		uint32_t firstIndex{0};
+		uint32_t indexCount{0};
+		uint32_t vertexCount{0};
+	};
+
+	struct GeometryBufferStats
+	{
+		uint32_t meshCount{0};
+		uint64_t usedVertices{0};
+		uint64_t vertexCapacity{0};
+		uint64_t usedIndices{0};
+		uint64_t indexCapacity{0};
+		// created but not yet drawable
+		uint32_t uploadingMeshCount{0};
+	};
+
+	// every static mesh is placed in one device local vertex buffer and one index buffer, so a frame binds
+	// geometry once and draws each mesh by offset. ranges come from tlsf allocators counting vertices and
+	// indices, new meshes are streamed by the upload manager and become drawable once it has finished them
+	class GeometryBuffer final
+	{
+	public:
+		using DeferDestroyFunction = std::function<void(std::function<void()> &&)>;
+
+		// deferDestroy runs its argument once the frames in flight have completed
+		void Initialize(VkDevice device, VulkanMemoryAllocator *memoryAllocator, UploadManager *uploadManager, uint32_t vertexStride,
+						uint32_t vertexCapacity, uint32_t indexCapacity, DeferDestroyFunction &&deferDestroy);
+		// the device must be idle and deferred destroys flushed
+		void Clear();
+		// once per frame, releases the ranges of destroyed meshes whose upload has finished
+		void Update();
+
+		// vertices holds vertexCount vertices of the stride given to Initialize, k_invalidMeshId when the buffers are full
+		MeshId CreateMesh(const void *vertices, uint32_t vertexCount, std::span<const uint32_t> indices);
+		// the ranges are reused once the frames in flight are done drawing the mesh
+		void DestroyMesh(MeshId mesh);
+		// null until the mesh has been uploaded
+		const MeshRange *GetMesh(MeshId mesh) const;
+
+		void Bind(VkCommandBuffer commandBuffer) const;
+
+		inline VkBuffer GetVertexBuffer() const { return m_vertexBuffer; }
+		inline VkBuffer GetIndexBuffer() const { return m_indexBuffer; }
+		GeometryBufferStats GetStats() const;
+
+	private:
+		struct Mesh
+		{
+			MeshRange range;
+			uint32_t vertexHandle{TlsfAllocator::k_invalidHandle};
+			uint32_t indexHandle{TlsfAllocator::k_invalidHandle};
+			UploadTicket ticket{k_invalidUploadTicket};
+			bool isAlive{false};
+		};
+
+		// a later mesh placed in the same range must not be copied in the same batch
+		struct RetiredMesh
+		{
+			uint32_t vertexHandle;
+			uint32_t indexHandle;
+			UploadTicket ticket;
+		};
+
+		void ReleaseRanges(uint32_t vertexHandle, uint32_t indexHandle);
+
+		VkDevice m_device{nullptr};
+		VulkanMemoryAllocator *m_memoryAllocator{nullptr};
+		UploadManager *m_uploadManager{nullptr};
+		DeferDestroyFunction m_deferDestroy;
+		uint32_t m_vertexStride{0};
+
+		VkBuffer m_vertexBuffer{VK_NULL_HANDLE};
+		VulkanAllocation m_vertexAllocation;
+		TlsfAllocator m_vertexAllocator;
+		VkBuffer m_indexBuffer{VK_NULL_HANDLE};
+		VulkanAllocation m_indexAllocation;
+		TlsfAllocator m_indexAllocator;
+
+		// indexed by MeshId - 1
+		std::vector<Mesh> m_meshes;
+		std::vector<MeshId> m_freeMeshIds;
+		uint32_t m_meshCount{0};
+		std::vector<RetiredMesh> m_retiredMeshes;
+
+		PFN_vkCmdBindVertexBuffers _vkCmdBindVertexBuffers;
+		PFN_vkCmdBindIndexBuffer _vkCmdBindIndexBuffer;
+	};
+}
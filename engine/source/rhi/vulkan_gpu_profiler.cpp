@@ -0,0 +1,265 @@
+#include "source/rhi/vulkan_gpu_profiler.h"
+#include "source/global/macro.h"
+
+#include <chrono>
+
+namespace JMEngine
+{
+	namespace
+	{
+		// query layout of a frame: the frame start, then a begin and end pair per pass, then the frame end
+		inline uint32_t PassBeginQuery(uint32_t pass) { return 1 + pass * 2; }
+		inline uint32_t PassEndQuery(uint32_t pass) { return 2 + pass * 2; }
+		// takes the slot the next pass would have begun in, the last one of the pool with every pass open
+		inline uint32_t FrameEndQuery(uint32_t passCount) { return PassBeginQuery(passCount); }
+		constexpr uint32_t k_timestampQueryCount = 2 + 32 * 2;
+
+		int64_t SteadyClockNs()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+	}
+
+	void GpuProfiler::Initialize(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamilyIndex,
+								 uint32_t frameCount, bool isCalibrationSupported, bool isPipelineStatisticsEnabled)
+	{
+		static_assert(k_timestampQueryCount == 2 + k_maxPassesPerFrame * 2);
+		m_device = device;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		uint32_t queueFamilyCount = 0;
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+		std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+		vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+
+		uint32_t validBits = queueFamilyIndex < queueFamilyCount ? queueFamilies[queueFamilyIndex].timestampValidBits : 0;
+		if (validBits == 0 || properties.limits.timestampPeriod == 0.0f)
+		{
+			LOG_WARN("the graphics queue does not support timestamps, gpu profiling is disabled");
+			return;
+		}
+		m_timestampPeriodNs = properties.limits.timestampPeriod;
+		m_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+		m_isPipelineStatisticsEnabled = isPipelineStatisticsEnabled;
+
+		_vkCmdWriteTimestamp = (PFN_vkCmdWriteTimestamp)vkGetDeviceProcAddr(m_device, "vkCmdWriteTimestamp");
+		_vkCmdResetQueryPool = (PFN_vkCmdResetQueryPool)vkGetDeviceProcAddr(m_device, "vkCmdResetQueryPool");
+		_vkCmdBeginQuery = (PFN_vkCmdBeginQuery)vkGetDeviceProcAddr(m_device, "vkCmdBeginQuery");
+		_vkCmdEndQuery = (PFN_vkCmdEndQuery)vkGetDeviceProcAddr(m_device, "vkCmdEndQuery");
+
+		if (isCalibrationSupported)
+		{
+			_vkGetCalibratedTimestampsEXT = (PFN_vkGetCalibratedTimestampsEXT)vkGetDeviceProcAddr(m_device, "vkGetCalibratedTimestampsEXT");
+			auto _vkGetPhysicalDeviceCalibrateableTimeDomainsEXT = (PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT");
+			if (_vkGetCalibratedTimestampsEXT && _vkGetPhysicalDeviceCalibrateableTimeDomainsEXT)
+			{
+				uint32_t domainCount = 0;
+				_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(physicalDevice, &domainCount, nullptr);
+				std::vector<VkTimeDomainEXT> domains(domainCount);
+				_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT(physicalDevice, &domainCount, domains.data());
+				for (VkTimeDomainEXT domain : domains)
+				{
+					m_isCalibrationSupported |= domain == VK_TIME_DOMAIN_DEVICE_EXT;
+#ifdef __linux__
+					// steady_clock is CLOCK_MONOTONIC on linux
+					m_hasHostTimeDomain |= domain == VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+				}
+			}
+		}
+
+		m_frames.resize(frameCount);
+		for (FrameQueries &frame : m_frames)
+		{
+			VkQueryPoolCreateInfo poolInfo = {};
+			poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+			poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+			poolInfo.queryCount = k_timestampQueryCount;
+			if (vkCreateQueryPool(m_device, &poolInfo, nullptr, &frame.timestampPool) != VK_SUCCESS)
+			{
+				LOG_ERROR("failed to create timestamp query pool!");
+			}
+
+			if (m_isPipelineStatisticsEnabled)
+			{
+				poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+				poolInfo.queryCount = k_maxPassesPerFrame;
+				poolInfo.pipelineStatistics = k_pipelineStatistics;
+				if (vkCreateQueryPool(m_device, &poolInfo, nullptr, &frame.statisticsPool) != VK_SUCCESS)
+				{
+					LOG_ERROR("failed to create pipeline statistics query pool!");
+				}
+			}
+		}
+		m_isEnabled = true;
+	}
+
+	void GpuProfiler::Clear()
+	{
+		for (FrameQueries &frame : m_frames)
+		{
+			vkDestroyQueryPool(m_device, frame.timestampPool, nullptr);
+			vkDestroyQueryPool(m_device, frame.statisticsPool, nullptr);
+		}
+		m_frames.clear();
+		m_isEnabled = false;
+	}
+
+	void GpuProfiler::Collect(uint32_t frameIndex)
+	{
+		if (!m_isEnabled || !m_frames[frameIndex].isRecorded)
+		{
+			return;
+		}
+		FrameQueries &frame = m_frames[frameIndex];
+		frame.isRecorded = false;
+
+		uint32_t passCount = static_cast<uint32_t>(frame.passNames.size());
+		uint32_t queryCount = FrameEndQuery(passCount) + 1;
+		uint64_t timestamps[k_timestampQueryCount];
+		// the frame fence has signaled, so this does not wait
+		if (vkGetQueryPoolResults(m_device, frame.timestampPool, 0, queryCount, sizeof(timestamps), timestamps,
+								  sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+		{
+			return;
+		}
+
+		uint64_t statistics[k_maxPassesPerFrame * 2] = {};
+		bool hasStatistics = m_isPipelineStatisticsEnabled && passCount > 0 &&
+							 vkGetQueryPoolResults(m_device, frame.statisticsPool, 0, passCount, sizeof(statistics), statistics,
+												   2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS;
+
+		auto ticksToMs = [this](uint64_t from, uint64_t to)
+		{ return static_cast<double>((to - from) & m_timestampMask) * m_timestampPeriodNs * 1e-6; };
+
+		uint64_t frameBegin = timestamps[0];
+		m_latestFrame.frameNumber = frame.frameNumber;
+		m_latestFrame.frameMs = ticksToMs(frameBegin, timestamps[FrameEndQuery(passCount)]);
+		m_latestFrame.isCalibrated = frame.isCalibrated;
+		m_latestFrame.passes.resize(passCount);
+		for (uint32_t i = 0; i < passCount; i++)
+		{
+			GpuPassTiming &pass = m_latestFrame.passes[i];
+			pass.name = frame.passNames[i];
+			pass.beginMs = ticksToMs(frameBegin, timestamps[PassBeginQuery(i)]);
+			pass.durationMs = ticksToMs(timestamps[PassBeginQuery(i)], timestamps[PassEndQuery(i)]);
+			pass.cpuBeginNs = 0;
+			if (frame.isCalibrated)
+			{
+				// signed, the pass may have started before or after the calibration sample
+				uint64_t wrappedTicks = (timestamps[PassBeginQuery(i)] - frame.calibrationTicks) & m_timestampMask;
+				int64_t deltaTicks = wrappedTicks > m_timestampMask / 2 ? -static_cast<int64_t>(m_timestampMask - wrappedTicks + 1)
+																		: static_cast<int64_t>(wrappedTicks);
+				pass.cpuBeginNs = frame.calibrationNs + static_cast<int64_t>(static_cast<double>(deltaTicks) * m_timestampPeriodNs);
+			}
+			// statistics come back in bit order, vertex before fragment invocations
+			pass.vertexInvocations = hasStatistics ? statistics[i * 2] : 0;
+			pass.fragmentInvocations = hasStatistics ? statistics[i * 2 + 1] : 0;
+		}
+	}
+
+	void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber)
+	{
+		if (!m_isEnabled)
+		{
+			return;
+		}
+		m_recording = &m_frames[frameIndex];
+		m_recording->passNames.clear();
+		m_recording->frameNumber = frameNumber;
+		m_recording->isRecorded = false;
+		m_isPassOpen = false;
+		Calibrate(*m_recording);
+
+		_vkCmdResetQueryPool(commandBuffer, m_recording->timestampPool, 0, k_timestampQueryCount);
+		if (m_isPipelineStatisticsEnabled)
+		{
+			_vkCmdResetQueryPool(commandBuffer, m_recording->statisticsPool, 0, k_maxPassesPerFrame);
+		}
+		_vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_recording->timestampPool, 0);
+	}
+
+	void GpuProfiler::EndFrame(VkCommandBuffer commandBuffer)
+	{
+		if (!m_recording)
+		{
+			return;
+		}
+		uint32_t passCount = static_cast<uint32_t>(m_recording->passNames.size());
+		_vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_recording->timestampPool, FrameEndQuery(passCount));
+		m_recording->isRecorded = true;
+		m_recording = nullptr;
+	}
+
+	void GpuProfiler::BeginPass(VkCommandBuffer commandBuffer, const char *name)
+	{
+		if (!m_recording || m_isPassOpen || m_recording->passNames.size() >= k_maxPassesPerFrame)
+		{
+			return;
+		}
+		uint32_t pass = static_cast<uint32_t>(m_recording->passNames.size());
+		m_recording->passNames.push_back(name);
+		m_isPassOpen = true;
+
+		_vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_recording->timestampPool, PassBeginQuery(pass));
+		if (m_isPipelineStatisticsEnabled)
+		{
+			_vkCmdBeginQuery(commandBuffer, m_recording->statisticsPool, pass, 0);
+		}
+	}
+
+	void GpuProfiler::EndPass(VkCommandBuffer commandBuffer)
+	{
+		if (!m_recording || !m_isPassOpen)
+		{
+			return;
+		}
+		uint32_t pass = static_cast<uint32_t>(m_recording->passNames.size()) - 1;
+		m_isPassOpen = false;
+
+		if (m_isPipelineStatisticsEnabled)
+		{
+			_vkCmdEndQuery(commandBuffer, m_recording->statisticsPool, pass);
+		}
+		_vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_recording->timestampPool, PassEndQuery(pass));
+	}
+
+	void GpuProfiler::Calibrate(FrameQueries &frame)
+	{
+		frame.isCalibrated = false;
+		if (!m_isCalibrationSupported)
+		{
+			return;
+		}
+
+		VkCalibratedTimestampInfoEXT infos[2] = {};
+		infos[0].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+		infos[0].timeDomain = VK_TIME_DOMAIN_DEVICE_EXT;
+		infos[1].sType = VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+		infos[1].timeDomain = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+		uint64_t values[2] = {};
+		uint64_t maxDeviation = 0;
+
+		if (m_hasHostTimeDomain)
+		{
+			if (_vkGetCalibratedTimestampsEXT(m_device, 2, infos, values, &maxDeviation) != VK_SUCCESS)
+			{
+				return;
+			}
+			frame.calibrationNs = static_cast<int64_t>(values[1]);
+		}
+		else
+		{
+			// no host domain matching steady_clock, bracket the device sample instead
+			int64_t before = SteadyClockNs();
+			if (_vkGetCalibratedTimestampsEXT(m_device, 1, infos, values, &maxDeviation) != VK_SUCCESS)
+			{
+				return;
+			}
+			frame.calibrationNs = before + (SteadyClockNs() - before) / 2;
+		}
+		frame.calibrationTicks = values[0];
+		frame.isCalibrated = true;
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+#include <vector>
+
+namespace JMEngine
+{
+	struct GpuPassTiming
+	{
+		std::string name;
+		// relative to the first timestamp of the frame
+		double beginMs{0.0};
+		double durationMs{0.0};
+		// steady_clock nanoseconds of the pass start, 0 without calibrated timestamps
+		int64_t cpuBeginNs{0};
+		// only with pipeline statistics enabled
+		uint64_t vertexInvocations{0};
+		uint64_t fragmentInvocations{0};
+	};
+
+	struct GpuFrameTimings
+	{
+		uint64_t frameNumber{0};
+		double frameMs{0.0};
+		bool isCalibrated{false};
+		std::vector<GpuPassTiming> passes;
+	};
+
+	// timestamp pairs around named passes in one query pool per frame in flight, results are read
+	// when the frame slot comes around again, after its fence, so the cpu never waits on them
+	class GpuProfiler final
+	{
+	public:
+		// secondary command buffers executed inside a pass inherit these
+		static constexpr VkQueryPipelineStatisticFlags k_pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+																			 VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+		// isCalibrationSupported when VK_EXT_calibrated_timestamps is enabled on the device
+		void Initialize(VkInstance instance, VkPhysicalDevice physicalDevice, VkDevice device, uint32_t queueFamilyIndex,
+						uint32_t frameCount, bool isCalibrationSupported, bool isPipelineStatisticsEnabled);
+		void Clear();
+
+		// after the slot's fence has signaled, publishes the results it carried
+		void Collect(uint32_t frameIndex);
+
+		// outside of a render pass, at the start and end of the frame's primary command buffer
+		void BeginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex, uint64_t frameNumber);
+		void EndFrame(VkCommandBuffer commandBuffer);
+
+		// passes may not nest, pipeline statistics cover a whole render pass or none of it
+		void BeginPass(VkCommandBuffer commandBuffer, const char *name);
+		void EndPass(VkCommandBuffer commandBuffer);
+
+		inline bool IsEnabled() const { return m_isEnabled; }
+		inline bool IsPipelineStatisticsEnabled() const { return m_isPipelineStatisticsEnabled; }
+		// the most recent completed frame, a few frames behind the one being recorded
+		inline const GpuFrameTimings &GetLatestFrame() const { return m_latestFrame; }
+
+	private:
+		static constexpr uint32_t k_maxPassesPerFrame = 32;
+
+		struct FrameQueries
+		{
+			VkQueryPool timestampPool{VK_NULL_HANDLE};
+			VkQueryPool statisticsPool{VK_NULL_HANDLE};
+			std::vector<std::string> passNames;
+			uint64_t frameNumber{0};
+			bool isRecorded{false};
+			// device ticks and steady_clock nanoseconds sampled together while recording
+			uint64_t calibrationTicks{0};
+			int64_t calibrationNs{0};
+			bool isCalibrated{false};
+		};
+
+		VkDevice m_device{nullptr};
+		bool m_isEnabled{false};
+		bool m_isPipelineStatisticsEnabled{false};
+		bool m_isCalibrationSupported{false};
+		bool m_hasHostTimeDomain{false};
+		double m_timestampPeriodNs{1.0};
+		uint64_t m_timestampMask{~0ull};
+
+		std::vector<FrameQueries> m_frames;
+		FrameQueries *m_recording{nullptr};
+		bool m_isPassOpen{false};
+		GpuFrameTimings m_latestFrame;
+
+		void Calibrate(FrameQueries &frame);
+
+		PFN_vkCmdWriteTimestamp _vkCmdWriteTimestamp;
+		PFN_vkCmdResetQueryPool _vkCmdResetQueryPool;
+		PFN_vkCmdBeginQuery _vkCmdBeginQuery;
+		PFN_vkCmdEndQuery _vkCmdEndQuery;
+		PFN_vkGetCalibratedTimestampsEXT _vkGetCalibratedTimestampsEXT{nullptr};
+	};
+
+	class GpuProfileScope final
+	{
+	public:
+		GpuProfileScope(GpuProfiler &profiler, VkCommandBuffer commandBuffer, const char *name)
+			: m_profiler(profiler), m_commandBuffer(commandBuffer)
+		{
+			m_profiler.BeginPass(m_commandBuffer, name);
+		}
+		~GpuProfileScope() { m_profiler.EndPass(m_commandBuffer); }
+
+	private:
+		GpuProfiler &m_profiler;
+		VkCommandBuffer m_commandBuffer;
+	};
+}
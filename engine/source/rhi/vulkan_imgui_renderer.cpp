@@ -0,0 +1,328 @@
+#include "source/rhi/vulkan_imgui_renderer.h"
+#include "source/global/macro.h"
+
+#include <imgui.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace JMEngine
+{
+	void ImGuiRenderer::Initialize(VkDevice device, VulkanMemoryAllocator *memoryAllocator, FrameUploadAllocator *uploadAllocator,
+								   PipelineLibrary *pipelineLibrary, const GraphicsPipelineDesc &desc, VkDescriptorSetLayout textureSetLayout)
+	{
+		m_device = device;
+		m_memoryAllocator = memoryAllocator;
+		m_uploadAllocator = uploadAllocator;
+		m_pipelineLibrary = pipelineLibrary;
+
+		// imgui's vertex layout with straight alpha blending, no culling since imgui does not keep a consistent winding
+		m_pipelineDesc = desc;
+		m_pipelineDesc.vertexBindings = {{0, sizeof(ImDrawVert), VK_VERTEX_INPUT_RATE_VERTEX}};
+		m_pipelineDesc.vertexAttributes = {{0, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(ImDrawVert, pos)},
+										   {1, 0, VK_FORMAT_R32G32_SFLOAT, offsetof(ImDrawVert, uv)},
+										   {2, 0, VK_FORMAT_R8G8B8A8_UNORM, offsetof(ImDrawVert, col)}};
+		m_pipelineDesc.cullMode = VK_CULL_MODE_NONE;
+		m_pipelineDesc.isBlendEnabled = true;
+		m_pipelineDesc.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+		m_pipelineDesc.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+		m_pipelineDesc.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+		m_pipelineDesc.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+		_vkCmdPipelineBarrier = (PFN_vkCmdPipelineBarrier)vkGetDeviceProcAddr(m_device, "vkCmdPipelineBarrier");
+		_vkCmdCopyBufferToImage = (PFN_vkCmdCopyBufferToImage)vkGetDeviceProcAddr(m_device, "vkCmdCopyBufferToImage");
+		_vkCmdBindPipeline = (PFN_vkCmdBindPipeline)vkGetDeviceProcAddr(m_device, "vkCmdBindPipeline");
+		_vkCmdBindDescriptorSets = (PFN_vkCmdBindDescriptorSets)vkGetDeviceProcAddr(m_device, "vkCmdBindDescriptorSets");
+		_vkCmdBindVertexBuffers = (PFN_vkCmdBindVertexBuffers)vkGetDeviceProcAddr(m_device, "vkCmdBindVertexBuffers");
+		_vkCmdBindIndexBuffer = (PFN_vkCmdBindIndexBuffer)vkGetDeviceProcAddr(m_device, "vkCmdBindIndexBuffer");
+		_vkCmdPushConstants = (PFN_vkCmdPushConstants)vkGetDeviceProcAddr(m_device, "vkCmdPushConstants");
+		_vkCmdSetViewport = (PFN_vkCmdSetViewport)vkGetDeviceProcAddr(m_device, "vkCmdSetViewport");
+		_vkCmdSetScissor = (PFN_vkCmdSetScissor)vkGetDeviceProcAddr(m_device, "vkCmdSetScissor");
+		_vkCmdDrawIndexed = (PFN_vkCmdDrawIndexed)vkGetDeviceProcAddr(m_device, "vkCmdDrawIndexed");
+
+		CreateFontTexture(textureSetLayout);
+	}
+
+	void ImGuiRenderer::Clear()
+	{
+		if (!m_device)
+		{
+			return;
+		}
+		vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+		vkDestroySampler(m_device, m_fontSampler, nullptr);
+		vkDestroyImageView(m_device, m_fontImageView, nullptr);
+		if (m_fontImage != VK_NULL_HANDLE)
+		{
+			m_memoryAllocator->DestroyImage(m_fontImage, m_fontAllocation);
+		}
+		m_fontImage = VK_NULL_HANDLE;
+		m_isFontUploaded = false;
+		m_device = nullptr;
+	}
+
+	void ImGuiRenderer::ReplaceShader(ShaderId oldShader, ShaderId newShader)
+	{
+		m_pipelineDesc.vertexShader = m_pipelineDesc.vertexShader == oldShader ? newShader : m_pipelineDesc.vertexShader;
+		m_pipelineDesc.fragmentShader = m_pipelineDesc.fragmentShader == oldShader ? newShader : m_pipelineDesc.fragmentShader;
+	}
+
+	void ImGuiRenderer::CreateFontTexture(VkDescriptorSetLayout textureSetLayout)
+	{
+		unsigned char *pixels;
+		int width;
+		int height;
+		ImGui::GetIO().Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+		m_fontWidth = static_cast<uint32_t>(width);
+		m_fontHeight = static_cast<uint32_t>(height);
+
+		// a quarter of the rgba atlas, the view swizzles coverage into alpha under white
+		VkImageCreateInfo imageInfo = {};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.format = VK_FORMAT_R8_UNORM;
+		imageInfo.extent = {m_fontWidth, m_fontHeight, 1};
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		if (!m_memoryAllocator->CreateImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0, m_fontImage, m_fontAllocation))
+		{
+			LOG_ERROR("failed to create imgui font image!");
+		}
+
+		VkImageViewCreateInfo viewInfo = {};
+		viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		viewInfo.image = m_fontImage;
+		viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		viewInfo.format = VK_FORMAT_R8_UNORM;
+		viewInfo.components = {VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_ONE, VK_COMPONENT_SWIZZLE_R};
+		viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		viewInfo.subresourceRange.levelCount = 1;
+		viewInfo.subresourceRange.layerCount = 1;
+		if (vkCreateImageView(m_device, &viewInfo, nullptr, &m_fontImageView) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create imgui font image view!");
+		}
+
+		VkSamplerCreateInfo samplerInfo = {};
+		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+		samplerInfo.magFilter = VK_FILTER_LINEAR;
+		samplerInfo.minFilter = VK_FILTER_LINEAR;
+		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+		samplerInfo.maxLod = 1000.0f;
+		samplerInfo.maxAnisotropy = 1.0f;
+		if (vkCreateSampler(m_device, &samplerInfo, nullptr, &m_fontSampler) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create imgui font sampler!");
+		}
+
+		VkDescriptorPoolSize poolSize = {};
+		poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		poolSize.descriptorCount = 1;
+
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		poolInfo.maxSets = 1;
+		if (vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create imgui descriptor pool!");
+		}
+
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = m_descriptorPool;
+		allocInfo.descriptorSetCount = 1;
+		allocInfo.pSetLayouts = &textureSetLayout;
+		if (vkAllocateDescriptorSets(m_device, &allocInfo, &m_fontDescriptorSet) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to allocate imgui descriptor set!");
+		}
+
+		VkDescriptorImageInfo descriptorImageInfo = {};
+		descriptorImageInfo.sampler = m_fontSampler;
+		descriptorImageInfo.imageView = m_fontImageView;
+		descriptorImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+		VkWriteDescriptorSet descriptorWrite = {};
+		descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descriptorWrite.dstSet = m_fontDescriptorSet;
+		descriptorWrite.dstBinding = 0;
+		descriptorWrite.descriptorCount = 1;
+		descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		descriptorWrite.pImageInfo = &descriptorImageInfo;
+		vkUpdateDescriptorSets(m_device, 1, &descriptorWrite, 0, nullptr);
+
+		// texture ids are descriptor sets, as with imgui_impl_vulkan
+		ImGui::GetIO().Fonts->SetTexID((ImTextureID)m_fontDescriptorSet);
+	}
+
+	void ImGuiRenderer::RecordUploads(VkCommandBuffer commandBuffer)
+	{
+		if (m_isFontUploaded || m_fontImage == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		unsigned char *pixels;
+		int width;
+		int height;
+		ImGui::GetIO().Fonts->GetTexDataAsAlpha8(&pixels, &width, &height);
+		VkDeviceSize size = static_cast<VkDeviceSize>(width) * height;
+		UploadAllocation staging = m_uploadAllocator->Allocate(size, 16);
+		if (!staging.IsValid())
+		{
+			// retried next frame when the ring has room
+			return;
+		}
+		memcpy(staging.mappedData, pixels, size);
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = m_fontImage;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.layerCount = 1;
+		_vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+							  0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkBufferImageCopy region = {};
+		region.bufferOffset = staging.offset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = {m_fontWidth, m_fontHeight, 1};
+		_vkCmdCopyBufferToImage(commandBuffer, staging.buffer, m_fontImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		_vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+							  0, nullptr, 0, nullptr, 1, &barrier);
+
+		m_isFontUploaded = true;
+	}
+
+	bool ImGuiRenderer::RecordDraws(VkCommandBuffer commandBuffer, const RenderGraphPassContext &context)
+	{
+		VkExtent2D extent = context.extent;
+		ImDrawData *drawData = ImGui::GetDrawData();
+		if (!m_isFontUploaded || !drawData || drawData->TotalVtxCount == 0 || extent.width == 0 || extent.height == 0)
+		{
+			return false;
+		}
+
+		// compiles in the background like every other pipeline, the overlay appears once it is ready
+		m_pipelineDesc.renderPass = context.renderPass;
+		if (context.renderPass == VK_NULL_HANDLE)
+		{
+			m_pipelineDesc.colorFormats.assign(context.colorFormats.begin(), context.colorFormats.end());
+			m_pipelineDesc.depthFormat = context.depthFormat;
+		}
+		VkPipeline pipeline = m_pipelineLibrary->Request(m_pipelineDesc);
+		if (pipeline == VK_NULL_HANDLE)
+		{
+			return false;
+		}
+
+		// a few tens of kilobytes a frame, written once and read once so the ring is the right place for it
+		VkDeviceSize vertexSize = static_cast<VkDeviceSize>(drawData->TotalVtxCount) * sizeof(ImDrawVert);
+		VkDeviceSize indexSize = static_cast<VkDeviceSize>(drawData->TotalIdxCount) * sizeof(ImDrawIdx);
+		UploadAllocation vertices = m_uploadAllocator->Allocate(vertexSize, sizeof(float));
+		UploadAllocation indices = m_uploadAllocator->Allocate(indexSize, sizeof(uint32_t));
+		if (!vertices.IsValid() || !indices.IsValid())
+		{
+			return false;
+		}
+
+		ImDrawVert *vertexDst = static_cast<ImDrawVert *>(vertices.mappedData);
+		ImDrawIdx *indexDst = static_cast<ImDrawIdx *>(indices.mappedData);
+		for (int i = 0; i < drawData->CmdListsCount; i++)
+		{
+			const ImDrawList *cmdList = drawData->CmdLists[i];
+			memcpy(vertexDst, cmdList->VtxBuffer.Data, cmdList->VtxBuffer.Size * sizeof(ImDrawVert));
+			memcpy(indexDst, cmdList->IdxBuffer.Data, cmdList->IdxBuffer.Size * sizeof(ImDrawIdx));
+			vertexDst += cmdList->VtxBuffer.Size;
+			indexDst += cmdList->IdxBuffer.Size;
+		}
+
+		VkViewport viewport = {};
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.maxDepth = 1.0f;
+
+		_vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		_vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		_vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertices.buffer, &vertices.offset);
+		_vkCmdBindIndexBuffer(commandBuffer, indices.buffer, indices.offset, sizeof(ImDrawIdx) == 2 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+
+		float transform[4];
+		transform[0] = 2.0f / drawData->DisplaySize.x;
+		transform[1] = 2.0f / drawData->DisplaySize.y;
+		transform[2] = -1.0f - drawData->DisplayPos.x * transform[0];
+		transform[3] = -1.0f - drawData->DisplayPos.y * transform[1];
+		_vkCmdPushConstants(commandBuffer, m_pipelineDesc.layout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(transform), transform);
+
+		ImVec2 clipOffset = drawData->DisplayPos;
+		ImVec2 clipScale = drawData->FramebufferScale;
+		VkDescriptorSet boundSet = VK_NULL_HANDLE;
+		uint32_t vertexOffset = 0;
+		uint32_t indexOffset = 0;
+		for (int i = 0; i < drawData->CmdListsCount; i++)
+		{
+			const ImDrawList *cmdList = drawData->CmdLists[i];
+			for (const ImDrawCmd &cmd : cmdList->CmdBuffer)
+			{
+				if (cmd.UserCallback)
+				{
+					// only the reset callback is meaningful to a renderer without render state to restore
+					if (cmd.UserCallback != ImDrawCallback_ResetRenderState)
+					{
+						cmd.UserCallback(cmdList, &cmd);
+					}
+					continue;
+				}
+
+				float clipMinX = std::max((cmd.ClipRect.x - clipOffset.x) * clipScale.x, 0.0f);
+				float clipMinY = std::max((cmd.ClipRect.y - clipOffset.y) * clipScale.y, 0.0f);
+				float clipMaxX = std::min((cmd.ClipRect.z - clipOffset.x) * clipScale.x, viewport.width);
+				float clipMaxY = std::min((cmd.ClipRect.w - clipOffset.y) * clipScale.y, viewport.height);
+				if (clipMaxX <= clipMinX || clipMaxY <= clipMinY)
+				{
+					continue;
+				}
+
+				VkRect2D scissor = {};
+				scissor.offset = {static_cast<int32_t>(clipMinX), static_cast<int32_t>(clipMinY)};
+				scissor.extent = {static_cast<uint32_t>(clipMaxX - clipMinX), static_cast<uint32_t>(clipMaxY - clipMinY)};
+				_vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+				VkDescriptorSet textureSet = (VkDescriptorSet)cmd.GetTexID();
+				if (textureSet != boundSet)
+				{
+					_vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineDesc.layout, 0, 1, &textureSet, 0, nullptr);
+					boundSet = textureSet;
+				}
+				_vkCmdDrawIndexed(commandBuffer, cmd.ElemCount, 1, indexOffset + cmd.IdxOffset, static_cast<int32_t>(vertexOffset + cmd.VtxOffset), 0);
+			}
+			vertexOffset += cmdList->VtxBuffer.Size;
+			indexOffset += cmdList->IdxBuffer.Size;
+		}
+		return true;
+	}
+}
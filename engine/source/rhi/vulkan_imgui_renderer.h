@@ -0,0 +1,62 @@
+#pragma once
+
+#include "source/rhi/render_graph.h"
+#include "source/rhi/vulkan_memory_allocator.h"
+#include "source/rhi/vulkan_pipeline_library.h"
+#include "source/rhi/vulkan_upload_allocator.h"
+
+#include <vulkan/vulkan.h>
+
+namespace JMEngine
+{
+	// draws imgui's render output with a pipeline from the library, vertices and indices are written
+	// straight into the frame's upload ring and the font atlas is staged through it once
+	class ImGuiRenderer final
+	{
+	public:
+		// desc carries the imgui shaders and their layout, textureSetLayout is its set 0,
+		// the current imgui context's font atlas is built here
+		void Initialize(VkDevice device, VulkanMemoryAllocator *memoryAllocator, FrameUploadAllocator *uploadAllocator,
+						PipelineLibrary *pipelineLibrary, const GraphicsPipelineDesc &desc, VkDescriptorSetLayout textureSetLayout);
+		// the device must be idle
+		void Clear();
+
+		void ReplaceShader(ShaderId oldShader, ShaderId newShader);
+
+		// outside of a render pass, before the first RecordDraws
+		void RecordUploads(VkCommandBuffer commandBuffer);
+		// inside the pass, after ImGui::Render, false when there was nothing to draw. commandBuffer is the
+		// context's or a secondary one recorded for its pass
+		bool RecordDraws(VkCommandBuffer commandBuffer, const RenderGraphPassContext &context);
+
+	private:
+		VkDevice m_device{nullptr};
+		VulkanMemoryAllocator *m_memoryAllocator{nullptr};
+		FrameUploadAllocator *m_uploadAllocator{nullptr};
+		PipelineLibrary *m_pipelineLibrary{nullptr};
+		GraphicsPipelineDesc m_pipelineDesc;
+
+		VkImage m_fontImage{VK_NULL_HANDLE};
+		VulkanAllocation m_fontAllocation;
+		VkImageView m_fontImageView{VK_NULL_HANDLE};
+		VkSampler m_fontSampler{VK_NULL_HANDLE};
+		VkDescriptorPool m_descriptorPool{VK_NULL_HANDLE};
+		VkDescriptorSet m_fontDescriptorSet{VK_NULL_HANDLE};
+		uint32_t m_fontWidth{0};
+		uint32_t m_fontHeight{0};
+		bool m_isFontUploaded{false};
+
+		void CreateFontTexture(VkDescriptorSetLayout textureSetLayout);
+
+		PFN_vkCmdPipelineBarrier _vkCmdPipelineBarrier;
+		PFN_vkCmdCopyBufferToImage _vkCmdCopyBufferToImage;
+		PFN_vkCmdBindPipeline _vkCmdBindPipeline;
+		PFN_vkCmdBindDescriptorSets _vkCmdBindDescriptorSets;
+		PFN_vkCmdBindVertexBuffers _vkCmdBindVertexBuffers;
+		PFN_vkCmdBindIndexBuffer _vkCmdBindIndexBuffer;
+		PFN_vkCmdPushConstants _vkCmdPushConstants;
+		PFN_vkCmdSetViewport _vkCmdSetViewport;
+		PFN_vkCmdSetScissor _vkCmdSetScissor;
+		PFN_vkCmdDrawIndexed _vkCmdDrawIndexed;
+	};
+}
@@ -0,0 +1,185 @@
+#include "source/rhi/vulkan_layout_cache.h"
+#include "source/global/macro.h"
+
+#include <algorithm>
+
+namespace JMEngine
+{
+	void PipelineLayoutCache::Initialize(VkDevice device)
+	{
+		m_device = device;
+	}
+
+	void PipelineLayoutCache::Clear()
+	{
+		for (auto &[key, pipelineLayout] : m_pipelineLayouts)
+		{
+			vkDestroyPipelineLayout(m_device, pipelineLayout, nullptr);
+		}
+		m_pipelineLayouts.clear();
+
+		for (auto &[key, setLayout] : m_setLayouts)
+		{
+			vkDestroyDescriptorSetLayout(m_device, setLayout, nullptr);
+		}
+		m_setLayouts.clear();
+	}
+
+	VkDescriptorSetLayout PipelineLayoutCache::GetSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings)
+	{
+		// immutable samplers are not part of the key, sets using them are built directly
+		std::sort(bindings.begin(), bindings.end(), [](const VkDescriptorSetLayoutBinding &a, const VkDescriptorSetLayoutBinding &b)
+				  { return a.binding < b.binding; });
+
+		SetLayoutKey key;
+		key.reserve(bindings.size() * 4);
+		for (const VkDescriptorSetLayoutBinding &binding : bindings)
+		{
+			key.insert(key.end(), {binding.binding, static_cast<uint32_t>(binding.descriptorType), binding.descriptorCount, binding.stageFlags});
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_setLayouts.find(key);
+		if (it != m_setLayouts.end())
+		{
+			return it->second;
+		}
+
+		VkDescriptorSetLayoutCreateInfo layoutInfo = {};
+		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+		layoutInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+		layoutInfo.pBindings = bindings.data();
+
+		VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+		if (vkCreateDescriptorSetLayout(m_device, &layoutInfo, nullptr, &setLayout) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create descriptor set layout!");
+			return VK_NULL_HANDLE;
+		}
+		m_setLayouts.emplace(std::move(key), setLayout);
+		return setLayout;
+	}
+
+	VkPipelineLayout PipelineLayoutCache::GetPipelineLayout(const std::vector<VkDescriptorSetLayout> &setLayouts, std::vector<VkPushConstantRange> pushConstantRanges)
+	{
+		std::sort(pushConstantRanges.begin(), pushConstantRanges.end(), [](const VkPushConstantRange &a, const VkPushConstantRange &b)
+				  { return a.offset != b.offset ? a.offset < b.offset : a.stageFlags < b.stageFlags; });
+
+		PipelineLayoutKey key;
+		key.reserve(setLayouts.size() + pushConstantRanges.size() * 3 + 1);
+		key.push_back(setLayouts.size());
+		for (VkDescriptorSetLayout setLayout : setLayouts)
+		{
+			key.push_back(reinterpret_cast<uint64_t>(setLayout));
+		}
+		for (const VkPushConstantRange &range : pushConstantRanges)
+		{
+			key.insert(key.end(), {range.stageFlags, range.offset, range.size});
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_pipelineLayouts.find(key);
+		if (it != m_pipelineLayouts.end())
+		{
+			return it->second;
+		}
+
+		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
+		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+		pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+		pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+		pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+		pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+		VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+		if (vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create pipeline layout!");
+			return VK_NULL_HANDLE;
+		}
+		m_pipelineLayouts.emplace(std::move(key), pipelineLayout);
+		return pipelineLayout;
+	}
+
+	ReflectedPipelineLayout PipelineLayoutCache::GetReflectedLayout(const std::vector<const ShaderReflection *> &shaders, const std::vector<DescriptorBindingSlot> &dynamicBuffers)
+	{
+		// set -> bindings, a binding used by several stages is visible to all of them
+		std::vector<std::vector<VkDescriptorSetLayoutBinding>> sets;
+		std::vector<VkPushConstantRange> pushConstantRanges;
+		for (const ShaderReflection *shader : shaders)
+		{
+			for (const ShaderResourceBinding &resource : shader->bindings)
+			{
+				if (sets.size() <= resource.set)
+				{
+					sets.resize(resource.set + 1);
+				}
+				std::vector<VkDescriptorSetLayoutBinding> &bindings = sets[resource.set];
+				auto it = std::find_if(bindings.begin(), bindings.end(), [&resource](const VkDescriptorSetLayoutBinding &binding)
+									   { return binding.binding == resource.binding; });
+				if (it != bindings.end())
+				{
+					if (it->descriptorType != resource.type || it->descriptorCount != std::max(resource.count, 1u))
+					{
+						LOG_WARN("stages disagree on set " + std::to_string(resource.set) + " binding " + std::to_string(resource.binding));
+					}
+					it->stageFlags |= resource.stages;
+					continue;
+				}
+
+				VkDescriptorSetLayoutBinding binding = {};
+				binding.binding = resource.binding;
+				binding.descriptorType = resource.type;
+				// runtime sized arrays need descriptor indexing, a single element is bound without it
+				binding.descriptorCount = std::max(resource.count, 1u);
+				binding.stageFlags = resource.stages;
+				bindings.push_back(binding);
+			}
+
+			for (const VkPushConstantRange &range : shader->pushConstantRanges)
+			{
+				auto it = std::find_if(pushConstantRanges.begin(), pushConstantRanges.end(), [&range](const VkPushConstantRange &other)
+									   { return other.offset == range.offset && other.size == range.size; });
+				if (it != pushConstantRanges.end())
+				{
+					it->stageFlags |= range.stageFlags;
+				}
+				else
+				{
+					pushConstantRanges.push_back(range);
+				}
+			}
+		}
+
+		for (const DescriptorBindingSlot &slot : dynamicBuffers)
+		{
+			if (slot.set >= sets.size())
+			{
+				continue;
+			}
+			for (VkDescriptorSetLayoutBinding &binding : sets[slot.set])
+			{
+				if (binding.binding != slot.binding)
+				{
+					continue;
+				}
+				if (binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+				{
+					binding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+				}
+				else if (binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+				{
+					binding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+				}
+			}
+		}
+
+		ReflectedPipelineLayout layout;
+		for (auto &bindings : sets)
+		{
+			layout.setLayouts.push_back(GetSetLayout(bindings));
+		}
+		layout.pipelineLayout = GetPipelineLayout(layout.setLayouts, pushConstantRanges);
+		return layout;
+	}
+}
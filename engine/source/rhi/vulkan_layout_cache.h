@@ -0,0 +1,50 @@
+#pragma once
+
+#include "source/rhi/spirv_reflection.h"
+
+#include <vulkan/vulkan.h>
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+namespace JMEngine
+{
+	struct DescriptorBindingSlot
+	{
+		uint32_t set{0};
+		uint32_t binding{0};
+	};
+
+	struct ReflectedPipelineLayout
+	{
+		VkPipelineLayout pipelineLayout{VK_NULL_HANDLE};
+		// indexed by set number, sets the shaders skip get an empty layout
+		std::vector<VkDescriptorSetLayout> setLayouts;
+	};
+
+	// descriptor set and pipeline layouts deduplicated by content, pipelines built from shaders
+	// with the same interface share the same handles and keep their bound sets compatible
+	class PipelineLayoutCache final
+	{
+	public:
+		void Initialize(VkDevice device);
+		void Clear();
+
+		VkDescriptorSetLayout GetSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings);
+		VkPipelineLayout GetPipelineLayout(const std::vector<VkDescriptorSetLayout> &setLayouts, std::vector<VkPushConstantRange> pushConstantRanges);
+
+		// merges the interface of every stage, uniform buffers listed in dynamicBuffers become UNIFORM_BUFFER_DYNAMIC
+		// and storage buffers STORAGE_BUFFER_DYNAMIC
+		ReflectedPipelineLayout GetReflectedLayout(const std::vector<const ShaderReflection *> &shaders, const std::vector<DescriptorBindingSlot> &dynamicBuffers = {});
+
+	private:
+		using SetLayoutKey = std::vector<uint32_t>;
+		using PipelineLayoutKey = std::vector<uint64_t>;
+
+		VkDevice m_device{nullptr};
+		std::mutex m_mutex;
+		std::map<SetLayoutKey, VkDescriptorSetLayout> m_setLayouts;
+		std::map<PipelineLayoutKey, VkPipelineLayout> m_pipelineLayouts;
+	};
+}
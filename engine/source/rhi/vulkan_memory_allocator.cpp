@@ -0,0 +1,452 @@
+#include "source/rhi/vulkan_memory_allocator.h"
+#include "source/global/macro.h"
+
+#include <algorithm>
+#include <bit>
+
+namespace JMEngine
+{
+	void VulkanMemoryAllocator::Initialize(VkDevice device, VkPhysicalDevice physicalDevice, bool isDedicatedAllocationEnabled, VkDeviceSize blockSize)
+	{
+		m_device = device;
+		m_physicalDevice = physicalDevice;
+		m_blockSize = blockSize;
+		m_isDedicatedAllocationEnabled = isDedicatedAllocationEnabled;
+
+		vkGetPhysicalDeviceMemoryProperties(m_physicalDevice, &m_memoryProperties);
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+		m_nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+		m_maxAllocationCount = properties.limits.maxMemoryAllocationCount;
+
+		m_pools.resize(m_memoryProperties.memoryTypeCount * 2);
+		for (uint32_t i = 0; i < m_pools.size(); i++)
+		{
+			m_pools[i].memoryTypeIndex = i / 2;
+			m_pools[i].isLinear = i % 2;
+		}
+		m_dedicatedCounts.assign(m_memoryProperties.memoryTypeCount, 0);
+		m_dedicatedBytes.assign(m_memoryProperties.memoryTypeCount, 0);
+	}
+
+	void VulkanMemoryAllocator::Clear()
+	{
+		for (auto &pool : m_pools)
+		{
+			for (auto &block : pool.blocks)
+			{
+				if (block)
+				{
+					if (!block->allocator.IsEmpty())
+					{
+						LOG_WARN("memory block destroyed with " + std::to_string(block->allocator.GetAllocationCount()) + " live allocations");
+					}
+					FreeDeviceMemory(block->memory, block->mappedData != nullptr);
+				}
+			}
+		}
+		m_pools.clear();
+
+		uint32_t dedicatedCount = 0;
+		for (uint32_t count : m_dedicatedCounts)
+		{
+			dedicatedCount += count;
+		}
+		if (dedicatedCount > 0)
+		{
+			LOG_WARN(std::to_string(dedicatedCount) + " dedicated allocations leaked");
+		}
+	}
+
+	bool VulkanMemoryAllocator::Allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags requiredFlags, VkMemoryPropertyFlags preferredFlags,
+										 bool isLinear, bool isDedicated, VulkanAllocation &allocation, VkBuffer buffer, VkImage image)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		// rank every compatible type, flags nobody asked for (lazily allocated, host visible vram) count against it
+		std::vector<std::pair<int, uint32_t>> candidates;
+		for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++)
+		{
+			VkMemoryPropertyFlags flags = m_memoryProperties.memoryTypes[i].propertyFlags;
+			if ((requirements.memoryTypeBits & (1 << i)) && (flags & requiredFlags) == requiredFlags)
+			{
+				int score = 4 * std::popcount(flags & preferredFlags) - std::popcount(flags & ~(requiredFlags | preferredFlags));
+				candidates.push_back({score, i});
+			}
+		}
+		std::stable_sort(candidates.begin(),
+						 candidates.end(),
+						 [](const std::pair<int, uint32_t> &c1, const std::pair<int, uint32_t> &c2)
+						 {
+							 return c1.first > c2.first;
+						 });
+
+		// a full heap falls back to the next best type
+		for (const auto &candidate : candidates)
+		{
+			if (AllocateFromType(candidate.second, requirements, isLinear, isDedicated, buffer, image, allocation))
+			{
+				return true;
+			}
+		}
+
+		LOG_ERROR("failed to allocate " + std::to_string(requirements.size) + " bytes of device memory!");
+		return false;
+	}
+
+	void VulkanMemoryAllocator::Free(VulkanAllocation &allocation)
+	{
+		if (allocation.memory == VK_NULL_HANDLE)
+		{
+			return;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		if (allocation.IsDedicated())
+		{
+			FreeDeviceMemory(allocation.memory, allocation.mappedData != nullptr);
+			m_dedicatedCounts[allocation.memoryTypeIndex]--;
+			m_dedicatedBytes[allocation.memoryTypeIndex] -= allocation.size;
+			allocation = {};
+			return;
+		}
+
+		MemoryPool &pool = m_pools[allocation.poolIndex];
+		std::unique_ptr<MemoryBlock> &block = pool.blocks[allocation.blockIndex];
+		block->allocator.Free(allocation.handle);
+
+		// keep one empty block around so a single resource going up and down does not thrash vkAllocateMemory
+		if (block->allocator.IsEmpty())
+		{
+			bool hasOtherEmptyBlock = false;
+			for (const auto &otherBlock : pool.blocks)
+			{
+				hasOtherEmptyBlock |= otherBlock && otherBlock != block && otherBlock->allocator.IsEmpty();
+			}
+			if (hasOtherEmptyBlock)
+			{
+				FreeDeviceMemory(block->memory, block->mappedData != nullptr);
+				block.reset();
+			}
+		}
+		allocation = {};
+	}
+
+	bool VulkanMemoryAllocator::CreateBuffer(const VkBufferCreateInfo &bufferInfo, VkMemoryPropertyFlags requiredFlags, VkMemoryPropertyFlags preferredFlags,
+											 VkBuffer &buffer, VulkanAllocation &allocation)
+	{
+		if (vkCreateBuffer(m_device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create buffer!");
+			return false;
+		}
+
+		VkMemoryRequirements memoryRequirements;
+		vkGetBufferMemoryRequirements(m_device, buffer, &memoryRequirements);
+
+		if (!Allocate(memoryRequirements, requiredFlags, preferredFlags, true, false, allocation, buffer))
+		{
+			vkDestroyBuffer(m_device, buffer, nullptr);
+			buffer = VK_NULL_HANDLE;
+			return false;
+		}
+		vkBindBufferMemory(m_device, buffer, allocation.memory, allocation.offset);
+		return true;
+	}
+
+	void VulkanMemoryAllocator::DestroyBuffer(VkBuffer buffer, VulkanAllocation &allocation)
+	{
+		vkDestroyBuffer(m_device, buffer, nullptr);
+		Free(allocation);
+	}
+
+	bool VulkanMemoryAllocator::CreateImage(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags requiredFlags, VkMemoryPropertyFlags preferredFlags,
+											VkImage &image, VulkanAllocation &allocation, bool isDedicated)
+	{
+		if (vkCreateImage(m_device, &imageInfo, nullptr, &image) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create image!");
+			return false;
+		}
+
+		VkMemoryRequirements memoryRequirements;
+		vkGetImageMemoryRequirements(m_device, image, &memoryRequirements);
+
+		bool isLinear = imageInfo.tiling == VK_IMAGE_TILING_LINEAR;
+		if (!Allocate(memoryRequirements, requiredFlags, preferredFlags, isLinear, isDedicated, allocation, VK_NULL_HANDLE, image))
+		{
+			vkDestroyImage(m_device, image, nullptr);
+			image = VK_NULL_HANDLE;
+			return false;
+		}
+		vkBindImageMemory(m_device, image, allocation.memory, allocation.offset);
+		return true;
+	}
+
+	void VulkanMemoryAllocator::DestroyImage(VkImage image, VulkanAllocation &allocation)
+	{
+		vkDestroyImage(m_device, image, nullptr);
+		Free(allocation);
+	}
+
+	bool VulkanMemoryAllocator::IsHostCoherent(const VulkanAllocation &allocation) const
+	{
+		return m_memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	}
+
+	bool VulkanMemoryAllocator::HasMemoryType(VkMemoryPropertyFlags flags) const
+	{
+		for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++)
+		{
+			if ((m_memoryProperties.memoryTypes[i].propertyFlags & flags) == flags)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void VulkanMemoryAllocator::Flush(const VulkanAllocation &allocation, VkDeviceSize offset, VkDeviceSize size)
+	{
+		if (IsHostCoherent(allocation))
+		{
+			return;
+		}
+
+		VkMappedMemoryRange range;
+		MappedRange(allocation, offset, size, range);
+		vkFlushMappedMemoryRanges(m_device, 1, &range);
+	}
+
+	void VulkanMemoryAllocator::Invalidate(const VulkanAllocation &allocation, VkDeviceSize offset, VkDeviceSize size)
+	{
+		if (IsHostCoherent(allocation))
+		{
+			return;
+		}
+
+		VkMappedMemoryRange range;
+		MappedRange(allocation, offset, size, range);
+		vkInvalidateMappedMemoryRanges(m_device, 1, &range);
+	}
+
+	std::vector<MemoryHeapStats> VulkanMemoryAllocator::GetHeapStats()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		std::vector<MemoryHeapStats> heapStats(m_memoryProperties.memoryHeapCount);
+		std::vector<VkDeviceSize> freeBytes(m_memoryProperties.memoryHeapCount, 0);
+		std::vector<VkDeviceSize> scatteredBytes(m_memoryProperties.memoryHeapCount, 0);
+		for (uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; i++)
+		{
+			heapStats[i].heapIndex = i;
+			heapStats[i].heapSize = m_memoryProperties.memoryHeaps[i].size;
+			heapStats[i].flags = m_memoryProperties.memoryHeaps[i].flags;
+		}
+
+		for (const auto &pool : m_pools)
+		{
+			uint32_t heapIndex = m_memoryProperties.memoryTypes[pool.memoryTypeIndex].heapIndex;
+			MemoryHeapStats &stats = heapStats[heapIndex];
+			for (const auto &block : pool.blocks)
+			{
+				if (!block)
+				{
+					continue;
+				}
+				stats.blockCount++;
+				stats.blockBytes += block->allocator.GetSize();
+				stats.allocationCount += block->allocator.GetAllocationCount();
+				stats.usedBytes += block->allocator.GetUsedSize();
+				VkDeviceSize blockFreeBytes = block->allocator.GetSize() - block->allocator.GetUsedSize();
+				VkDeviceSize blockLargestFreeRange = block->allocator.GetLargestFreeRange();
+				stats.largestFreeRange = std::max(stats.largestFreeRange, blockLargestFreeRange);
+				freeBytes[heapIndex] += blockFreeBytes;
+				// a range never spans blocks, so free space is only scattered relative to its own block's largest range
+				scatteredBytes[heapIndex] += blockFreeBytes - blockLargestFreeRange;
+			}
+		}
+
+		for (uint32_t i = 0; i < m_memoryProperties.memoryTypeCount; i++)
+		{
+			MemoryHeapStats &stats = heapStats[m_memoryProperties.memoryTypes[i].heapIndex];
+			stats.dedicatedCount += m_dedicatedCounts[i];
+			stats.dedicatedBytes += m_dedicatedBytes[i];
+		}
+
+		for (uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; i++)
+		{
+			if (freeBytes[i] > 0)
+			{
+				heapStats[i].fragmentation = static_cast<float>(scatteredBytes[i]) / static_cast<float>(freeBytes[i]);
+			}
+		}
+		return heapStats;
+	}
+
+	bool VulkanMemoryAllocator::AllocateFromType(uint32_t memoryTypeIndex, const VkMemoryRequirements &requirements, bool isLinear, bool isDedicated,
+												 VkBuffer buffer, VkImage image, VulkanAllocation &allocation)
+	{
+		VkDeviceSize blockSize = GetBlockSize(memoryTypeIndex);
+
+		if (isDedicated || requirements.size > blockSize / 2)
+		{
+			// tells the driver the memory belongs to this one resource, render graph slots alias several and pass no handle
+			VkMemoryDedicatedAllocateInfoKHR dedicatedInfo = {};
+			dedicatedInfo.sType = VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO_KHR;
+			dedicatedInfo.buffer = buffer;
+			dedicatedInfo.image = image;
+			bool hasResource = buffer != VK_NULL_HANDLE || image != VK_NULL_HANDLE;
+
+			VkDeviceMemory memory;
+			void *mappedData;
+			if (!AllocateDeviceMemory(memoryTypeIndex, requirements.size, memory, mappedData,
+									  m_isDedicatedAllocationEnabled && hasResource ? &dedicatedInfo : nullptr))
+			{
+				return false;
+			}
+
+			allocation = {};
+			allocation.memory = memory;
+			allocation.offset = 0;
+			allocation.size = requirements.size;
+			allocation.mappedData = mappedData;
+			allocation.memoryTypeIndex = memoryTypeIndex;
+			m_dedicatedCounts[memoryTypeIndex]++;
+			m_dedicatedBytes[memoryTypeIndex] += requirements.size;
+			return true;
+		}
+
+		uint32_t poolIndex = memoryTypeIndex * 2 + (isLinear ? 1 : 0);
+		MemoryPool &pool = m_pools[poolIndex];
+
+		// Flush and Invalidate widen ranges to whole atoms, neighbours in non coherent memory must not share one
+		VkDeviceSize size = requirements.size;
+		VkDeviceSize alignment = requirements.alignment;
+		VkMemoryPropertyFlags flags = m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+		if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+		{
+			size = (size + m_nonCoherentAtomSize - 1) / m_nonCoherentAtomSize * m_nonCoherentAtomSize;
+			alignment = std::max(alignment, m_nonCoherentAtomSize);
+		}
+
+		auto allocateFromBlock = [&](uint32_t blockIndex)
+		{
+			MemoryBlock &block = *pool.blocks[blockIndex];
+			VkDeviceSize offset;
+			uint32_t handle = block.allocator.Allocate(size, alignment, offset);
+			if (handle == TlsfAllocator::k_invalidHandle)
+			{
+				return false;
+			}
+
+			allocation = {};
+			allocation.memory = block.memory;
+			allocation.offset = offset;
+			allocation.size = requirements.size;
+			allocation.mappedData = block.mappedData ? static_cast<char *>(block.mappedData) + offset : nullptr;
+			allocation.memoryTypeIndex = memoryTypeIndex;
+			allocation.poolIndex = poolIndex;
+			allocation.blockIndex = blockIndex;
+			allocation.handle = handle;
+			return true;
+		};
+
+		for (uint32_t i = 0; i < pool.blocks.size(); i++)
+		{
+			if (pool.blocks[i] && allocateFromBlock(i))
+			{
+				return true;
+			}
+		}
+
+		auto block = std::make_unique<MemoryBlock>();
+		if (!AllocateDeviceMemory(memoryTypeIndex, blockSize, block->memory, block->mappedData))
+		{
+			return false;
+		}
+		block->allocator.Initialize(blockSize);
+
+		// reuse a released slot so block indices held by live allocations stay valid
+		auto freeSlot = std::find(pool.blocks.begin(), pool.blocks.end(), nullptr);
+		uint32_t blockIndex = static_cast<uint32_t>(freeSlot - pool.blocks.begin());
+		if (freeSlot == pool.blocks.end())
+		{
+			pool.blocks.push_back(std::move(block));
+		}
+		else
+		{
+			*freeSlot = std::move(block);
+		}
+		return allocateFromBlock(blockIndex);
+	}
+
+	bool VulkanMemoryAllocator::AllocateDeviceMemory(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory &memory, void *&mappedData,
+													 const void *allocateNext)
+	{
+		if (m_deviceAllocationCount >= m_maxAllocationCount)
+		{
+			LOG_ERROR("maxMemoryAllocationCount reached!");
+			return false;
+		}
+
+		VkMemoryAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.pNext = allocateNext;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+		if (vkAllocateMemory(m_device, &allocInfo, nullptr, &memory) != VK_SUCCESS)
+		{
+			return false;
+		}
+		m_deviceAllocationCount++;
+
+		mappedData = nullptr;
+		if (m_memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			vkMapMemory(m_device, memory, 0, VK_WHOLE_SIZE, 0, &mappedData);
+		}
+		return true;
+	}
+
+	void VulkanMemoryAllocator::FreeDeviceMemory(VkDeviceMemory memory, bool isMapped)
+	{
+		if (isMapped)
+		{
+			vkUnmapMemory(m_device, memory);
+		}
+		vkFreeMemory(m_device, memory, nullptr);
+		m_deviceAllocationCount--;
+	}
+
+	VkDeviceSize VulkanMemoryAllocator::GetBlockSize(uint32_t memoryTypeIndex) const
+	{
+		// small heaps (e.g. 256MB of host visible vram) get smaller blocks
+		uint32_t heapIndex = m_memoryProperties.memoryTypes[memoryTypeIndex].heapIndex;
+		VkDeviceSize heapSize = m_memoryProperties.memoryHeaps[heapIndex].size;
+		return std::min(m_blockSize, std::max<VkDeviceSize>(heapSize / 8, 1ull << 20));
+	}
+
+	void VulkanMemoryAllocator::MappedRange(const VulkanAllocation &allocation, VkDeviceSize offset, VkDeviceSize size, VkMappedMemoryRange &range)
+	{
+		VkDeviceSize memorySize = allocation.size;
+		if (!allocation.IsDedicated())
+		{
+			// another thread may be growing the pool's block list
+			std::lock_guard<std::mutex> lock(m_mutex);
+			memorySize = m_pools[allocation.poolIndex].blocks[allocation.blockIndex]->allocator.GetSize();
+		}
+		VkDeviceSize begin = allocation.offset + offset;
+		VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.offset + allocation.size : begin + size;
+
+		range = {};
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = allocation.memory;
+		range.offset = begin / m_nonCoherentAtomSize * m_nonCoherentAtomSize;
+		end = (end + m_nonCoherentAtomSize - 1) / m_nonCoherentAtomSize * m_nonCoherentAtomSize;
+		range.size = end >= memorySize ? VK_WHOLE_SIZE : end - range.offset;
+	}
+}
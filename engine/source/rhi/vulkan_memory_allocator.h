@@ -0,0 +1,118 @@
+#pragma once
+
+#include "source/rhi/tlsf_allocator.h"
+
+#include <vulkan/vulkan.h>
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace JMEngine
+{
+	struct VulkanAllocation
+	{
+		VkDeviceMemory memory{VK_NULL_HANDLE};
+		VkDeviceSize offset{0};
+		VkDeviceSize size{0};
+		// persistently mapped when the memory type is host visible
+		void *mappedData{nullptr};
+		uint32_t memoryTypeIndex{0};
+
+		uint32_t poolIndex{UINT32_MAX};
+		uint32_t blockIndex{UINT32_MAX};
+		uint32_t handle{TlsfAllocator::k_invalidHandle};
+
+		inline bool IsDedicated() const { return poolIndex == UINT32_MAX; }
+	};
+
+	struct MemoryHeapStats
+	{
+		uint32_t heapIndex{0};
+		VkDeviceSize heapSize{0};
+		VkMemoryHeapFlags flags{0};
+
+		uint32_t blockCount{0};
+		VkDeviceSize blockBytes{0};
+		uint32_t allocationCount{0};
+		VkDeviceSize usedBytes{0};
+		VkDeviceSize largestFreeRange{0};
+
+		uint32_t dedicatedCount{0};
+		VkDeviceSize dedicatedBytes{0};
+
+		// share of the free space in blocks outside the largest free range of its own block,
+		// 0 when every block's free space is one range, close to 1 when it is scattered
+		float fragmentation{0.0f};
+	};
+
+	// sub-allocates buffers and images from large vkAllocateMemory blocks per memory type,
+	// placement inside a block uses a tlsf allocator
+	class VulkanMemoryAllocator final
+	{
+	public:
+		// isDedicatedAllocationEnabled when the device has VK_KHR_dedicated_allocation enabled
+		void Initialize(VkDevice device, VkPhysicalDevice physicalDevice, bool isDedicatedAllocationEnabled, VkDeviceSize blockSize = 64ull << 20);
+		void Clear();
+
+		// memory is picked from types with all required flags, the one matching the most preferred flags wins.
+		// buffer or image name the only resource bound to the memory, dedicated allocations are then made for it
+		bool Allocate(const VkMemoryRequirements &requirements, VkMemoryPropertyFlags requiredFlags, VkMemoryPropertyFlags preferredFlags,
+					  bool isLinear, bool isDedicated, VulkanAllocation &allocation, VkBuffer buffer = VK_NULL_HANDLE, VkImage image = VK_NULL_HANDLE);
+		void Free(VulkanAllocation &allocation);
+
+		bool CreateBuffer(const VkBufferCreateInfo &bufferInfo, VkMemoryPropertyFlags requiredFlags, VkMemoryPropertyFlags preferredFlags,
+						  VkBuffer &buffer, VulkanAllocation &allocation);
+		void DestroyBuffer(VkBuffer buffer, VulkanAllocation &allocation);
+		// large images get their own allocation, isDedicated forces it
+		bool CreateImage(const VkImageCreateInfo &imageInfo, VkMemoryPropertyFlags requiredFlags, VkMemoryPropertyFlags preferredFlags,
+						 VkImage &image, VulkanAllocation &allocation, bool isDedicated = false);
+		void DestroyImage(VkImage image, VulkanAllocation &allocation);
+
+		bool IsHostCoherent(const VulkanAllocation &allocation) const;
+		bool HasMemoryType(VkMemoryPropertyFlags flags) const;
+		// no-ops on coherent memory, ranges are widened to nonCoherentAtomSize
+		void Flush(const VulkanAllocation &allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+		void Invalidate(const VulkanAllocation &allocation, VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
+		std::vector<MemoryHeapStats> GetHeapStats();
+
+	private:
+		struct MemoryBlock
+		{
+			VkDeviceMemory memory{VK_NULL_HANDLE};
+			void *mappedData{nullptr};
+			TlsfAllocator allocator;
+		};
+
+		// buffers and optimal tiling images never share a pool, so bufferImageGranularity cannot be violated
+		struct MemoryPool
+		{
+			uint32_t memoryTypeIndex{0};
+			bool isLinear{true};
+			std::vector<std::unique_ptr<MemoryBlock>> blocks;
+		};
+
+		VkDevice m_device{nullptr};
+		VkPhysicalDevice m_physicalDevice{VK_NULL_HANDLE};
+		VkPhysicalDeviceMemoryProperties m_memoryProperties{};
+		VkDeviceSize m_blockSize{0};
+		VkDeviceSize m_nonCoherentAtomSize{1};
+		uint32_t m_maxAllocationCount{0};
+		uint32_t m_deviceAllocationCount{0};
+		bool m_isDedicatedAllocationEnabled{false};
+
+		std::vector<MemoryPool> m_pools; // [memoryType * 2 + isLinear]
+		std::vector<uint32_t> m_dedicatedCounts;
+		std::vector<VkDeviceSize> m_dedicatedBytes;
+		std::mutex m_mutex;
+
+		bool AllocateFromType(uint32_t memoryTypeIndex, const VkMemoryRequirements &requirements, bool isLinear, bool isDedicated,
+							  VkBuffer buffer, VkImage image, VulkanAllocation &allocation);
+		bool AllocateDeviceMemory(uint32_t memoryTypeIndex, VkDeviceSize size, VkDeviceMemory &memory, void *&mappedData,
+								  const void *allocateNext = nullptr);
+		void FreeDeviceMemory(VkDeviceMemory memory, bool isMapped);
+		VkDeviceSize GetBlockSize(uint32_t memoryTypeIndex) const;
+		void MappedRange(const VulkanAllocation &allocation, VkDeviceSize offset, VkDeviceSize size, VkMappedMemoryRange &range);
+	};
+}
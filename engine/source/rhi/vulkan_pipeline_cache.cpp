@@ -0,0 +1,164 @@
+#include "source/rhi/vulkan_pipeline_cache.h"
+#include "source/global/macro.h"
+
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace JMEngine
+{
+	void PersistentPipelineCache::Initialize(VkDevice device, VkPhysicalDevice physicalDevice, const std::string &path)
+	{
+		m_device = device;
+		m_path = path;
+		vkGetPhysicalDeviceProperties(physicalDevice, &m_properties);
+
+		std::vector<char> file;
+		if (!m_path.empty() && std::filesystem::exists(m_path))
+		{
+			file = AssetManager::ReadFile(m_path);
+		}
+
+		VkPipelineCacheCreateInfo cacheInfo = {};
+		cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		if (file.size() >= sizeof(FileHeader))
+		{
+			FileHeader header;
+			memcpy(&header, file.data(), sizeof(FileHeader));
+			const char *data = file.data() + sizeof(FileHeader);
+			if (header.dataSize == file.size() - sizeof(FileHeader) && IsCompatible(header, data))
+			{
+				cacheInfo.initialDataSize = static_cast<size_t>(header.dataSize);
+				cacheInfo.pInitialData = data;
+				LOG_INFO("loaded pipeline cache: " + m_path);
+			}
+			else
+			{
+				LOG_WARN("pipeline cache does not match this device or driver, starting cold: " + m_path);
+			}
+		}
+
+		if (vkCreatePipelineCache(m_device, &cacheInfo, nullptr, &m_pipelineCache) != VK_SUCCESS)
+		{
+			// some drivers reject data that passed the header checks, retry empty
+			cacheInfo.initialDataSize = 0;
+			cacheInfo.pInitialData = nullptr;
+			if (vkCreatePipelineCache(m_device, &cacheInfo, nullptr, &m_pipelineCache) != VK_SUCCESS)
+			{
+				LOG_ERROR("failed to create pipeline cache!");
+			}
+		}
+	}
+
+	void PersistentPipelineCache::Clear()
+	{
+		if (m_pipelineCache == VK_NULL_HANDLE)
+		{
+			return;
+		}
+		Save();
+		vkDestroyPipelineCache(m_device, m_pipelineCache, nullptr);
+		m_pipelineCache = VK_NULL_HANDLE;
+	}
+
+	bool PersistentPipelineCache::Save()
+	{
+		if (m_path.empty() || m_pipelineCache == VK_NULL_HANDLE)
+		{
+			return false;
+		}
+
+		size_t dataSize = 0;
+		if (vkGetPipelineCacheData(m_device, m_pipelineCache, &dataSize, nullptr) != VK_SUCCESS)
+		{
+			LOG_WARN("failed to query pipeline cache size");
+			return false;
+		}
+		std::vector<char> data(dataSize);
+		if (vkGetPipelineCacheData(m_device, m_pipelineCache, &dataSize, data.data()) != VK_SUCCESS)
+		{
+			LOG_WARN("failed to read pipeline cache data");
+			return false;
+		}
+		data.resize(dataSize);
+
+		FileHeader header = {};
+		header.magic = k_magic;
+		header.version = k_version;
+		header.vendorID = m_properties.vendorID;
+		header.deviceID = m_properties.deviceID;
+		header.driverVersion = m_properties.driverVersion;
+		memcpy(header.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE);
+		header.dataSize = dataSize;
+		header.checksum = Checksum(data.data(), dataSize);
+
+		// a crash mid write leaves the temporary file behind, never a torn cache
+		std::string tempPath = m_path + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+			{
+				LOG_WARN("failed to open pipeline cache for writing: " + tempPath);
+				return false;
+			}
+			file.write(reinterpret_cast<const char *>(&header), sizeof(FileHeader));
+			file.write(data.data(), static_cast<std::streamsize>(dataSize));
+			if (!file.good())
+			{
+				LOG_WARN("failed to write pipeline cache: " + tempPath);
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(tempPath, m_path, error);
+		if (error)
+		{
+			LOG_WARN("failed to replace pipeline cache: " + error.message());
+			std::filesystem::remove(tempPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	bool PersistentPipelineCache::IsCompatible(const FileHeader &header, const char *data) const
+	{
+		if (header.magic != k_magic || header.version != k_version)
+		{
+			return false;
+		}
+		if (header.vendorID != m_properties.vendorID || header.deviceID != m_properties.deviceID ||
+			header.driverVersion != m_properties.driverVersion ||
+			memcmp(header.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+		{
+			return false;
+		}
+		if (header.checksum != Checksum(data, static_cast<size_t>(header.dataSize)))
+		{
+			return false;
+		}
+
+		// the driver's own header must agree with ours as well
+		if (header.dataSize < sizeof(VkPipelineCacheHeaderVersionOne))
+		{
+			return false;
+		}
+		VkPipelineCacheHeaderVersionOne driverHeader;
+		memcpy(&driverHeader, data, sizeof(VkPipelineCacheHeaderVersionOne));
+		return driverHeader.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			   driverHeader.vendorID == m_properties.vendorID && driverHeader.deviceID == m_properties.deviceID &&
+			   memcmp(driverHeader.pipelineCacheUUID, m_properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	uint64_t PersistentPipelineCache::Checksum(const char *data, size_t size)
+	{
+		// fnv-1a
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= static_cast<uint8_t>(data[i]);
+			hash *= 1099511628211ull;
+		}
+		return hash;
+	}
+}
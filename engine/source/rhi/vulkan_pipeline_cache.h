@@ -0,0 +1,45 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <string>
+
+namespace JMEngine
+{
+	// a VkPipelineCache loaded from disk at startup and written back on shutdown,
+	// a file from another device, driver or a torn write is ignored and compiles start cold
+	class PersistentPipelineCache final
+	{
+	public:
+		// an empty path keeps the cache in memory only
+		void Initialize(VkDevice device, VkPhysicalDevice physicalDevice, const std::string &path);
+		void Clear();
+
+		// writes to a temporary file and renames it over the old one
+		bool Save();
+		inline VkPipelineCache GetHandle() const { return m_pipelineCache; }
+
+	private:
+		struct FileHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t vendorID;
+			uint32_t deviceID;
+			uint32_t driverVersion;
+			uint8_t pipelineCacheUUID[VK_UUID_SIZE];
+			uint64_t dataSize;
+			uint64_t checksum;
+		};
+		static constexpr uint32_t k_magic = 0x434c504a; // "JPLC"
+		static constexpr uint32_t k_version = 1;
+
+		VkDevice m_device{nullptr};
+		VkPhysicalDeviceProperties m_properties{};
+		VkPipelineCache m_pipelineCache{VK_NULL_HANDLE};
+		std::string m_path;
+
+		bool IsCompatible(const FileHeader &header, const char *data) const;
+		static uint64_t Checksum(const char *data, size_t size);
+	};
+}
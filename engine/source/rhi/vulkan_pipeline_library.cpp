@@ -0,0 +1,593 @@
+#include "source/rhi/vulkan_pipeline_library.h"
+#include "source/global/macro.h"
+#include "source/global/profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+namespace JMEngine
+{
+	namespace
+	{
+		inline void HashCombine(size_t &seed, uint64_t value)
+		{
+			seed ^= std::hash<uint64_t>{}(value) + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2);
+		}
+
+		// info points into mapEntries and data, null when there are no constants
+		const VkSpecializationInfo *FillSpecializationInfo(const std::vector<SpecializationConstant> &constants, std::vector<VkSpecializationMapEntry> &mapEntries,
+														   std::vector<uint32_t> &data, VkSpecializationInfo &info)
+		{
+			for (const SpecializationConstant &constant : constants)
+			{
+				mapEntries.push_back({constant.constantId, static_cast<uint32_t>(data.size() * sizeof(uint32_t)), sizeof(uint32_t)});
+				data.push_back(constant.value);
+			}
+
+			info = {};
+			info.mapEntryCount = static_cast<uint32_t>(mapEntries.size());
+			info.pMapEntries = mapEntries.data();
+			info.dataSize = data.size() * sizeof(uint32_t);
+			info.pData = data.data();
+			return mapEntries.empty() ? nullptr : &info;
+		}
+
+		bool HasStencil(VkFormat format)
+		{
+			return format == VK_FORMAT_S8_UINT || format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT ||
+				   format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+		}
+	}
+
+	void GraphicsPipelineDesc::SetSpecializationConstant(uint32_t constantId, uint32_t value)
+	{
+		auto it = std::lower_bound(specializationConstants.begin(), specializationConstants.end(), constantId, [](const SpecializationConstant &constant, uint32_t id)
+								   { return constant.constantId < id; });
+		if (it != specializationConstants.end() && it->constantId == constantId)
+		{
+			it->value = value;
+		}
+		else
+		{
+			specializationConstants.insert(it, {constantId, value});
+		}
+	}
+
+	size_t GraphicsPipelineDescHash::operator()(const GraphicsPipelineDesc &desc) const
+	{
+		size_t seed = 0;
+		HashCombine(seed, desc.vertexShader);
+		HashCombine(seed, desc.fragmentShader);
+		for (const SpecializationConstant &constant : desc.specializationConstants)
+		{
+			HashCombine(seed, constant.constantId);
+			HashCombine(seed, constant.value);
+		}
+		for (const VertexBinding &binding : desc.vertexBindings)
+		{
+			HashCombine(seed, binding.binding);
+			HashCombine(seed, binding.stride);
+			HashCombine(seed, binding.inputRate);
+		}
+		for (const VertexAttribute &attribute : desc.vertexAttributes)
+		{
+			HashCombine(seed, attribute.location);
+			HashCombine(seed, attribute.binding);
+			HashCombine(seed, attribute.format);
+			HashCombine(seed, attribute.offset);
+		}
+		HashCombine(seed, desc.topology);
+		HashCombine(seed, desc.polygonMode);
+		HashCombine(seed, desc.cullMode);
+		HashCombine(seed, desc.frontFace);
+		HashCombine(seed, desc.sampleCount);
+		HashCombine(seed, desc.isDepthTestEnabled);
+		HashCombine(seed, desc.isDepthWriteEnabled);
+		HashCombine(seed, desc.depthCompareOp);
+		HashCombine(seed, desc.isBlendEnabled);
+		HashCombine(seed, desc.srcColorBlendFactor);
+		HashCombine(seed, desc.dstColorBlendFactor);
+		HashCombine(seed, desc.colorBlendOp);
+		HashCombine(seed, desc.srcAlphaBlendFactor);
+		HashCombine(seed, desc.dstAlphaBlendFactor);
+		HashCombine(seed, desc.alphaBlendOp);
+		HashCombine(seed, desc.colorWriteMask);
+		HashCombine(seed, desc.colorAttachmentCount);
+		HashCombine(seed, reinterpret_cast<uint64_t>(desc.layout));
+		HashCombine(seed, reinterpret_cast<uint64_t>(desc.renderPass));
+		HashCombine(seed, desc.subpass);
+		for (VkFormat format : desc.colorFormats)
+		{
+			HashCombine(seed, format);
+		}
+		HashCombine(seed, desc.depthFormat);
+		return seed;
+	}
+
+	size_t ComputePipelineDescHash::operator()(const ComputePipelineDesc &desc) const
+	{
+		size_t seed = 0;
+		HashCombine(seed, desc.computeShader);
+		for (const SpecializationConstant &constant : desc.specializationConstants)
+		{
+			HashCombine(seed, constant.constantId);
+			HashCombine(seed, constant.value);
+		}
+		HashCombine(seed, reinterpret_cast<uint64_t>(desc.layout));
+		return seed;
+	}
+
+	void PipelineLibrary::Initialize(VkDevice device, VkPipelineCache pipelineCache, uint32_t compileThreadCount)
+	{
+		m_device = device;
+		m_pipelineCache = pipelineCache;
+		m_compileJobs.Initialize(compileThreadCount);
+	}
+
+	void PipelineLibrary::Clear()
+	{
+		m_compileJobs.Clear();
+
+		for (auto &[desc, entry] : m_pipelines)
+		{
+			if (entry->compile.valid())
+			{
+				entry->compile.wait();
+			}
+			vkDestroyPipeline(m_device, entry->pipeline.load(), nullptr);
+		}
+		m_pipelines.clear();
+		for (auto &[desc, pipeline] : m_computePipelines)
+		{
+			vkDestroyPipeline(m_device, pipeline, nullptr);
+		}
+		m_computePipelines.clear();
+
+		for (auto &[id, shaderModule] : m_shaderModules)
+		{
+			vkDestroyShaderModule(m_device, shaderModule, nullptr);
+		}
+		m_shaderModules.clear();
+	}
+
+	ShaderId PipelineLibrary::RegisterShader(std::span<const uint32_t> code)
+	{
+		if (code.empty())
+		{
+			return 0;
+		}
+
+		// fnv-1a over the words, identical spir-v shares one module
+		ShaderId id = 14695981039346656037ull;
+		for (uint32_t word : code)
+		{
+			id ^= word;
+			id *= 1099511628211ull;
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_shaderModules.count(id) > 0)
+		{
+			return id;
+		}
+
+		VkShaderModuleCreateInfo createInfo = {};
+		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+		// embedded modules are consumed in place, no copy
+		createInfo.codeSize = code.size_bytes();
+		createInfo.pCode = code.data();
+
+		VkShaderModule shaderModule;
+		if (vkCreateShaderModule(m_device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create shader module!");
+			return 0;
+		}
+		m_shaderModules[id] = shaderModule;
+		return id;
+	}
+
+	VkPipeline PipelineLibrary::Request(const GraphicsPipelineDesc &desc)
+	{
+		return FindOrInsert(desc, true)->pipeline.load(std::memory_order_acquire);
+	}
+
+	VkPipeline PipelineLibrary::GetOrCreate(const GraphicsPipelineDesc &desc)
+	{
+		PipelineEntry *entry = FindOrInsert(desc, false);
+		entry->compile.wait();
+		return entry->pipeline.load(std::memory_order_acquire);
+	}
+
+	VkPipeline PipelineLibrary::GetOrCreate(const ComputePipelineDesc &desc)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto it = m_computePipelines.find(desc);
+		if (it != m_computePipelines.end())
+		{
+			return it->second;
+		}
+
+		auto computeShader = m_shaderModules.find(desc.computeShader);
+		VkPipeline pipeline = Compile(desc, computeShader != m_shaderModules.end() ? computeShader->second : VK_NULL_HANDLE);
+		if (pipeline != VK_NULL_HANDLE)
+		{
+			m_computePipelines.emplace(desc, pipeline);
+		}
+		return pipeline;
+	}
+
+	void PipelineLibrary::Evict(VkRenderPass renderPass, const std::function<void(VkPipeline)> &retire)
+	{
+		std::vector<std::unique_ptr<PipelineEntry>> evicted;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (auto it = m_pipelines.begin(); it != m_pipelines.end();)
+			{
+				if (it->first.renderPass == renderPass)
+				{
+					evicted.push_back(std::move(it->second));
+					it = m_pipelines.erase(it);
+				}
+				else
+				{
+					++it;
+				}
+			}
+		}
+
+		for (auto &entry : evicted)
+		{
+			entry->compile.wait();
+			VkPipeline pipeline = entry->pipeline.load();
+			if (pipeline != VK_NULL_HANDLE)
+			{
+				retire(pipeline);
+			}
+		}
+	}
+
+	void PipelineLibrary::ReplaceShader(ShaderId oldShader, ShaderId newShader)
+	{
+		auto substitute = [oldShader, newShader](GraphicsPipelineDesc &desc)
+		{
+			bool isUsed = false;
+			if (desc.vertexShader == oldShader)
+			{
+				desc.vertexShader = newShader;
+				isUsed = true;
+			}
+			if (desc.fragmentShader == oldShader)
+			{
+				desc.fragmentShader = newShader;
+				isUsed = true;
+			}
+			return isUsed;
+		};
+
+		std::vector<GraphicsPipelineDesc> dependents;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (auto &[desc, entry] : m_pipelines)
+			{
+				if (desc.vertexShader == oldShader || desc.fragmentShader == oldShader)
+				{
+					dependents.push_back(desc);
+				}
+			}
+		}
+
+		// a save before the previous replacement finished retargets it, the oldest pipeline
+		// keeps drawing until the newest one is ready
+		for (Replacement &replacement : m_replacements)
+		{
+			if (substitute(replacement.newDesc))
+			{
+				replacement.isFailed = false;
+			}
+		}
+		for (GraphicsPipelineDesc &desc : dependents)
+		{
+			Replacement replacement{desc, desc};
+			substitute(replacement.newDesc);
+			m_replacements.push_back(std::move(replacement));
+		}
+		for (Replacement &replacement : m_replacements)
+		{
+			Request(replacement.newDesc);
+		}
+	}
+
+	void PipelineLibrary::CollectReplaced(std::span<const VkPipeline> boundPipelines, const std::function<void(VkPipeline)> &retire)
+	{
+		if (m_replacements.empty())
+		{
+			return;
+		}
+
+		std::vector<VkPipeline> retired;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto isDone = [](const PipelineEntry &entry)
+			{ return entry.compile.wait_for(std::chrono::seconds(0)) == std::future_status::ready; };
+
+			for (auto it = m_replacements.begin(); it != m_replacements.end();)
+			{
+				auto newEntry = m_pipelines.find(it->newDesc);
+				auto oldEntry = m_pipelines.find(it->oldDesc);
+				if (newEntry == m_pipelines.end() || oldEntry == m_pipelines.end())
+				{
+					// evicted along with its render pass
+					it = m_replacements.erase(it);
+					continue;
+				}
+				if (it->isFailed || !isDone(*newEntry->second) || !isDone(*oldEntry->second))
+				{
+					++it;
+					continue;
+				}
+				if (newEntry->second->pipeline.load() == VK_NULL_HANDLE)
+				{
+					// kept so the next reload of the shader still retires the pipeline that is actually drawing
+					LOG_WARN("shader reload failed to compile, keeping the previous pipeline");
+					it->isFailed = true;
+					++it;
+					continue;
+				}
+
+				VkPipeline pipeline = oldEntry->second->pipeline.load();
+				if (pipeline != VK_NULL_HANDLE && std::find(boundPipelines.begin(), boundPipelines.end(), pipeline) != boundPipelines.end())
+				{
+					++it;
+					continue;
+				}
+				if (pipeline != VK_NULL_HANDLE)
+				{
+					retired.push_back(pipeline);
+				}
+				m_pipelines.erase(oldEntry);
+				it = m_replacements.erase(it);
+			}
+		}
+
+		for (VkPipeline pipeline : retired)
+		{
+			retire(pipeline);
+		}
+	}
+
+	size_t PipelineLibrary::GetPipelineCount()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_pipelines.size() + m_computePipelines.size();
+	}
+
+	PipelineLibrary::PipelineEntry *PipelineLibrary::FindOrInsert(const GraphicsPipelineDesc &desc, bool isAsync)
+	{
+		std::shared_ptr<std::packaged_task<void()>> task;
+		PipelineEntry *entry;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			auto it = m_pipelines.find(desc);
+			if (it != m_pipelines.end())
+			{
+				return it->second.get();
+			}
+
+			auto vertexShader = m_shaderModules.find(desc.vertexShader);
+			auto fragmentShader = m_shaderModules.find(desc.fragmentShader);
+			VkShaderModule vertexModule = vertexShader != m_shaderModules.end() ? vertexShader->second : VK_NULL_HANDLE;
+			VkShaderModule fragmentModule = fragmentShader != m_shaderModules.end() ? fragmentShader->second : VK_NULL_HANDLE;
+
+			auto inserted = m_pipelines.emplace(desc, std::make_unique<PipelineEntry>());
+			entry = inserted.first->second.get();
+			// the desc lives in the map key until the entry is evicted, which waits for this task
+			const GraphicsPipelineDesc *key = &inserted.first->first;
+			task = std::make_shared<std::packaged_task<void()>>([this, entry, key, vertexModule, fragmentModule]()
+																{
+																	entry->pipeline.store(Compile(*key, vertexModule, fragmentModule), std::memory_order_release);
+																	m_pendingCount.fetch_sub(1, std::memory_order_relaxed);
+																});
+			entry->compile = task->get_future().share();
+			m_pendingCount.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		if (isAsync)
+		{
+			m_compileJobs.Submit([task](uint32_t)
+								 { (*task)(); });
+		}
+		else
+		{
+			(*task)();
+		}
+		return entry;
+	}
+
+	VkPipeline PipelineLibrary::Compile(const GraphicsPipelineDesc &desc, VkShaderModule vertexShader, VkShaderModule fragmentShader)
+	{
+		PROFILE_FUNCTION();
+		if (vertexShader == VK_NULL_HANDLE || (desc.fragmentShader != 0 && fragmentShader == VK_NULL_HANDLE))
+		{
+			LOG_ERROR("graphics pipeline references an unregistered shader!");
+			return VK_NULL_HANDLE;
+		}
+
+		// one module serves every permutation, the driver folds the constants when compiling
+		std::vector<VkSpecializationMapEntry> mapEntries;
+		std::vector<uint32_t> specializationData;
+		VkSpecializationInfo specializationInfo;
+		const VkSpecializationInfo *pSpecializationInfo = FillSpecializationInfo(desc.specializationConstants, mapEntries, specializationData, specializationInfo);
+
+		VkPipelineShaderStageCreateInfo shaderStages[2] = {};
+		shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+		shaderStages[0].module = vertexShader;
+		shaderStages[0].pName = "main";
+		shaderStages[0].pSpecializationInfo = pSpecializationInfo;
+		shaderStages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		shaderStages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+		shaderStages[1].module = fragmentShader;
+		shaderStages[1].pName = "main";
+		shaderStages[1].pSpecializationInfo = pSpecializationInfo;
+
+		// vertex
+		std::vector<VkVertexInputBindingDescription> bindings;
+		for (const VertexBinding &binding : desc.vertexBindings)
+		{
+			bindings.push_back({binding.binding, binding.stride, binding.inputRate});
+		}
+		std::vector<VkVertexInputAttributeDescription> attributes;
+		for (const VertexAttribute &attribute : desc.vertexAttributes)
+		{
+			attributes.push_back({attribute.location, attribute.binding, attribute.format, attribute.offset});
+		}
+
+		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
+		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+		vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(bindings.size());
+		vertexInputInfo.pVertexBindingDescriptions = bindings.data();
+		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributes.size());
+		vertexInputInfo.pVertexAttributeDescriptions = attributes.data();
+
+		// pipeline input
+		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
+		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+		inputAssembly.topology = desc.topology;
+		inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+		// viewport, set when recording so the pipeline survives a resize
+		VkPipelineViewportStateCreateInfo viewportState = {};
+		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
+		viewportState.viewportCount = 1;
+		viewportState.scissorCount = 1;
+
+		VkDynamicState dynamicStates[] = {VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR};
+		VkPipelineDynamicStateCreateInfo dynamicState = {};
+		dynamicState.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
+		dynamicState.dynamicStateCount = 2;
+		dynamicState.pDynamicStates = dynamicStates;
+
+		// rasterization
+		VkPipelineRasterizationStateCreateInfo rasterizer = {};
+		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
+		rasterizer.depthClampEnable = VK_FALSE;
+		rasterizer.rasterizerDiscardEnable = VK_FALSE;
+		rasterizer.polygonMode = desc.polygonMode;
+		rasterizer.lineWidth = 1.0f;
+		rasterizer.cullMode = desc.cullMode;
+		rasterizer.frontFace = desc.frontFace;
+		rasterizer.depthBiasEnable = VK_FALSE;
+
+		// mutisample
+		VkPipelineMultisampleStateCreateInfo multisampling = {};
+		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
+		multisampling.sampleShadingEnable = VK_FALSE;
+		multisampling.rasterizationSamples = desc.sampleCount;
+		multisampling.minSampleShading = 1.0f;
+
+		// depth
+		VkPipelineDepthStencilStateCreateInfo depthStencil = {};
+		depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
+		depthStencil.depthTestEnable = desc.isDepthTestEnabled ? VK_TRUE : VK_FALSE;
+		depthStencil.depthWriteEnable = desc.isDepthWriteEnabled ? VK_TRUE : VK_FALSE;
+		depthStencil.depthCompareOp = desc.depthCompareOp;
+		depthStencil.depthBoundsTestEnable = VK_FALSE;
+		depthStencil.stencilTestEnable = VK_FALSE;
+
+		// blend
+		VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
+		colorBlendAttachment.colorWriteMask = desc.colorWriteMask;
+		colorBlendAttachment.blendEnable = desc.isBlendEnabled ? VK_TRUE : VK_FALSE;
+		colorBlendAttachment.srcColorBlendFactor = desc.srcColorBlendFactor;
+		colorBlendAttachment.dstColorBlendFactor = desc.dstColorBlendFactor;
+		colorBlendAttachment.colorBlendOp = desc.colorBlendOp;
+		colorBlendAttachment.srcAlphaBlendFactor = desc.srcAlphaBlendFactor;
+		colorBlendAttachment.dstAlphaBlendFactor = desc.dstAlphaBlendFactor;
+		colorBlendAttachment.alphaBlendOp = desc.alphaBlendOp;
+
+		std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(desc.colorAttachmentCount, colorBlendAttachment);
+
+		VkPipelineColorBlendStateCreateInfo colorBlending = {};
+		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
+		colorBlending.logicOpEnable = VK_FALSE;
+		colorBlending.logicOp = VK_LOGIC_OP_COPY;
+		colorBlending.attachmentCount = desc.colorAttachmentCount;
+		colorBlending.pAttachments = colorBlendAttachments.data();
+
+		// without a render pass the attachment formats stand in for it
+		VkPipelineRenderingCreateInfoKHR renderingInfo = {};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+		renderingInfo.colorAttachmentCount = static_cast<uint32_t>(desc.colorFormats.size());
+		renderingInfo.pColorAttachmentFormats = desc.colorFormats.data();
+		renderingInfo.depthAttachmentFormat = desc.depthFormat != VK_FORMAT_S8_UINT ? desc.depthFormat : VK_FORMAT_UNDEFINED;
+		renderingInfo.stencilAttachmentFormat = HasStencil(desc.depthFormat) ? desc.depthFormat : VK_FORMAT_UNDEFINED;
+		if (desc.renderPass == VK_NULL_HANDLE && desc.colorFormats.size() != desc.colorAttachmentCount)
+		{
+			LOG_ERROR("graphics pipeline without a render pass needs a format for every color attachment!");
+			return VK_NULL_HANDLE;
+		}
+
+		// create pipeline
+		VkGraphicsPipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+		pipelineInfo.pNext = desc.renderPass == VK_NULL_HANDLE ? &renderingInfo : nullptr;
+		pipelineInfo.stageCount = desc.fragmentShader != 0 ? 2 : 1;
+		pipelineInfo.pStages = shaderStages;
+		pipelineInfo.pVertexInputState = &vertexInputInfo;
+		pipelineInfo.pInputAssemblyState = &inputAssembly;
+		pipelineInfo.pViewportState = &viewportState;
+		pipelineInfo.pRasterizationState = &rasterizer;
+		pipelineInfo.pMultisampleState = &multisampling;
+		pipelineInfo.pDepthStencilState = &depthStencil;
+		pipelineInfo.pColorBlendState = &colorBlending;
+		pipelineInfo.pDynamicState = &dynamicState;
+		pipelineInfo.layout = desc.layout;
+		pipelineInfo.renderPass = desc.renderPass;
+		pipelineInfo.subpass = desc.subpass;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineInfo.basePipelineIndex = -1;
+
+		// the pipeline cache is internally synchronized, workers share it
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		if (vkCreateGraphicsPipelines(m_device, m_pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create graphics pipeline!");
+			return VK_NULL_HANDLE;
+		}
+		return pipeline;
+	}
+
+	VkPipeline PipelineLibrary::Compile(const ComputePipelineDesc &desc, VkShaderModule computeShader)
+	{
+		PROFILE_FUNCTION();
+		if (computeShader == VK_NULL_HANDLE)
+		{
+			LOG_ERROR("compute pipeline references an unregistered shader!");
+			return VK_NULL_HANDLE;
+		}
+
+		std::vector<VkSpecializationMapEntry> mapEntries;
+		std::vector<uint32_t> specializationData;
+		VkSpecializationInfo specializationInfo;
+
+		VkComputePipelineCreateInfo pipelineInfo = {};
+		pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+		pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+		pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+		pipelineInfo.stage.module = computeShader;
+		pipelineInfo.stage.pName = "main";
+		pipelineInfo.stage.pSpecializationInfo = FillSpecializationInfo(desc.specializationConstants, mapEntries, specializationData, specializationInfo);
+		pipelineInfo.layout = desc.layout;
+		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+		pipelineInfo.basePipelineIndex = -1;
+
+		VkPipeline pipeline = VK_NULL_HANDLE;
+		if (vkCreateComputePipelines(m_device, m_pipelineCache, 1, &pipelineInfo, nullptr, &pipeline) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create compute pipeline!");
+			return VK_NULL_HANDLE;
+		}
+		return pipeline;
+	}
+}
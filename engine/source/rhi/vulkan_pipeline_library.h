@@ -0,0 +1,180 @@
+#pragma once
+
+#include "source/job_system.h"
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+namespace JMEngine
+{
+	// shader modules are registered once and named by a hash of their spir-v
+	using ShaderId = uint64_t;
+
+	struct VertexBinding
+	{
+		uint32_t binding{0};
+		uint32_t stride{0};
+		VkVertexInputRate inputRate{VK_VERTEX_INPUT_RATE_VERTEX};
+
+		bool operator==(const VertexBinding &other) const = default;
+	};
+
+	struct VertexAttribute
+	{
+		uint32_t location{0};
+		uint32_t binding{0};
+		VkFormat format{VK_FORMAT_UNDEFINED};
+		uint32_t offset{0};
+
+		bool operator==(const VertexAttribute &other) const = default;
+	};
+
+	// 4 byte value for a layout(constant_id) declaration, bools are VkBool32 and floats their bit pattern
+	struct SpecializationConstant
+	{
+		uint32_t constantId{0};
+		uint32_t value{0};
+
+		bool operator==(const SpecializationConstant &other) const = default;
+	};
+
+	// everything a graphics pipeline is built from, viewport and scissor are always dynamic
+	struct GraphicsPipelineDesc
+	{
+		ShaderId vertexShader{0};
+		// 0 for depth only pipelines
+		ShaderId fragmentShader{0};
+		// the permutation, shared by both stages, a stage ignores ids it does not declare,
+		// kept sorted by id so equal permutations compare equal
+		std::vector<SpecializationConstant> specializationConstants;
+
+		std::vector<VertexBinding> vertexBindings;
+		std::vector<VertexAttribute> vertexAttributes;
+		VkPrimitiveTopology topology{VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST};
+
+		VkPolygonMode polygonMode{VK_POLYGON_MODE_FILL};
+		VkCullModeFlags cullMode{VK_CULL_MODE_BACK_BIT};
+		VkFrontFace frontFace{VK_FRONT_FACE_CLOCKWISE};
+		VkSampleCountFlagBits sampleCount{VK_SAMPLE_COUNT_1_BIT};
+
+		bool isDepthTestEnabled{false};
+		bool isDepthWriteEnabled{false};
+		VkCompareOp depthCompareOp{VK_COMPARE_OP_LESS};
+
+		bool isBlendEnabled{false};
+		VkBlendFactor srcColorBlendFactor{VK_BLEND_FACTOR_SRC_ALPHA};
+		VkBlendFactor dstColorBlendFactor{VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA};
+		VkBlendOp colorBlendOp{VK_BLEND_OP_ADD};
+		VkBlendFactor srcAlphaBlendFactor{VK_BLEND_FACTOR_ONE};
+		VkBlendFactor dstAlphaBlendFactor{VK_BLEND_FACTOR_ZERO};
+		VkBlendOp alphaBlendOp{VK_BLEND_OP_ADD};
+		VkColorComponentFlags colorWriteMask{VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT};
+		// every color attachment of the subpass shares the blend state above
+		uint32_t colorAttachmentCount{1};
+
+		VkPipelineLayout layout{VK_NULL_HANDLE};
+		// null for dynamic rendering, the pipeline is then built against the attachment formats below
+		VkRenderPass renderPass{VK_NULL_HANDLE};
+		uint32_t subpass{0};
+		// only read without a render pass, one format per color attachment, depthFormat may include stencil
+		std::vector<VkFormat> colorFormats;
+		VkFormat depthFormat{VK_FORMAT_UNDEFINED};
+
+		void SetSpecializationConstant(uint32_t constantId, uint32_t value);
+
+		bool operator==(const GraphicsPipelineDesc &other) const = default;
+	};
+
+	struct GraphicsPipelineDescHash
+	{
+		size_t operator()(const GraphicsPipelineDesc &desc) const;
+	};
+
+	struct ComputePipelineDesc
+	{
+		ShaderId computeShader{0};
+		// kept sorted by id like GraphicsPipelineDesc::specializationConstants
+		std::vector<SpecializationConstant> specializationConstants;
+		VkPipelineLayout layout{VK_NULL_HANDLE};
+
+		bool operator==(const ComputePipelineDesc &other) const = default;
+	};
+
+	struct ComputePipelineDescHash
+	{
+		size_t operator()(const ComputePipelineDesc &desc) const;
+	};
+
+	// graphics pipelines deduplicated by their full state, misses compile on background threads
+	// so the frame loop only ever sees a null pipeline while one is building
+	class PipelineLibrary final
+	{
+	public:
+		// compileThreadCount 0 compiles inline on the requesting thread
+		void Initialize(VkDevice device, VkPipelineCache pipelineCache, uint32_t compileThreadCount);
+		// waits for compiles in flight, the device must be idle
+		void Clear();
+
+		ShaderId RegisterShader(std::span<const uint32_t> code);
+
+		// null until the pipeline has been compiled, never blocks after the first call for a desc
+		VkPipeline Request(const GraphicsPipelineDesc &desc);
+		// compiles inline on a miss, for pipelines that are needed right away
+		VkPipeline GetOrCreate(const GraphicsPipelineDesc &desc);
+		// compute pipelines are few and created up front by their owners, always inline
+		VkPipeline GetOrCreate(const ComputePipelineDesc &desc);
+
+		// drops every pipeline built for renderPass, retire receives them once their compiles are done,
+		// with dynamic rendering pipelines are built against formats and stay valid instead
+		void Evict(VkRenderPass renderPass, const std::function<void(VkPipeline)> &retire);
+
+		// rebuilds every pipeline using oldShader with newShader in the background, the old pipelines
+		// stay valid until their replacements are ready and are then handed out by CollectReplaced
+		void ReplaceShader(ShaderId oldShader, ShaderId newShader);
+		// called at a frame boundary, a replacement that failed to compile keeps the old pipeline.
+		// old pipelines listed in boundPipelines are still recorded by the caller and wait for a later call
+		void CollectReplaced(std::span<const VkPipeline> boundPipelines, const std::function<void(VkPipeline)> &retire);
+
+		inline uint32_t GetPendingCount() const { return m_pendingCount.load(std::memory_order_relaxed); }
+		size_t GetPipelineCount();
+
+	private:
+		struct PipelineEntry
+		{
+			std::atomic<VkPipeline> pipeline{VK_NULL_HANDLE};
+			std::shared_future<void> compile;
+		};
+
+		VkDevice m_device{nullptr};
+		VkPipelineCache m_pipelineCache{VK_NULL_HANDLE};
+		JobSystem m_compileJobs;
+		std::atomic<uint32_t> m_pendingCount{0};
+
+		std::mutex m_mutex;
+		std::unordered_map<GraphicsPipelineDesc, std::unique_ptr<PipelineEntry>, GraphicsPipelineDescHash> m_pipelines;
+		std::unordered_map<ComputePipelineDesc, VkPipeline, ComputePipelineDescHash> m_computePipelines;
+		std::unordered_map<ShaderId, VkShaderModule> m_shaderModules;
+
+		struct Replacement
+		{
+			GraphicsPipelineDesc oldDesc;
+			GraphicsPipelineDesc newDesc;
+			// newDesc did not compile, oldDesc stays live until a later ReplaceShader retargets newDesc
+			bool isFailed{false};
+		};
+		// render thread only
+		std::vector<Replacement> m_replacements;
+
+		PipelineEntry *FindOrInsert(const GraphicsPipelineDesc &desc, bool isAsync);
+		VkPipeline Compile(const GraphicsPipelineDesc &desc, VkShaderModule vertexShader, VkShaderModule fragmentShader);
+		VkPipeline Compile(const ComputePipelineDesc &desc, VkShaderModule computeShader);
+	};
+}
@@ -0,0 +1,217 @@
+#include "source/rhi/vulkan_readback.h"
+#include "source/global/macro.h"
+
+namespace JMEngine
+{
+	void ReadbackRing::Initialize(VkDevice device, VulkanMemoryAllocator *memoryAllocator, uint32_t slotCount)
+	{
+		m_device = device;
+		m_memoryAllocator = memoryAllocator;
+		m_slots.resize(slotCount);
+	}
+
+	void ReadbackRing::Clear()
+	{
+		for (auto &slot : m_slots)
+		{
+			DestroySlot(slot);
+		}
+		m_slots.clear();
+	}
+
+	bool ReadbackRing::ReadbackImage(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout currentLayout, VkExtent2D extent,
+									 VkFormat format, uint32_t bytesPerPixel, uint64_t frameNumber, ReadbackCallback &&callback)
+	{
+		VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * bytesPerPixel;
+		ReadbackSlot *slot = AcquireSlot(size);
+		if (slot == nullptr)
+		{
+			return false;
+		}
+
+		VkImageMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+		barrier.oldLayout = currentLayout;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+		vkCmdPipelineBarrier(commandBuffer,
+							 VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+							 VK_PIPELINE_STAGE_TRANSFER_BIT,
+							 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkBufferImageCopy region = {};
+		region.bufferOffset = 0;
+		region.bufferRowLength = 0;
+		region.bufferImageHeight = 0;
+		region.imageSubresource = {VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+		region.imageOffset = {0, 0, 0};
+		region.imageExtent = {extent.width, extent.height, 1};
+
+		vkCmdCopyImageToBuffer(commandBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot->buffer, 1, &region);
+
+		if (currentLayout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+		{
+			barrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+			barrier.dstAccessMask = 0;
+			barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+			barrier.newLayout = currentLayout;
+
+			vkCmdPipelineBarrier(commandBuffer,
+								 VK_PIPELINE_STAGE_TRANSFER_BIT,
+								 VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+								 0, 0, nullptr, 0, nullptr, 1, &barrier);
+		}
+
+		RecordHostBarrier(commandBuffer, *slot, size);
+
+		slot->isPending = true;
+		slot->frameNumber = frameNumber;
+		slot->result = {};
+		slot->result.size = size;
+		slot->result.extent = extent;
+		slot->result.format = format;
+		slot->result.frameNumber = frameNumber;
+		slot->callback = std::move(callback);
+		return true;
+	}
+
+	bool ReadbackRing::ReadbackBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+									  uint64_t frameNumber, ReadbackCallback &&callback)
+	{
+		ReadbackSlot *slot = AcquireSlot(size);
+		if (slot == nullptr)
+		{
+			return false;
+		}
+
+		// the source is expected to be written by shaders or transfers earlier in the frame
+		VkMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+		vkCmdPipelineBarrier(commandBuffer,
+							 VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+							 VK_PIPELINE_STAGE_TRANSFER_BIT,
+							 0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+		VkBufferCopy region = {};
+		region.srcOffset = offset;
+		region.dstOffset = 0;
+		region.size = size;
+		vkCmdCopyBuffer(commandBuffer, buffer, slot->buffer, 1, &region);
+
+		RecordHostBarrier(commandBuffer, *slot, size);
+
+		slot->isPending = true;
+		slot->frameNumber = frameNumber;
+		slot->result = {};
+		slot->result.size = size;
+		slot->result.frameNumber = frameNumber;
+		slot->callback = std::move(callback);
+		return true;
+	}
+
+	void ReadbackRing::Update(uint64_t completedFrameNumber)
+	{
+		for (auto &slot : m_slots)
+		{
+			if (!slot.isPending || slot.frameNumber > completedFrameNumber)
+			{
+				continue;
+			}
+
+			m_memoryAllocator->Invalidate(slot.allocation, 0, slot.result.size);
+
+			slot.result.data = slot.allocation.mappedData;
+			if (slot.callback)
+			{
+				slot.callback(slot.result);
+			}
+			slot.callback = nullptr;
+			slot.isPending = false;
+		}
+	}
+
+	ReadbackRing::ReadbackSlot *ReadbackRing::AcquireSlot(VkDeviceSize size)
+	{
+		for (size_t i = 0; i < m_slots.size(); i++)
+		{
+			uint32_t slotIndex = static_cast<uint32_t>((m_nextSlot + i) % m_slots.size());
+			ReadbackSlot &slot = m_slots[slotIndex];
+			if (slot.isPending)
+			{
+				continue;
+			}
+
+			if (slot.capacity < size)
+			{
+				ResizeSlot(slot, size);
+				if (slot.buffer == VK_NULL_HANDLE)
+				{
+					return nullptr;
+				}
+			}
+			m_nextSlot = static_cast<uint32_t>((slotIndex + 1) % m_slots.size());
+			return &slot;
+		}
+
+		LOG_WARN("every readback slot is in flight, dropping the request");
+		return nullptr;
+	}
+
+	void ReadbackRing::ResizeSlot(ReadbackSlot &slot, VkDeviceSize size)
+	{
+		DestroySlot(slot);
+
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = size;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		// cached memory makes cpu reads fast, coherent is only the fallback
+		if (!m_memoryAllocator->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+											 slot.buffer, slot.allocation))
+		{
+			LOG_ERROR("failed to create readback buffer!");
+			return;
+		}
+		slot.capacity = size;
+	}
+
+	void ReadbackRing::DestroySlot(ReadbackSlot &slot)
+	{
+		if (slot.buffer != VK_NULL_HANDLE)
+		{
+			m_memoryAllocator->DestroyBuffer(slot.buffer, slot.allocation);
+		}
+		slot.buffer = VK_NULL_HANDLE;
+		slot.capacity = 0;
+	}
+
+	void ReadbackRing::RecordHostBarrier(VkCommandBuffer commandBuffer, const ReadbackSlot &slot, VkDeviceSize size)
+	{
+		// make the copy visible to the host once the frame fence signals
+		VkBufferMemoryBarrier barrier = {};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.buffer = slot.buffer;
+		barrier.offset = 0;
+		barrier.size = size;
+
+		vkCmdPipelineBarrier(commandBuffer,
+							 VK_PIPELINE_STAGE_TRANSFER_BIT,
+							 VK_PIPELINE_STAGE_HOST_BIT,
+							 0, 0, nullptr, 1, &barrier, 0, nullptr);
+	}
+}
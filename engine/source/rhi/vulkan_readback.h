@@ -0,0 +1,66 @@
+#pragma once
+
+#include "source/rhi/vulkan_memory_allocator.h"
+
+#include <vulkan/vulkan.h>
+
+#include <functional>
+#include <vector>
+
+namespace JMEngine
+{
+	struct ReadbackResult
+	{
+		// only valid inside the callback
+		const void *data{nullptr};
+		VkDeviceSize size{0};
+		// zero for buffer readbacks
+		VkExtent2D extent{0, 0};
+		VkFormat format{VK_FORMAT_UNDEFINED};
+		uint64_t frameNumber{0};
+	};
+
+	using ReadbackCallback = std::function<void(const ReadbackResult &)>;
+
+	// copies land in host visible, preferably host cached staging buffers and are handed out
+	// once the frame that carried them has completed, the cpu never waits for them
+	class ReadbackRing final
+	{
+	public:
+		void Initialize(VkDevice device, VulkanMemoryAllocator *memoryAllocator, uint32_t slotCount);
+		void Clear();
+
+		// record a copy of an image whose color writes happen earlier in commandBuffer,
+		// the image is left in currentLayout, returns false when every slot is still in flight
+		bool ReadbackImage(VkCommandBuffer commandBuffer, VkImage image, VkImageLayout currentLayout, VkExtent2D extent,
+						   VkFormat format, uint32_t bytesPerPixel, uint64_t frameNumber, ReadbackCallback &&callback);
+		bool ReadbackBuffer(VkCommandBuffer commandBuffer, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size,
+							uint64_t frameNumber, ReadbackCallback &&callback);
+
+		// hand out every readback whose frame is done
+		void Update(uint64_t completedFrameNumber);
+
+	private:
+		struct ReadbackSlot
+		{
+			VkBuffer buffer{VK_NULL_HANDLE};
+			VulkanAllocation allocation;
+			VkDeviceSize capacity{0};
+
+			bool isPending{false};
+			uint64_t frameNumber{0};
+			ReadbackResult result;
+			ReadbackCallback callback;
+		};
+
+		VkDevice m_device{nullptr};
+		VulkanMemoryAllocator *m_memoryAllocator{nullptr};
+		std::vector<ReadbackSlot> m_slots;
+		uint32_t m_nextSlot{0};
+
+		ReadbackSlot *AcquireSlot(VkDeviceSize size);
+		void ResizeSlot(ReadbackSlot &slot, VkDeviceSize size);
+		void DestroySlot(ReadbackSlot &slot);
+		void RecordHostBarrier(VkCommandBuffer commandBuffer, const ReadbackSlot &slot, VkDeviceSize size);
+	};
+}
@@ -0,0 +1,57 @@
+#include "source/rhi/vulkan_timeline_semaphore.h"
+#include "source/global/macro.h"
+
+#include <limits>
+
+namespace JMEngine
+{
+	bool TimelineSemaphore::Initialize(VkDevice device)
+	{
+		m_device = device;
+		_vkGetSemaphoreCounterValue = (PFN_vkGetSemaphoreCounterValue)vkGetDeviceProcAddr(m_device, "vkGetSemaphoreCounterValue");
+		_vkWaitSemaphores = (PFN_vkWaitSemaphores)vkGetDeviceProcAddr(m_device, "vkWaitSemaphores");
+
+		VkSemaphoreTypeCreateInfo typeInfo = {};
+		typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+		typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+		typeInfo.initialValue = 0;
+
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		semaphoreInfo.pNext = &typeInfo;
+		if (_vkGetSemaphoreCounterValue == nullptr || _vkWaitSemaphores == nullptr ||
+			vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_semaphore) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create timeline semaphore!");
+			m_semaphore = VK_NULL_HANDLE;
+			return false;
+		}
+		return true;
+	}
+
+	void TimelineSemaphore::Clear()
+	{
+		if (m_semaphore != VK_NULL_HANDLE)
+		{
+			vkDestroySemaphore(m_device, m_semaphore, nullptr);
+			m_semaphore = VK_NULL_HANDLE;
+		}
+	}
+
+	uint64_t TimelineSemaphore::GetCompletedValue() const
+	{
+		uint64_t value = 0;
+		_vkGetSemaphoreCounterValue(m_device, m_semaphore, &value);
+		return value;
+	}
+
+	void TimelineSemaphore::Wait(uint64_t value) const
+	{
+		VkSemaphoreWaitInfo waitInfo = {};
+		waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+		waitInfo.semaphoreCount = 1;
+		waitInfo.pSemaphores = &m_semaphore;
+		waitInfo.pValues = &value;
+		_vkWaitSemaphores(m_device, &waitInfo, std::numeric_limits<uint64_t>::max());
+	}
+}
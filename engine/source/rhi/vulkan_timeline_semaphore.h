@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+#include <cstdint>
+
+namespace JMEngine
+{
+	// vulkan 1.2 timeline semaphore whose value only grows, a queue signals it with the number of each
+	// submission, so one value tells the cpu how far the queue has got and other queues wait on numbers
+	class TimelineSemaphore final
+	{
+	public:
+		// the device must have the timelineSemaphore feature enabled
+		bool Initialize(VkDevice device);
+		void Clear();
+
+		// the highest value the gpu has signaled
+		uint64_t GetCompletedValue() const;
+		// blocks until the gpu has signaled value
+		void Wait(uint64_t value) const;
+
+		inline bool IsValid() const { return m_semaphore != VK_NULL_HANDLE; }
+		inline VkSemaphore GetHandle() const { return m_semaphore; }
+
+	private:
+		VkDevice m_device{nullptr};
+		VkSemaphore m_semaphore{VK_NULL_HANDLE};
+
+		PFN_vkGetSemaphoreCounterValue _vkGetSemaphoreCounterValue;
+		PFN_vkWaitSemaphores _vkWaitSemaphores;
+	};
+}
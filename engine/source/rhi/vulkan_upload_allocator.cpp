@@ -0,0 +1,107 @@
+#include "source/rhi/vulkan_upload_allocator.h"
+#include "source/global/macro.h"
+
+#include <algorithm>
+
+namespace JMEngine
+{
+	void FrameUploadAllocator::Initialize(VkPhysicalDevice physicalDevice, VulkanMemoryAllocator *memoryAllocator,
+										  uint32_t frameCount, VkDeviceSize bytesPerFrame)
+	{
+		m_memoryAllocator = memoryAllocator;
+		m_bytesPerFrame = bytesPerFrame;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		m_uniformAlignment = std::max<VkDeviceSize>(properties.limits.minUniformBufferOffsetAlignment, 1);
+
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		// any offset inside the frame can be bound with the full dynamic uniform range behind it
+		bufferInfo.size = bytesPerFrame + k_dynamicUniformRange;
+		bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+						   VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT |
+						   VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		m_frames.resize(frameCount);
+		for (auto &frame : m_frames)
+		{
+			// written once and read once by the gpu, device local host visible memory is a bonus when it exists
+			if (!m_memoryAllocator->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+												 VK_MEMORY_PROPERTY_HOST_COHERENT_BIT | VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+												 frame.buffer, frame.allocation))
+			{
+				LOG_ERROR("failed to create upload buffer!");
+			}
+		}
+	}
+
+	void FrameUploadAllocator::Clear()
+	{
+		for (auto &frame : m_frames)
+		{
+			if (frame.buffer != VK_NULL_HANDLE)
+			{
+				m_memoryAllocator->DestroyBuffer(frame.buffer, frame.allocation);
+			}
+		}
+		m_frames.clear();
+	}
+
+	void FrameUploadAllocator::BeginFrame(uint32_t frameIndex)
+	{
+		m_frameIndex = frameIndex;
+		m_head.store(0, std::memory_order_relaxed);
+		m_hasOverflowed = false;
+	}
+
+	void FrameUploadAllocator::EndFrame()
+	{
+		VkDeviceSize used = std::min(m_head.load(std::memory_order_relaxed), m_bytesPerFrame);
+		m_lastFrameUsage = used;
+		if (used > 0)
+		{
+			m_memoryAllocator->Flush(m_frames[m_frameIndex].allocation, 0, used);
+		}
+	}
+
+	UploadAllocation FrameUploadAllocator::Allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		alignment = std::max<VkDeviceSize>(alignment, 1);
+
+		// lock free bump, threads only contend on this one word
+		VkDeviceSize head = m_head.load(std::memory_order_relaxed);
+		VkDeviceSize offset;
+		do
+		{
+			offset = (head + alignment - 1) / alignment * alignment;
+			if (offset + size > m_bytesPerFrame)
+			{
+				if (!m_hasOverflowed.exchange(true))
+				{
+					LOG_ERROR("frame upload buffer is full, raise RHIInfo::uploadBytesPerFrame");
+				}
+				return {};
+			}
+		} while (!m_head.compare_exchange_weak(head, offset + size, std::memory_order_relaxed));
+
+		const FrameBuffer &frame = m_frames[m_frameIndex];
+		UploadAllocation allocation;
+		allocation.buffer = frame.buffer;
+		allocation.offset = offset;
+		allocation.size = size;
+		allocation.mappedData = static_cast<char *>(frame.allocation.mappedData) + offset;
+		return allocation;
+	}
+
+	UploadAllocation FrameUploadAllocator::AllocateUniform(VkDeviceSize size)
+	{
+		if (size > k_dynamicUniformRange)
+		{
+			LOG_ERROR("uniform data larger than the dynamic uniform range");
+			return {};
+		}
+		return Allocate(size, m_uniformAlignment);
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "source/rhi/vulkan_memory_allocator.h"
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <vector>
+
+namespace JMEngine
+{
+	struct UploadAllocation
+	{
+		VkBuffer buffer{VK_NULL_HANDLE};
+		VkDeviceSize offset{0};
+		VkDeviceSize size{0};
+		void *mappedData{nullptr};
+
+		inline bool IsValid() const { return buffer != VK_NULL_HANDLE; }
+	};
+
+	// one persistently mapped buffer per frame in flight, handed out as aligned slices by bumping an offset
+	// and rewound once the frame's fence has signaled, safe to use from several recording threads
+	class FrameUploadAllocator final
+	{
+	public:
+		// the window a dynamic uniform buffer descriptor sees from its offset
+		static constexpr VkDeviceSize k_dynamicUniformRange = 1024;
+
+		void Initialize(VkPhysicalDevice physicalDevice, VulkanMemoryAllocator *memoryAllocator,
+						uint32_t frameCount, VkDeviceSize bytesPerFrame);
+		void Clear();
+
+		// the previous use of this frame's buffer must have completed
+		void BeginFrame(uint32_t frameIndex);
+		// makes the frame's writes visible to the device before submit
+		void EndFrame();
+
+		UploadAllocation Allocate(VkDeviceSize size, VkDeviceSize alignment);
+		UploadAllocation AllocateUniform(VkDeviceSize size);
+
+		inline VkBuffer GetBuffer(uint32_t frameIndex) const { return m_frames[frameIndex].buffer; }
+		inline VkDeviceSize GetBytesPerFrame() const { return m_bytesPerFrame; }
+		inline VkDeviceSize GetLastFrameUsage() const { return m_lastFrameUsage; }
+
+	private:
+		struct FrameBuffer
+		{
+			VkBuffer buffer{VK_NULL_HANDLE};
+			VulkanAllocation allocation;
+		};
+
+		VulkanMemoryAllocator *m_memoryAllocator{nullptr};
+		std::vector<FrameBuffer> m_frames;
+		VkDeviceSize m_bytesPerFrame{0};
+		VkDeviceSize m_uniformAlignment{1};
+		VkDeviceSize m_lastFrameUsage{0};
+
+		uint32_t m_frameIndex{0};
+		std::atomic<VkDeviceSize> m_head{0};
+		std::atomic<bool> m_hasOverflowed{false};
+	};
+}
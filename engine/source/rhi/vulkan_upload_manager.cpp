@@ -0,0 +1,563 @@
+#include "source/rhi/vulkan_upload_manager.h"
+#include "source/global/macro.h"
+#include "source/global/profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <tuple>
+
+namespace JMEngine
+{
+	// covers the texel block size of every color format up to four 32 bit channels
+	constexpr VkDeviceSize k_stagingAlignment = 16;
+
+	void UploadManager::Initialize(VkDevice device, VulkanMemoryAllocator *memoryAllocator, VkQueue transferQueue, uint32_t transferFamily,
+								   uint32_t graphicsFamily, VkDeviceSize stagingBytes, bool isTimelineSemaphoreEnabled)
+	{
+		m_device = device;
+		m_memoryAllocator = memoryAllocator;
+		m_transferQueue = transferQueue;
+		m_transferFamily = transferFamily;
+		m_graphicsFamily = graphicsFamily;
+		m_stagingCapacity = stagingBytes;
+
+		_vkCmdCopyBuffer = (PFN_vkCmdCopyBuffer)vkGetDeviceProcAddr(m_device, "vkCmdCopyBuffer");
+		_vkCmdCopyBufferToImage = (PFN_vkCmdCopyBufferToImage)vkGetDeviceProcAddr(m_device, "vkCmdCopyBufferToImage");
+		_vkCmdPipelineBarrier = (PFN_vkCmdPipelineBarrier)vkGetDeviceProcAddr(m_device, "vkCmdPipelineBarrier");
+		if (isTimelineSemaphoreEnabled)
+		{
+			m_timeline.Initialize(m_device);
+		}
+
+		VkCommandPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		// batches retire one at a time, each command buffer is reset on its own
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		poolInfo.queueFamilyIndex = m_transferFamily;
+		if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create upload command pool!");
+		}
+
+		VkBufferCreateInfo bufferInfo = {};
+		bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+		bufferInfo.size = m_stagingCapacity;
+		bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+		bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+		if (!m_memoryAllocator->CreateBuffer(bufferInfo, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+											 m_stagingBuffer, m_stagingAllocation))
+		{
+			LOG_ERROR("failed to create staging buffer!");
+			m_stagingCapacity = 0;
+		}
+	}
+
+	void UploadManager::Clear()
+	{
+		for (auto &batch : m_batches)
+		{
+			vkDestroyFence(m_device, batch.fence, nullptr);
+			vkDestroySemaphore(m_device, batch.semaphore, nullptr);
+		}
+		for (auto &batch : m_freeBatches)
+		{
+			vkDestroyFence(m_device, batch.fence, nullptr);
+			vkDestroySemaphore(m_device, batch.semaphore, nullptr);
+		}
+		m_batches.clear();
+		m_freeBatches.clear();
+		m_timeline.Clear();
+		// frees every command buffer with it
+		vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+		m_commandPool = VK_NULL_HANDLE;
+
+		if (m_stagingBuffer != VK_NULL_HANDLE)
+		{
+			m_memoryAllocator->DestroyBuffer(m_stagingBuffer, m_stagingAllocation);
+			m_stagingBuffer = VK_NULL_HANDLE;
+		}
+		m_stagedUploads.clear();
+		m_pendingUploads.clear();
+		m_pendingBytes = 0;
+		m_stagingHead = 0;
+		m_stagingTail = 0;
+	}
+
+	UploadTicket UploadManager::UploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size)
+	{
+		Upload upload;
+		upload.buffer = buffer;
+		upload.bufferRegion.dstOffset = offset;
+		upload.bufferRegion.size = size;
+		return Stage(std::move(upload), data, size);
+	}
+
+	UploadTicket UploadManager::UploadImage(VkImage image, VkImageAspectFlags aspect, uint32_t mipLevel, uint32_t arrayLayer, VkExtent3D extent,
+											VkImageLayout finalLayout, const void *data, VkDeviceSize size)
+	{
+		Upload upload;
+		upload.image = image;
+		upload.aspect = aspect;
+		upload.finalLayout = finalLayout;
+		upload.imageRegion.imageSubresource = {aspect, mipLevel, arrayLayer, 1};
+		upload.imageRegion.imageExtent = extent;
+		return Stage(std::move(upload), data, size);
+	}
+
+	UploadTicket UploadManager::Stage(Upload &&upload, const void *data, VkDeviceSize size)
+	{
+		if (size == 0 || size + k_stagingAlignment >= m_stagingCapacity)
+		{
+			LOG_ERROR("upload is larger than the staging ring, raise RHIInfo::stagingBytes");
+			return k_invalidUploadTicket;
+		}
+
+		std::unique_lock<std::mutex> lock(m_mutex);
+		VkDeviceSize stagingOffset = 0;
+		if (m_pendingUploads.empty() && AllocateStaging(size, stagingOffset))
+		{
+			upload.ticket = m_nextTicket++;
+			upload.stagingOffset = stagingOffset;
+			upload.stagingEnd = stagingOffset + size;
+			// deque elements stay put while others are added or the written prefix is flushed
+			Upload &staged = m_stagedUploads.emplace_back(std::move(upload));
+			UploadTicket ticket = staged.ticket;
+			lock.unlock();
+
+			// the copy runs without the lock, a large asset does not hold up other uploads or the render thread
+			memcpy(static_cast<char *>(m_stagingAllocation.mappedData) + stagingOffset, data, size);
+			m_memoryAllocator->Flush(m_stagingAllocation, stagingOffset, size);
+
+			lock.lock();
+			staged.isWritten = true;
+			return ticket;
+		}
+		lock.unlock();
+
+		PendingUpload pending;
+		pending.upload = std::move(upload);
+		pending.data.assign(static_cast<const uint8_t *>(data), static_cast<const uint8_t *>(data) + size);
+
+		lock.lock();
+		UploadTicket ticket = m_nextTicket++;
+		pending.upload.ticket = ticket;
+		m_pendingBytes += size;
+		m_pendingUploads.push_back(std::move(pending));
+		return ticket;
+	}
+
+	bool UploadManager::AllocateStaging(VkDeviceSize size, VkDeviceSize &offset)
+	{
+		offset = (m_stagingHead + k_stagingAlignment - 1) / k_stagingAlignment * k_stagingAlignment;
+		if (m_stagingHead >= m_stagingTail)
+		{
+			if (offset + size <= m_stagingCapacity)
+			{
+				m_stagingHead = offset + size;
+				return true;
+			}
+			// wrapping stays strictly below the tail so a full ring never looks empty
+			if (size < m_stagingTail)
+			{
+				offset = 0;
+				m_stagingHead = size;
+				return true;
+			}
+			return false;
+		}
+		if (offset + size < m_stagingTail)
+		{
+			m_stagingHead = offset + size;
+			return true;
+		}
+		return false;
+	}
+
+	void UploadManager::StagePending()
+	{
+		while (!m_pendingUploads.empty())
+		{
+			PendingUpload &pending = m_pendingUploads.front();
+			VkDeviceSize size = pending.data.size();
+			VkDeviceSize stagingOffset = 0;
+			if (!AllocateStaging(size, stagingOffset))
+			{
+				break;
+			}
+			memcpy(static_cast<char *>(m_stagingAllocation.mappedData) + stagingOffset, pending.data.data(), size);
+			m_memoryAllocator->Flush(m_stagingAllocation, stagingOffset, size);
+
+			Upload &staged = m_stagedUploads.emplace_back(std::move(pending.upload));
+			staged.stagingOffset = stagingOffset;
+			staged.stagingEnd = stagingOffset + size;
+			staged.isWritten = true;
+			m_pendingBytes -= size;
+			m_pendingUploads.pop_front();
+		}
+	}
+
+	void UploadManager::Flush()
+	{
+		PROFILE_FUNCTION();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		RetireFinishedBatches();
+		StagePending();
+
+		// uploads still being copied into the ring by their thread go with the next batch
+		auto end = m_stagedUploads.begin();
+		while (end != m_stagedUploads.end() && end->isWritten)
+		{
+			end++;
+		}
+		if (end == m_stagedUploads.begin())
+		{
+			return;
+		}
+
+		Batch batch = AcquireBatch();
+		RecordBatch(batch, m_stagedUploads.begin(), end);
+		batch.stagingEnd = std::prev(end)->stagingEnd;
+		batch.lastTicket = std::prev(end)->ticket;
+		m_stagedUploads.erase(m_stagedUploads.begin(), end);
+
+		VkSubmitInfo submitInfo = {};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.commandBuffer;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &batch.semaphore;
+		// tickets only grow, the last one of the batch is the value the timeline reaches
+		VkSemaphore timeline = m_timeline.GetHandle();
+		VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.signalSemaphoreValueCount = 1;
+		timelineInfo.pSignalSemaphoreValues = &batch.lastTicket;
+		if (m_timeline.IsValid())
+		{
+			submitInfo.pNext = &timelineInfo;
+			submitInfo.pSignalSemaphores = &timeline;
+		}
+		if (vkQueueSubmit(m_transferQueue, 1, &submitInfo, batch.fence) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to submit upload command buffer!");
+		}
+		m_batches.push_back(std::move(batch));
+	}
+
+	UploadManager::Batch UploadManager::AcquireBatch()
+	{
+		if (!m_freeBatches.empty())
+		{
+			Batch batch = std::move(m_freeBatches.back());
+			m_freeBatches.pop_back();
+			if (batch.fence != VK_NULL_HANDLE)
+			{
+				vkResetFences(m_device, 1, &batch.fence);
+			}
+			batch.bufferAcquires.clear();
+			batch.imageAcquires.clear();
+			batch.isFinished = false;
+			batch.isAcquired = false;
+			return batch;
+		}
+
+		Batch batch;
+		VkCommandBufferAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.commandPool = m_commandPool;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandBufferCount = 1;
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+		if (vkAllocateCommandBuffers(m_device, &allocInfo, &batch.commandBuffer) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create upload batch!");
+		}
+		if (!m_timeline.IsValid() && (vkCreateFence(m_device, &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS ||
+									  vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &batch.semaphore) != VK_SUCCESS))
+		{
+			LOG_ERROR("failed to create upload batch!");
+		}
+		return batch;
+	}
+
+	void UploadManager::RecordBatch(Batch &batch, std::deque<Upload>::iterator begin, std::deque<Upload>::iterator end)
+	{
+		bool isDedicated = IsDedicatedQueue();
+		uint32_t srcFamily = isDedicated ? m_transferFamily : VK_QUEUE_FAMILY_IGNORED;
+		uint32_t dstFamily = isDedicated ? m_graphicsFamily : VK_QUEUE_FAMILY_IGNORED;
+
+		// one copy command per destination and round however many uploads target it. regions of one command
+		// must not overlap, so a range written again in the batch goes to a later round, rounds are ordered
+		// by barriers and the last upload wins
+		struct CopyRound
+		{
+			std::unordered_map<VkBuffer, std::vector<VkBufferCopy>> bufferCopies;
+			std::unordered_map<VkImage, std::vector<VkBufferImageCopy>> imageCopies;
+		};
+		std::vector<CopyRound> rounds;
+		// per image subresource, its acquire barrier and the last round copying to it
+		std::map<std::tuple<VkImage, VkImageAspectFlags, uint32_t, uint32_t>, std::pair<size_t, size_t>> subresources;
+		std::vector<VkImageMemoryBarrier> toTransferBarriers;
+		uint32_t uploadCount = 0;
+		for (auto it = begin; it != end; it++)
+		{
+			const Upload &upload = *it;
+			uploadCount++;
+			if (upload.buffer != VK_NULL_HANDLE)
+			{
+				const VkBufferCopy &dst = upload.bufferRegion;
+				auto overlaps = [&dst](const VkBufferCopy &other)
+				{ return dst.dstOffset < other.dstOffset + other.size && other.dstOffset < dst.dstOffset + dst.size; };
+				size_t round = 0;
+				for (size_t r = rounds.size(); r-- > 0;)
+				{
+					auto copies = rounds[r].bufferCopies.find(upload.buffer);
+					if (copies != rounds[r].bufferCopies.end() && std::any_of(copies->second.begin(), copies->second.end(), overlaps))
+					{
+						round = r + 1;
+						break;
+					}
+				}
+				if (round == rounds.size())
+				{
+					rounds.emplace_back();
+				}
+				VkBufferCopy &region = rounds[round].bufferCopies[upload.buffer].emplace_back(upload.bufferRegion);
+				region.srcOffset = upload.stagingOffset;
+
+				VkBufferMemoryBarrier &acquire = batch.bufferAcquires.emplace_back();
+				acquire.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+				acquire.srcQueueFamilyIndex = srcFamily;
+				acquire.dstQueueFamilyIndex = dstFamily;
+				acquire.buffer = upload.buffer;
+				acquire.offset = region.dstOffset;
+				acquire.size = region.size;
+				continue;
+			}
+
+			// every upload replaces its whole subresource, a repeated one is copied again in a later round
+			// and only transitioned and acquired once, in the layout of its last upload
+			const VkImageSubresourceLayers &subresource = upload.imageRegion.imageSubresource;
+			auto [known, isFirst] = subresources.try_emplace({upload.image, upload.aspect, subresource.mipLevel, subresource.baseArrayLayer},
+															 batch.imageAcquires.size(), 0);
+			size_t round = isFirst ? 0 : known->second.second + 1;
+			known->second.second = round;
+			if (round == rounds.size())
+			{
+				rounds.emplace_back();
+			}
+			VkBufferImageCopy &region = rounds[round].imageCopies[upload.image].emplace_back(upload.imageRegion);
+			region.bufferOffset = upload.stagingOffset;
+			if (!isFirst)
+			{
+				batch.imageAcquires[known->second.first].newLayout = upload.finalLayout;
+				continue;
+			}
+			VkImageSubresourceRange range = {upload.aspect, subresource.mipLevel, 1, subresource.baseArrayLayer, 1};
+
+			// the level is replaced as a whole, its old contents are not needed
+			VkImageMemoryBarrier &toTransfer = toTransferBarriers.emplace_back();
+			toTransfer.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+			toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+			toTransfer.image = upload.image;
+			toTransfer.subresourceRange = range;
+
+			VkImageMemoryBarrier &acquire = batch.imageAcquires.emplace_back();
+			acquire.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+			acquire.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+			acquire.newLayout = upload.finalLayout;
+			acquire.srcQueueFamilyIndex = srcFamily;
+			acquire.dstQueueFamilyIndex = dstFamily;
+			acquire.image = upload.image;
+			acquire.subresourceRange = range;
+		}
+
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		vkBeginCommandBuffer(batch.commandBuffer, &beginInfo);
+
+		if (!toTransferBarriers.empty())
+		{
+			_vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+								  static_cast<uint32_t>(toTransferBarriers.size()), toTransferBarriers.data());
+		}
+		uint32_t copyCommandCount = 0;
+		for (size_t r = 0; r < rounds.size(); r++)
+		{
+			if (r > 0)
+			{
+				VkMemoryBarrier barrier = {};
+				barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+				barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+				_vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+			}
+			copyCommandCount += static_cast<uint32_t>(rounds[r].bufferCopies.size() + rounds[r].imageCopies.size());
+			for (const auto &[buffer, regions] : rounds[r].bufferCopies)
+			{
+				_vkCmdCopyBuffer(batch.commandBuffer, m_stagingBuffer, buffer, static_cast<uint32_t>(regions.size()), regions.data());
+			}
+			for (const auto &[image, regions] : rounds[r].imageCopies)
+			{
+				_vkCmdCopyBufferToImage(batch.commandBuffer, m_stagingBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+										static_cast<uint32_t>(regions.size()), regions.data());
+			}
+		}
+
+		if (isDedicated)
+		{
+			// the release half of the ownership transfer, the graphics queue records the matching acquire
+			std::vector<VkBufferMemoryBarrier> bufferReleases = batch.bufferAcquires;
+			std::vector<VkImageMemoryBarrier> imageReleases = batch.imageAcquires;
+			for (auto &release : bufferReleases)
+			{
+				release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			}
+			for (auto &release : imageReleases)
+			{
+				release.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			}
+			_vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr,
+								  static_cast<uint32_t>(bufferReleases.size()), bufferReleases.data(),
+								  static_cast<uint32_t>(imageReleases.size()), imageReleases.data());
+		}
+		else
+		{
+			// same queue, the acquire is a plain barrier after the semaphore wait
+			for (auto &acquire : batch.bufferAcquires)
+			{
+				acquire.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			}
+			for (auto &acquire : batch.imageAcquires)
+			{
+				acquire.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+			}
+		}
+		for (auto &acquire : batch.bufferAcquires)
+		{
+			acquire.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		}
+		for (auto &acquire : batch.imageAcquires)
+		{
+			acquire.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+		}
+
+		if (vkEndCommandBuffer(batch.commandBuffer) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to record upload command buffer!");
+		}
+		m_lastUploadCount = uploadCount;
+		m_lastCopyCommandCount = copyCommandCount;
+	}
+
+	void UploadManager::RetireFinishedBatches()
+	{
+		// the transfer queue finishes batches in submission order
+		UploadTicket finishedTicket = m_timeline.IsValid() ? m_timeline.GetCompletedValue() : k_invalidUploadTicket;
+		for (auto &batch : m_batches)
+		{
+			if (batch.isFinished)
+			{
+				continue;
+			}
+			bool isFinished = m_timeline.IsValid() ? batch.lastTicket <= finishedTicket : vkGetFenceStatus(m_device, batch.fence) == VK_SUCCESS;
+			if (!isFinished)
+			{
+				break;
+			}
+			batch.isFinished = true;
+			m_stagingTail = batch.stagingEnd;
+		}
+		if (m_stagingTail == m_stagingHead)
+		{
+			m_stagingHead = 0;
+			m_stagingTail = 0;
+		}
+	}
+
+	void UploadManager::AcquireCompleted(VkCommandBuffer commandBuffer, uint64_t frameNumber, std::vector<VkSemaphore> &waitSemaphores,
+										 std::vector<uint64_t> &waitValues)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			RetireFinishedBatches();
+		}
+
+		std::vector<VkBufferMemoryBarrier> bufferAcquires;
+		std::vector<VkImageMemoryBarrier> imageAcquires;
+		UploadTicket acquiredTicket = m_acquiredTicket.load(std::memory_order_relaxed);
+		for (auto &batch : m_batches)
+		{
+			// only finished batches, the semaphore wait is then already satisfied and never stalls graphics
+			if (!batch.isFinished)
+			{
+				break;
+			}
+			if (batch.isAcquired)
+			{
+				continue;
+			}
+			bufferAcquires.insert(bufferAcquires.end(), batch.bufferAcquires.begin(), batch.bufferAcquires.end());
+			imageAcquires.insert(imageAcquires.end(), batch.imageAcquires.begin(), batch.imageAcquires.end());
+			if (!m_timeline.IsValid())
+			{
+				waitSemaphores.push_back(batch.semaphore);
+				waitValues.push_back(0);
+			}
+			batch.isAcquired = true;
+			batch.acquireFrameNumber = frameNumber;
+			acquiredTicket = batch.lastTicket;
+		}
+		if (bufferAcquires.empty() && imageAcquires.empty())
+		{
+			return;
+		}
+
+		// one wait on the timeline covers every batch acquired
+		if (m_timeline.IsValid())
+		{
+			waitSemaphores.push_back(m_timeline.GetHandle());
+			waitValues.push_back(acquiredTicket);
+		}
+
+		// the consumers are unknown here, every later command sees the data
+		_vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 0, nullptr,
+							  static_cast<uint32_t>(bufferAcquires.size()), bufferAcquires.data(),
+							  static_cast<uint32_t>(imageAcquires.size()), imageAcquires.data());
+		m_acquiredTicket.store(acquiredTicket, std::memory_order_release);
+	}
+
+	void UploadManager::Update(uint64_t completedFrameNumber)
+	{
+		// a semaphore is reused only after the graphics submission waiting on it has completed
+		while (!m_batches.empty() && m_batches.front().isAcquired && m_batches.front().acquireFrameNumber <= completedFrameNumber)
+		{
+			m_freeBatches.push_back(std::move(m_batches.front()));
+			m_batches.pop_front();
+		}
+	}
+
+	UploadManagerStats UploadManager::GetStats()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		UploadManagerStats stats;
+		stats.stagingCapacity = m_stagingCapacity;
+		stats.stagingUsed = m_stagingHead >= m_stagingTail ? m_stagingHead - m_stagingTail : m_stagingCapacity - m_stagingTail + m_stagingHead;
+		stats.pendingBytes = m_pendingBytes;
+		stats.batchesInFlight = static_cast<uint32_t>(m_batches.size());
+		stats.uploadCount = m_lastUploadCount;
+		stats.copyCommandCount = m_lastCopyCommandCount;
+		stats.isDedicatedQueue = IsDedicatedQueue();
+		return stats;
+	}
+}
@@ -0,0 +1,150 @@
+#pragma once
+
+#include "source/rhi/vulkan_memory_allocator.h"
+#include "source/rhi/vulkan_timeline_semaphore.h"
+
+#include <vulkan/vulkan.h>
+
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace JMEngine
+{
+	// increases with every upload, an upload is complete once every ticket up to it is
+	using UploadTicket = uint64_t;
+	constexpr UploadTicket k_invalidUploadTicket = 0;
+
+	struct UploadManagerStats
+	{
+		VkDeviceSize stagingCapacity{0};
+		VkDeviceSize stagingUsed{0};
+		// waiting for room in the staging ring
+		VkDeviceSize pendingBytes{0};
+		uint32_t batchesInFlight{0};
+		// of the latest submitted batch
+		uint32_t uploadCount{0};
+		uint32_t copyCommandCount{0};
+		bool isDedicatedQueue{false};
+	};
+
+	// streams buffer and image data to the gpu on the transfer queue. uploads from any thread are copied
+	// into a persistently mapped staging ring, the render thread submits them once per frame merged into one
+	// copy command per destination, and the graphics queue takes ownership of a batch only after it has
+	// finished, so neither the render thread nor the graphics queue ever waits for a transfer
+	class UploadManager final
+	{
+	public:
+		// transferQueue may be the graphics queue when the device has no transfer only family, with timeline
+		// semaphores each batch signals the transfer timeline with its last ticket instead of a fence and a semaphore
+		void Initialize(VkDevice device, VulkanMemoryAllocator *memoryAllocator, VkQueue transferQueue, uint32_t transferFamily,
+						uint32_t graphicsFamily, VkDeviceSize stagingBytes, bool isTimelineSemaphoreEnabled);
+		// the device must be idle
+		void Clear();
+
+		// any thread, data is copied before returning, the destination may only be read by the graphics queue
+		// once IsComplete reports the ticket. k_invalidUploadTicket when size exceeds the staging ring
+		UploadTicket UploadBuffer(VkBuffer buffer, VkDeviceSize offset, const void *data, VkDeviceSize size);
+		// replaces one mip level of one layer, the previous contents of the level are discarded,
+		// it is left in finalLayout
+		UploadTicket UploadImage(VkImage image, VkImageAspectFlags aspect, uint32_t mipLevel, uint32_t arrayLayer, VkExtent3D extent,
+								 VkImageLayout finalLayout, const void *data, VkDeviceSize size);
+		inline bool IsComplete(UploadTicket ticket) const { return ticket <= m_acquiredTicket.load(std::memory_order_acquire); }
+
+		// render thread only, submits every fully written upload to the transfer queue
+		void Flush();
+		// render thread only, records the ownership acquires of finished batches at the start of a graphics
+		// command buffer, whose submission for frameNumber must wait on the semaphores appended to waitSemaphores,
+		// waitValues receives their timeline values, 0 for binary semaphores
+		void AcquireCompleted(VkCommandBuffer commandBuffer, uint64_t frameNumber, std::vector<VkSemaphore> &waitSemaphores,
+							  std::vector<uint64_t> &waitValues);
+		// recycles the batches acquired by completed graphics frames
+		void Update(uint64_t completedFrameNumber);
+
+		inline bool IsDedicatedQueue() const { return m_transferFamily != m_graphicsFamily; }
+		UploadManagerStats GetStats();
+
+	private:
+		struct Upload
+		{
+			UploadTicket ticket{k_invalidUploadTicket};
+			// null for image uploads
+			VkBuffer buffer{VK_NULL_HANDLE};
+			VkBufferCopy bufferRegion{};
+			VkImage image{VK_NULL_HANDLE};
+			VkImageAspectFlags aspect{0};
+			VkImageLayout finalLayout{VK_IMAGE_LAYOUT_UNDEFINED};
+			VkBufferImageCopy imageRegion{};
+			VkDeviceSize stagingOffset{0};
+			// where the staged data ends in the ring
+			VkDeviceSize stagingEnd{0};
+			bool isWritten{false};
+		};
+
+		struct PendingUpload
+		{
+			Upload upload;
+			std::vector<uint8_t> data;
+		};
+
+		struct Batch
+		{
+			VkCommandBuffer commandBuffer{VK_NULL_HANDLE};
+			// both null with timeline semaphores
+			VkFence fence{VK_NULL_HANDLE};
+			VkSemaphore semaphore{VK_NULL_HANDLE};
+			VkDeviceSize stagingEnd{0};
+			UploadTicket lastTicket{k_invalidUploadTicket};
+			std::vector<VkBufferMemoryBarrier> bufferAcquires;
+			std::vector<VkImageMemoryBarrier> imageAcquires;
+			bool isFinished{false};
+			bool isAcquired{false};
+			uint64_t acquireFrameNumber{0};
+		};
+
+		// under m_mutex, false when the ring has no room
+		bool AllocateStaging(VkDeviceSize size, VkDeviceSize &offset);
+		UploadTicket Stage(Upload &&upload, const void *data, VkDeviceSize size);
+		void StagePending();
+		Batch AcquireBatch();
+		void RecordBatch(Batch &batch, std::deque<Upload>::iterator begin, std::deque<Upload>::iterator end);
+		void RetireFinishedBatches();
+
+		VkDevice m_device{nullptr};
+		VulkanMemoryAllocator *m_memoryAllocator{nullptr};
+		VkQueue m_transferQueue{nullptr};
+		uint32_t m_transferFamily{0};
+		uint32_t m_graphicsFamily{0};
+		VkCommandPool m_commandPool{VK_NULL_HANDLE};
+		// reaches a batch's last ticket once it has finished, invalid without timeline semaphores
+		TimelineSemaphore m_timeline;
+
+		VkBuffer m_stagingBuffer{VK_NULL_HANDLE};
+		VulkanAllocation m_stagingAllocation;
+		VkDeviceSize m_stagingCapacity{0};
+		// [tail, head) is in use, wrapping around the end, head == tail only when the ring is empty
+		VkDeviceSize m_stagingHead{0};
+		VkDeviceSize m_stagingTail{0};
+
+		std::mutex m_mutex;
+		UploadTicket m_nextTicket{1};
+		// staged in ticket order, a prefix of written uploads is submitted by each Flush
+		std::deque<Upload> m_stagedUploads;
+		// every upload after the first one that did not fit waits here, to keep tickets in order
+		std::deque<PendingUpload> m_pendingUploads;
+		VkDeviceSize m_pendingBytes{0};
+
+		// render thread only, in submission order
+		std::deque<Batch> m_batches;
+		std::vector<Batch> m_freeBatches;
+		std::atomic<UploadTicket> m_acquiredTicket{k_invalidUploadTicket};
+		uint32_t m_lastUploadCount{0};
+		uint32_t m_lastCopyCommandCount{0};
+
+		PFN_vkCmdCopyBuffer _vkCmdCopyBuffer;
+		PFN_vkCmdCopyBufferToImage _vkCmdCopyBufferToImage;
+		PFN_vkCmdPipelineBarrier _vkCmdPipelineBarrier;
+	};
+}
@@ -1,6 +1,14 @@
 #include "source/vulkan_rhi.h"
 #include "source/global/macro.h"
+#include "source/global/profiler.h"
 
+#include "shader/generated/cpp/shader_permutations.h"
+
+#include <backends/imgui_impl_glfw.h>
+#include <imgui.h>
+
+#include <algorithm>
+#include <bit>
 #include <iostream>
 #include <set>
 
@@ -8,13 +16,25 @@ namespace JMEngine
 {
 	void VulkanRHI::OnWindowResized(GLFWwindow *window, int width, int height)
 	{
+		// a drag produces a burst of these, recreate once at the start of the next frame
 		JMEngine::VulkanRHI *app = reinterpret_cast<JMEngine::VulkanRHI *>(glfwGetWindowUserPointer(window));
-		app->RecreateSwapchain();
+		app->m_framebufferResized = true;
 	}
 
-	void VulkanRHI::Initialize(std::shared_ptr<WindowSystem> &windowSystem)
+	void VulkanRHI::Initialize(std::shared_ptr<WindowSystem> &windowSystem, const RHIInfo &info)
 	{
-		m_window = windowSystem->GetWindow();
+		PROFILE_FUNCTION();
+		m_isHeadless = info.isHeadless;
+		m_window = m_isHeadless ? nullptr : windowSystem->GetWindow();
+		m_maxFramesInFlight = std::max(info.maxFramesInFlight, 1u);
+		m_recordingThreadCount = std::max(info.recordingThreadCount, 1u);
+		m_uploadBytesPerFrame = info.uploadBytesPerFrame;
+		m_isPipelineStatisticsEnabled = info.isGpuProfilerEnabled && info.isPipelineStatisticsEnabled;
+		m_isPerformanceHudEnabled = info.isPerformanceHudEnabled;
+		m_isDepthPrepassEnabled = info.isDepthPrepassEnabled;
+		m_msaaSampleCount = static_cast<VkSampleCountFlagBits>(std::bit_floor(std::max<uint32_t>(info.msaaSampleCount, 1)));
+		m_isTimelineSemaphoreEnabled = info.isTimelineSemaphoreEnabled;
+		m_isDynamicRenderingEnabled = info.isDynamicRenderingEnabled;
 
 #ifdef NDEBUG
 		m_enableValidationLayers = false;
@@ -29,32 +49,127 @@ namespace JMEngine
 		m_enablePointLightShadow = true;
 #endif
 
+		if (m_isHeadless)
+		{
+			m_deviceExtensions.clear();
+			m_swapchainExtent = {info.headlessWidth, info.headlessHeight};
+		}
+
 		CreateInstance();
 		SetupDebugMessenger();
 		CreateSurface();
 		PickPhysicalDevice();
 		CreateLogicalDevice();
-		CreateSwapChain();
+		if (m_isTimelineSemaphoreEnabled)
+		{
+			m_isTimelineSemaphoreEnabled = m_graphicsTimeline.Initialize(m_device);
+		}
+		m_memoryAllocator.Initialize(m_device, m_physicalDevice, IsDeviceExtensionEnabled(VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME));
+		m_renderGraph.Initialize(m_device, &m_memoryAllocator, m_isDynamicRenderingEnabled, [this](std::function<void()> &&destroy)
+								 { DeferDestroy(std::move(destroy)); });
+		m_uploadAllocator.Initialize(m_physicalDevice, &m_memoryAllocator, m_maxFramesInFlight, m_uploadBytesPerFrame);
+		m_uploadManager.Initialize(m_device, &m_memoryAllocator, m_transferQueue,
+								   m_queueIndices.transferFamily.value_or(m_queueIndices.graphicsFamily.value()),
+								   m_queueIndices.graphicsFamily.value(), info.stagingBytes, m_isTimelineSemaphoreEnabled);
+		m_asyncCompute.Initialize(m_device, m_computeQueue, m_queueIndices.computeFamily.value(), m_queueIndices.graphicsFamily.value(),
+								  m_maxFramesInFlight, info.maxComputeDispatchesPerFrame, m_isTimelineSemaphoreEnabled ? &m_graphicsTimeline : nullptr);
+		m_geometryBuffer.Initialize(m_device, &m_memoryAllocator, &m_uploadManager, sizeof(Vertex), info.geometryVertexCapacity,
+									info.geometryIndexCapacity, [this](std::function<void()> &&destroy)
+									{ DeferDestroy(std::move(destroy)); });
+		m_pipelineCache.Initialize(m_device, m_physicalDevice, info.pipelineCachePath);
+		m_pipelineLibrary.Initialize(m_device, m_pipelineCache.GetHandle(), info.pipelineCompileThreadCount);
+		m_layoutCache.Initialize(m_device);
+		std::string shaderOverrideDirectory = info.shaderOverrideDirectory;
+		if (info.isShaderHotReloadEnabled)
+		{
+#if defined(JMENGINE_SHADER_SOURCE_DIR) && defined(JMENGINE_SHADER_INCLUDE_DIR) && defined(JMENGINE_GLSLANG_VALIDATOR)
+			if (shaderOverrideDirectory.empty())
+			{
+				shaderOverrideDirectory = "shader_hot_reload";
+			}
+			m_isShaderHotReloadEnabled = m_shaderHotReloader.Initialize(JMENGINE_SHADER_SOURCE_DIR, JMENGINE_SHADER_INCLUDE_DIR,
+																		shaderOverrideDirectory, JMENGINE_GLSLANG_VALIDATOR);
+#else
+			LOG_WARN("shader hot reload needs the shader source paths from the build");
+#endif
+		}
+		m_shaderLibrary.Initialize(shaderOverrideDirectory);
+		if (m_isHeadless)
+		{
+			CreateOffscreenTargets();
+		}
+		else
+		{
+			CreateSwapChain();
+		}
 		CreateImageViews();
+		CreatePresentSemaphores();
 		CreateRenderPass();
+		CreatePipelineLayout();
+		CreateDescriptorSets();
 		CreateGraphicsPipeline();
-		CreateFramebuffers();
 		CreateCommandPool();
-		CreateCommandBuffers();
-		CreateSemaphores();
+		CreateSyncObjects();
+
+		m_jobSystem.Initialize(m_recordingThreadCount - 1);
+		m_readbackRing.Initialize(m_device, &m_memoryAllocator, 2 * m_maxFramesInFlight);
+		if (info.isGpuProfilerEnabled)
+		{
+			m_gpuProfiler.Initialize(m_instance, m_physicalDevice, m_device, m_queueIndices.graphicsFamily.value(), m_maxFramesInFlight,
+									 IsDeviceExtensionEnabled(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME), m_isPipelineStatisticsEnabled);
+		}
+		if (m_isPerformanceHudEnabled)
+		{
+			CreateImGuiOverlay();
+		}
 
-		glfwSetWindowUserPointer(m_window, this);
-		glfwSetWindowSizeCallback(m_window, OnWindowResized);
+		if (!m_isHeadless)
+		{
+			glfwSetWindowUserPointer(m_window, this);
+			glfwSetWindowSizeCallback(m_window, OnWindowResized);
+		}
 	}
 
 	void VulkanRHI::Clear()
 	{
-		CleanUpSwapchain();
+		PROFILE_FUNCTION();
+		m_jobSystem.Clear();
+		m_shaderHotReloader.Clear();
 
-		vkDestroySemaphore(m_device, m_renderFinishedSemaphore, nullptr);
-		vkDestroySemaphore(m_device, m_imageAvailableSemaphore, nullptr);
+		// compiles still in flight may reference the render pass
+		vkDeviceWaitIdle(m_device);
+		m_pipelineLibrary.Clear();
+		DestroyImGuiOverlay();
 
-		vkDestroyCommandPool(m_device, m_commandPool, nullptr);
+		m_renderGraph.Clear();
+		CleanUpSwapchain();
+		FlushDeferredDestroys(true);
+		m_geometryBuffer.Clear();
+		m_uploadManager.Clear();
+		m_asyncCompute.Clear();
+		m_readbackRing.Clear();
+		m_gpuProfiler.Clear();
+		m_uploadAllocator.Clear();
+		m_memoryAllocator.Clear();
+		m_pipelineCache.Clear();
+
+		vkDestroyDescriptorPool(m_device, m_descriptorPool, nullptr);
+		m_layoutCache.Clear();
+		m_shaderLibrary.Clear();
+
+		for (VkFence fence : m_frameFences)
+		{
+			vkDestroyFence(m_device, fence, nullptr);
+		}
+		m_graphicsTimeline.Clear();
+		for (uint32_t i = 0; i < m_maxFramesInFlight; i++)
+		{
+			vkDestroySemaphore(m_device, m_imageAvailableSemaphores[i], nullptr);
+			for (auto &commandPool : m_commandPools[i])
+			{
+				commandPool.Clear();
+			}
+		}
 
 		vkDestroyDevice(m_device, nullptr);
 
@@ -62,57 +177,284 @@ namespace JMEngine
 		{
 			DestroyDebugUtilsMessengerEXT(m_instance, m_debugMessenger, nullptr);
 		}
-		vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+		if (!m_isHeadless)
+		{
+			vkDestroySurfaceKHR(m_instance, m_surface, nullptr);
+		}
 		vkDestroyInstance(m_instance, nullptr);
 	}
 
+	void VulkanRHI::BeginFrame()
+	{
+		if (m_isFrameBegun)
+		{
+			return;
+		}
+		PROFILE_FUNCTION();
+
+		int64_t frameBeginNs = Profiler::Now();
+		if (m_isPerformanceHudEnabled && m_lastFrameBeginNs != 0)
+		{
+			m_hudStats.cpuFrameMs = (frameBeginNs - m_lastFrameBeginNs) * 1e-6;
+			m_performanceHud.AddFrame(m_hudStats, m_gpuProfiler.GetLatestFrame());
+		}
+		m_lastFrameBeginNs = frameBeginNs;
+
+		// only block until the gpu has finished the frame that used this slot m_maxFramesInFlight frames ago
+		{
+			PROFILE_SCOPE("WaitForFrameFence");
+			if (m_isTimelineSemaphoreEnabled)
+			{
+				m_graphicsTimeline.Wait(m_frameSlotNumbers[m_currentFrame]);
+			}
+			else
+			{
+				_vkWaitForFences(m_device, 1, &m_frameFences[m_currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+			}
+		}
+		m_hudStats.fenceWaitMs = (Profiler::Now() - frameBeginNs) * 1e-6;
+		// the timeline also counts frames of other slots that have finished since
+		uint64_t completedFrameNumber = m_isTimelineSemaphoreEnabled ? m_graphicsTimeline.GetCompletedValue() : m_frameSlotNumbers[m_currentFrame];
+		m_completedFrameNumber = std::max(m_completedFrameNumber, completedFrameNumber);
+		FlushDeferredDestroys(false);
+		m_uploadManager.Update(m_completedFrameNumber);
+		m_geometryBuffer.Update();
+		m_asyncCompute.BeginFrame(m_currentFrame);
+		m_asyncCompute.Update(m_completedFrameNumber);
+		m_readbackRing.Update(m_completedFrameNumber);
+		m_gpuProfiler.Collect(m_currentFrame);
+
+		if (m_isShaderHotReloadEnabled)
+		{
+			ReloadShaders();
+		}
+		// the pipeline being replaced may still be in flight, the main and pre-pass pipelines switch together
+		// in RequestGraphicsPipelines, so the ones still bound are only retired after that
+		const VkPipeline boundPipelines[] = {m_graphicsPipeline, m_depthPrepassPipeline};
+		m_pipelineLibrary.CollectReplaced(boundPipelines, [this](VkPipeline pipeline)
+										  { DeferDestroy([this, pipeline]()
+														 { vkDestroyPipeline(m_device, pipeline, nullptr); }); });
+
+		// every buffer recorded for this slot has retired, recycle them all at once
+		for (auto &commandPool : m_commandPools[m_currentFrame])
+		{
+			commandPool.Reset();
+		}
+		m_uploadAllocator.BeginFrame(m_currentFrame);
+
+		if (m_isPerformanceHudEnabled)
+		{
+			BeginImGuiFrame();
+		}
+		m_isFrameBegun = true;
+	}
+
 	void VulkanRHI::DrawFrame()
 	{
-		vkQueueWaitIdle(m_presentQueue);
+		PROFILE_FUNCTION();
+		BeginFrame();
+
+		if (m_framebufferResized)
+		{
+			RecreateSwapchain();
+		}
 
 		uint32_t imageIndex;
-		VkResult result = vkAcquireNextImageKHR(m_device, m_swapchain, std::numeric_limits<uint64_t>::max(), m_imageAvailableSemaphore, VK_NULL_HANDLE, &imageIndex);
+		if (m_isHeadless)
+		{
+			// one offscreen target per slot, the slot's fence already guarantees it is free
+			imageIndex = m_currentFrame;
+		}
+		else
+		{
+			VkResult result = vkAcquireNextImageKHR(m_device, m_swapchain, std::numeric_limits<uint64_t>::max(), m_imageAvailableSemaphores[m_currentFrame], VK_NULL_HANDLE, &imageIndex);
+
+			if (result == VK_ERROR_OUT_OF_DATE_KHR)
+			{
+				// the slot's fence was never reset, the next BeginFrame goes straight through,
+				// dispatches already recorded are submitted with the next frame
+				m_drawCalls.clear();
+				m_isFrameBegun = false;
+				if (m_isPerformanceHudEnabled)
+				{
+					ImGui::EndFrame();
+				}
+				RecreateSwapchain();
+				return;
+			}
+			else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+			{
+				LOG_ERROR("failed to acquire swap chain image!");
+			}
+		}
 
-		if (result == VK_ERROR_OUT_OF_DATE_KHR)
+		// reset the fence only once work is guaranteed to be submitted with it
+		if (!m_isTimelineSemaphoreEnabled)
 		{
-			RecreateSwapchain();
-			return;
+			_vkResetFences(m_device, 1, &m_frameFences[m_currentFrame]);
 		}
-		else if (result != VK_SUCCESS && result != VK_SUBOPTIMAL_KHR)
+
+		if (m_isPerformanceHudEnabled)
 		{
-			LOG_ERROR("failed to acquire swap chain image!");
+			m_hudStats.drawCount = static_cast<uint32_t>(m_drawCalls.size());
+			m_hudStats.pipelineCount = m_pipelineLibrary.GetPipelineCount();
+			m_hudStats.pendingPipelineCount = m_pipelineLibrary.GetPendingCount();
+			m_hudStats.uploadCapacity = m_uploadAllocator.GetBytesPerFrame();
+			if (m_frameNumber % 30 == 0)
+			{
+				m_performanceHud.SetHeapStats(m_memoryAllocator.GetHeapStats());
+			}
+			m_performanceHud.Draw();
+			ImGui::Render();
 		}
 
+		// copies submitted now are picked up by a later frame, once the transfer queue has finished them
+		m_uploadManager.Flush();
+
+		int64_t recordBeginNs = Profiler::Now();
+		VkCommandBuffer commandBuffer = AcquireCommandBuffer(0);
+		RecordCommandBuffer(commandBuffer, imageIndex);
+		m_drawCalls.clear();
+		m_uploadAllocator.EndFrame();
+		m_hudStats.uploadBytes = m_uploadAllocator.GetLastFrameUsage();
+
 		VkSubmitInfo submitInfo = {};
 		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-		VkSemaphore waitSemaphores[] = {m_imageAvailableSemaphore};
-		VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-		submitInfo.waitSemaphoreCount = 1;
-		submitInfo.pWaitSemaphores = waitSemaphores;
-		submitInfo.pWaitDstStageMask = waitStages;
+		// values are only read for timeline semaphores, binary ones take 0
+		std::vector<VkSemaphore> waitSemaphores;
+		std::vector<uint64_t> waitValues;
+		std::vector<VkPipelineStageFlags> waitStages;
+		if (!m_isHeadless)
+		{
+			waitSemaphores.push_back(m_imageAvailableSemaphores[m_currentFrame]);
+			waitValues.push_back(0);
+			waitStages.push_back(VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		}
+		// the batches have already finished, the waits only complete the ownership transfer
+		for (VkSemaphore semaphore : m_uploadWaitSemaphores)
+		{
+			waitSemaphores.push_back(semaphore);
+			waitStages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		}
+		waitValues.insert(waitValues.end(), m_uploadWaitValues.begin(), m_uploadWaitValues.end());
+		waitSemaphores.insert(waitSemaphores.end(), m_computeWaitSemaphores.begin(), m_computeWaitSemaphores.end());
+		waitValues.insert(waitValues.end(), m_computeWaitValues.begin(), m_computeWaitValues.end());
+		waitStages.insert(waitStages.end(), m_computeWaitStages.begin(), m_computeWaitStages.end());
+		submitInfo.waitSemaphoreCount = static_cast<uint32_t>(waitSemaphores.size());
+		submitInfo.pWaitSemaphores = waitSemaphores.data();
+		submitInfo.pWaitDstStageMask = waitStages.data();
 		submitInfo.commandBufferCount = 1;
-		submitInfo.pCommandBuffers = &m_commandBuffers[imageIndex];
-		VkSemaphore signalSemaphores[] = {m_renderFinishedSemaphore};
-		submitInfo.signalSemaphoreCount = 1;
-		submitInfo.pSignalSemaphores = signalSemaphores;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		std::vector<VkSemaphore> signalSemaphores = m_computeSignalSemaphores;
+		std::vector<uint64_t> signalValues(signalSemaphores.size(), 0);
+		if (m_isTimelineSemaphoreEnabled)
+		{
+			signalSemaphores.push_back(m_graphicsTimeline.GetHandle());
+			signalValues.push_back(m_frameNumber + 1);
+		}
+		// kept last, present waits on it alone
+		if (!m_isHeadless)
+		{
+			signalSemaphores.push_back(m_renderFinishedSemaphores[imageIndex]);
+			signalValues.push_back(0);
+		}
+		submitInfo.signalSemaphoreCount = static_cast<uint32_t>(signalSemaphores.size());
+		submitInfo.pSignalSemaphores = signalSemaphores.data();
+
+		VkTimelineSemaphoreSubmitInfo timelineInfo = {};
+		timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount = static_cast<uint32_t>(waitValues.size());
+		timelineInfo.pWaitSemaphoreValues = waitValues.data();
+		timelineInfo.signalSemaphoreValueCount = static_cast<uint32_t>(signalValues.size());
+		timelineInfo.pSignalSemaphoreValues = signalValues.data();
+		if (m_isTimelineSemaphoreEnabled)
+		{
+			submitInfo.pNext = &timelineInfo;
+		}
 
-		if (vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE) != VK_SUCCESS)
+		int64_t submitBeginNs = Profiler::Now();
+		m_hudStats.recordMs = (submitBeginNs - recordBeginNs) * 1e-6;
+		m_hudStats.renderGraph = m_renderGraph.GetStats();
+		if (m_isPerformanceHudEnabled)
+		{
+			m_hudStats.streaming = m_uploadManager.GetStats();
+		}
+		VkFence frameFence = m_isTimelineSemaphoreEnabled ? VK_NULL_HANDLE : m_frameFences[m_currentFrame];
+		VkResult submitResult;
+		if (m_isDynamicRenderingEnabled)
+		{
+			// synchronization2 takes every semaphore with its own value and stages, binary ones ignore the value
+			std::vector<VkSemaphoreSubmitInfoKHR> waitInfos(waitSemaphores.size());
+			for (size_t i = 0; i < waitSemaphores.size(); i++)
+			{
+				waitInfos[i].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+				waitInfos[i].semaphore = waitSemaphores[i];
+				waitInfos[i].value = waitValues[i];
+				waitInfos[i].stageMask = waitStages[i];
+			}
+			std::vector<VkSemaphoreSubmitInfoKHR> signalInfos(signalSemaphores.size());
+			for (size_t i = 0; i < signalSemaphores.size(); i++)
+			{
+				signalInfos[i].sType = VK_STRUCTURE_TYPE_SEMAPHORE_SUBMIT_INFO_KHR;
+				signalInfos[i].semaphore = signalSemaphores[i];
+				signalInfos[i].value = signalValues[i];
+				signalInfos[i].stageMask = VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT_KHR;
+			}
+			VkCommandBufferSubmitInfoKHR commandBufferInfo = {};
+			commandBufferInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_SUBMIT_INFO_KHR;
+			commandBufferInfo.commandBuffer = commandBuffer;
+
+			VkSubmitInfo2KHR submitInfo2 = {};
+			submitInfo2.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO_2_KHR;
+			submitInfo2.waitSemaphoreInfoCount = static_cast<uint32_t>(waitInfos.size());
+			submitInfo2.pWaitSemaphoreInfos = waitInfos.data();
+			submitInfo2.commandBufferInfoCount = 1;
+			submitInfo2.pCommandBufferInfos = &commandBufferInfo;
+			submitInfo2.signalSemaphoreInfoCount = static_cast<uint32_t>(signalInfos.size());
+			submitInfo2.pSignalSemaphoreInfos = signalInfos.data();
+			submitResult = _vkQueueSubmit2KHR(m_graphicsQueue, 1, &submitInfo2, frameFence);
+		}
+		else
+		{
+			submitResult = vkQueueSubmit(m_graphicsQueue, 1, &submitInfo, frameFence);
+		}
+		if (submitResult != VK_SUCCESS)
 		{
 			LOG_ERROR("failed to submit draw command buffer!");
 		}
+		m_frameSlotNumbers[m_currentFrame] = ++m_frameNumber;
+		// after the graphics submission, whose semaphore the dispatches may wait on
+		m_asyncCompute.Submit(m_frameNumber);
+		m_hudStats.asyncCompute = m_asyncCompute.GetStats();
+		m_isFrameBegun = false;
+
+		if (m_isHeadless)
+		{
+			m_currentFrame = (m_currentFrame + 1) % m_maxFramesInFlight;
+			m_hudStats.submitMs = (Profiler::Now() - submitBeginNs) * 1e-6;
+			return;
+		}
 
 		VkPresentInfoKHR presentInfo = {};
 		presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
 		presentInfo.waitSemaphoreCount = 1;
-		presentInfo.pWaitSemaphores = signalSemaphores;
+		presentInfo.pWaitSemaphores = &signalSemaphores.back();
 		VkSwapchainKHR swapchains[] = {m_swapchain};
 		presentInfo.swapchainCount = 1;
 		presentInfo.pSwapchains = swapchains;
 		presentInfo.pImageIndices = &imageIndex;
 		presentInfo.pResults = nullptr; // Optional
 
-		result = vkQueuePresentKHR(m_presentQueue, &presentInfo);
+		VkResult result = vkQueuePresentKHR(m_presentQueue, &presentInfo);
+		m_hudStats.submitMs = (Profiler::Now() - submitBeginNs) * 1e-6;
+
+		if (result == VK_SUCCESS || result == VK_SUBOPTIMAL_KHR)
+		{
+			ReleaseRetiredSwapchains();
+		}
+		m_currentFrame = (m_currentFrame + 1) % m_maxFramesInFlight;
+
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR)
 		{
 			RecreateSwapchain();
@@ -123,25 +465,158 @@ namespace JMEngine
 		}
 	}
 
+	void VulkanRHI::SubmitDraw(const DrawCall &drawCall)
+	{
+		m_drawCalls.push_back(drawCall);
+	}
+
+	MeshId VulkanRHI::CreateMesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices)
+	{
+		return m_geometryBuffer.CreateMesh(vertices.data(), static_cast<uint32_t>(vertices.size()), indices);
+	}
+
+	ComputePipeline VulkanRHI::CreateComputePipeline(const std::string &shaderName, const std::vector<SpecializationConstant> &specializationConstants)
+	{
+		ComputePipeline pipeline;
+		std::span<const uint32_t> code = m_shaderLibrary.Load(shaderName);
+		ShaderReflection reflection;
+		if (code.empty() || !SpirvReflection::Reflect(code, reflection) || reflection.stage != VK_SHADER_STAGE_COMPUTE_BIT)
+		{
+			LOG_ERROR("failed to load compute shader " + shaderName);
+			return pipeline;
+		}
+
+		ReflectedPipelineLayout layout = m_layoutCache.GetReflectedLayout({&reflection});
+		if (layout.setLayouts.size() > 1)
+		{
+			LOG_WARN("compute shader " + shaderName + " declares sets past 0, dispatches only bind set 0");
+		}
+		pipeline.layout = layout.pipelineLayout;
+		pipeline.setLayout = layout.setLayouts.empty() ? m_layoutCache.GetSetLayout({}) : layout.setLayouts[0];
+		for (const ShaderResourceBinding &binding : reflection.bindings)
+		{
+			if (binding.set != 0)
+			{
+				continue;
+			}
+			if (binding.binding >= pipeline.bindingTypes.size())
+			{
+				pipeline.bindingTypes.resize(binding.binding + 1, VK_DESCRIPTOR_TYPE_MAX_ENUM);
+			}
+			pipeline.bindingTypes[binding.binding] = binding.type;
+		}
+		for (const VkPushConstantRange &range : reflection.pushConstantRanges)
+		{
+			pipeline.pushConstantSize = std::max(pipeline.pushConstantSize, range.offset + range.size);
+		}
+
+		ComputePipelineDesc desc;
+		desc.computeShader = m_pipelineLibrary.RegisterShader(code);
+		desc.specializationConstants = specializationConstants;
+		std::sort(desc.specializationConstants.begin(), desc.specializationConstants.end(),
+				  [](const SpecializationConstant &a, const SpecializationConstant &b)
+				  { return a.constantId < b.constantId; });
+		desc.layout = layout.pipelineLayout;
+		pipeline.pipeline = m_pipelineLibrary.GetOrCreate(desc);
+		return pipeline;
+	}
+
+	void VulkanRHI::DispatchCompute(const ComputeDispatch &dispatch)
+	{
+		BeginFrame();
+		m_asyncCompute.Dispatch(dispatch);
+	}
+
+	void VulkanRHI::DestroyMesh(MeshId mesh)
+	{
+		m_geometryBuffer.DestroyMesh(mesh);
+	}
+
+	UploadAllocation VulkanRHI::AllocateUpload(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		BeginFrame();
+		return m_uploadAllocator.Allocate(size, alignment);
+	}
+
+	UploadAllocation VulkanRHI::AllocateUniform(VkDeviceSize size)
+	{
+		BeginFrame();
+		return m_uploadAllocator.AllocateUniform(size);
+	}
+
+	void VulkanRHI::CaptureFrame(ReadbackCallback &&callback)
+	{
+		m_readbackRequests.push_back({VK_NULL_HANDLE, 0, 0, std::move(callback)});
+	}
+
+	std::future<std::vector<char>> VulkanRHI::CaptureFrame()
+	{
+		auto promise = std::make_shared<std::promise<std::vector<char>>>();
+		std::future<std::vector<char>> future = promise->get_future();
+		CaptureFrame([promise](const ReadbackResult &result)
+					 {
+						 const char *data = static_cast<const char *>(result.data);
+						 promise->set_value(std::vector<char>(data, data + result.size));
+					 });
+		return future;
+	}
+
+	void VulkanRHI::ReadbackBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, ReadbackCallback &&callback)
+	{
+		m_readbackRequests.push_back({buffer, offset, size, std::move(callback)});
+	}
+
+	void VulkanRHI::DeferDestroy(std::function<void()> &&destroy)
+	{
+		m_deferredDestroys.push_back({m_frameNumber, std::move(destroy)});
+	}
+
+	void VulkanRHI::FlushDeferredDestroys(bool isForced)
+	{
+		while (!m_deferredDestroys.empty() &&
+			   (isForced || m_deferredDestroys.front().frameNumber <= m_completedFrameNumber))
+		{
+			m_deferredDestroys.front().destroy();
+			m_deferredDestroys.pop_front();
+		}
+	}
+
 	void VulkanRHI::RecreateSwapchain()
 	{
+		PROFILE_FUNCTION();
+		// minimized, nothing to present until the window comes back
 		int width = 0, height = 0;
+		glfwGetFramebufferSize(m_window, &width, &height);
 		while (width == 0 || height == 0)
 		{
-			glfwGetFramebufferSize(m_window, &width, &height);
 			glfwWaitEvents();
+			glfwGetFramebufferSize(m_window, &width, &height);
 		}
+		m_framebufferResized = false;
 
-		vkDeviceWaitIdle(m_device);
-
-		CleanUpSwapchain();
+		// frames still in flight keep using the old objects, they are destroyed once those retire
+		VkFormat oldImageFormat = m_swapchainImageFormat;
+		RetireSwapchain();
 
 		CreateSwapChain();
 		CreateImageViews();
-		CreateRenderPass();
-		CreateGraphicsPipeline();
-		CreateFramebuffers();
-		CreateCommandBuffers();
+		CreatePresentSemaphores();
+
+		// viewport and scissor are dynamic, so only a format change invalidates the render pass and pipeline,
+		// the render graph keeps the old render pass cached in case the format comes back. pipelines built for
+		// dynamic rendering stay cached the same way, keyed by the old format
+		if (m_swapchainImageFormat != oldImageFormat)
+		{
+			if (!m_isDynamicRenderingEnabled)
+			{
+				m_pipelineLibrary.Evict(m_renderPass, [this](VkPipeline pipeline)
+										{ DeferDestroy([this, pipeline]()
+													   { vkDestroyPipeline(m_device, pipeline, nullptr); }); });
+			}
+
+			CreateRenderPass();
+			CreateGraphicsPipeline();
+		}
 	}
 
 	void VulkanRHI::CreateInstance()
@@ -158,6 +633,23 @@ namespace JMEngine
 		appInfo.pEngineName = "JMEngine";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.apiVersion = VK_API_VERSION_1_0;
+		// timeline semaphores are core in 1.2, the device must report 1.2 as well before they are used.
+		// dynamic rendering and synchronization2 build on features2 and depth stencil resolve, core by 1.2 too
+		auto enumerateInstanceVersion = (PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(nullptr, "vkEnumerateInstanceVersion");
+		uint32_t instanceVersion = VK_API_VERSION_1_0;
+		if (enumerateInstanceVersion != nullptr)
+		{
+			enumerateInstanceVersion(&instanceVersion);
+		}
+		if ((m_isTimelineSemaphoreEnabled || m_isDynamicRenderingEnabled) && instanceVersion >= VK_API_VERSION_1_2)
+		{
+			appInfo.apiVersion = VK_API_VERSION_1_2;
+		}
+		else
+		{
+			m_isTimelineSemaphoreEnabled = false;
+			m_isDynamicRenderingEnabled = false;
+		}
 
 		VkInstanceCreateInfo createInfo = {};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -205,6 +697,11 @@ namespace JMEngine
 
 	void VulkanRHI::CreateSurface()
 	{
+		if (m_isHeadless)
+		{
+			return;
+		}
+
 		if (glfwCreateWindowSurface(m_instance, m_window, nullptr, &m_surface) != VK_SUCCESS)
 		{
 			LOG_ERROR("failed to create window surface!");
@@ -277,6 +774,10 @@ namespace JMEngine
 		std::set<uint32_t> queueFamilies = {m_queueIndices.graphicsFamily.value(),
 											m_queueIndices.presentFamily.value(),
 											m_queueIndices.computeFamily.value()};
+		if (m_queueIndices.transferFamily.has_value())
+		{
+			queueFamilies.insert(m_queueIndices.transferFamily.value());
+		}
 
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : queueFamilies) // for every queue family
@@ -307,9 +808,116 @@ namespace JMEngine
 			physicalDeviceFeatures.geometryShader = VK_TRUE;
 		}
 
+		// only sampled by the gpu profiler
+		VkPhysicalDeviceFeatures supportedFeatures;
+		vkGetPhysicalDeviceFeatures(m_physicalDevice, &supportedFeatures);
+		// secondary command buffers run inside the statistics query of their pass
+		if (m_isPipelineStatisticsEnabled && !(supportedFeatures.pipelineStatisticsQuery && supportedFeatures.inheritedQueries))
+		{
+			LOG_WARN("pipeline statistics queries are not supported, only timestamps are profiled");
+			m_isPipelineStatisticsEnabled = false;
+		}
+		physicalDeviceFeatures.pipelineStatisticsQuery = m_isPipelineStatisticsEnabled ? VK_TRUE : VK_FALSE;
+		physicalDeviceFeatures.inheritedQueries = m_isPipelineStatisticsEnabled ? VK_TRUE : VK_FALSE;
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(m_physicalDevice, &properties);
+		VkSampleCountFlags sampleCounts = properties.limits.framebufferColorSampleCounts & properties.limits.framebufferDepthSampleCounts;
+		while (m_msaaSampleCount > VK_SAMPLE_COUNT_1_BIT && !(sampleCounts & m_msaaSampleCount))
+		{
+			m_msaaSampleCount = static_cast<VkSampleCountFlagBits>(m_msaaSampleCount >> 1);
+		}
+
+		// reverse-z keeps its precision in a float buffer, packed 24 bit depth is the fallback
+		for (VkFormat format : {VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT})
+		{
+			VkFormatProperties formatProperties;
+			vkGetPhysicalDeviceFormatProperties(m_physicalDevice, format, &formatProperties);
+			if (formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT)
+			{
+				m_depthFormat = format;
+				break;
+			}
+		}
+		if (m_depthFormat == VK_FORMAT_UNDEFINED)
+		{
+			LOG_ERROR("no supported depth format!");
+		}
+
+		// optional extensions are enabled when present, query IsDeviceExtensionEnabled before using them
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(m_physicalDevice, nullptr, &extensionCount, availableExtensions.data());
+		auto isExtensionAvailable = [&availableExtensions](const char *extensionName)
+		{
+			return std::any_of(availableExtensions.begin(), availableExtensions.end(), [extensionName](const VkExtensionProperties &extension)
+							   { return strcmp(extension.extensionName, extensionName) == 0; });
+		};
+		for (const char *optionalExtension : m_optionalDeviceExtensions)
+		{
+			if (isExtensionAvailable(optionalExtension))
+			{
+				m_deviceExtensions.push_back(optionalExtension);
+			}
+		}
+
+		// feature structs of extensions the device lacks must not be chained into the query
+		bool isVersion12 = properties.apiVersion >= VK_API_VERSION_1_2;
+		m_isTimelineSemaphoreEnabled = m_isTimelineSemaphoreEnabled && isVersion12;
+		m_isDynamicRenderingEnabled = m_isDynamicRenderingEnabled && isVersion12 && isExtensionAvailable(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME) &&
+									  isExtensionAvailable(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+		VkPhysicalDeviceTimelineSemaphoreFeatures timelineFeatures = {};
+		timelineFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+		VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures = {};
+		dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+		VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features = {};
+		synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+		if (m_isTimelineSemaphoreEnabled || m_isDynamicRenderingEnabled)
+		{
+			auto getPhysicalDeviceFeatures2 = (PFN_vkGetPhysicalDeviceFeatures2)vkGetInstanceProcAddr(m_instance, "vkGetPhysicalDeviceFeatures2");
+			VkPhysicalDeviceFeatures2 features2 = {};
+			features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+			features2.pNext = &timelineFeatures;
+			if (m_isDynamicRenderingEnabled)
+			{
+				timelineFeatures.pNext = &dynamicRenderingFeatures;
+				dynamicRenderingFeatures.pNext = &synchronization2Features;
+			}
+			getPhysicalDeviceFeatures2(m_physicalDevice, &features2);
+		}
+		m_isTimelineSemaphoreEnabled = m_isTimelineSemaphoreEnabled && timelineFeatures.timelineSemaphore == VK_TRUE;
+		if (!m_isTimelineSemaphoreEnabled)
+		{
+			LOG_INFO("timeline semaphores are not supported, frames are synchronized with fences");
+		}
+		m_isDynamicRenderingEnabled = m_isDynamicRenderingEnabled && dynamicRenderingFeatures.dynamicRendering == VK_TRUE &&
+									  synchronization2Features.synchronization2 == VK_TRUE;
+		if (!m_isDynamicRenderingEnabled)
+		{
+			LOG_INFO("dynamic rendering or synchronization2 is not supported, passes use render pass objects");
+		}
+
+		// only the enabled features are chained into the device
+		void *enabledFeatures = nullptr;
+		if (m_isDynamicRenderingEnabled)
+		{
+			m_deviceExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+			m_deviceExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+			synchronization2Features.pNext = nullptr;
+			dynamicRenderingFeatures.pNext = &synchronization2Features;
+			enabledFeatures = &dynamicRenderingFeatures;
+		}
+		if (m_isTimelineSemaphoreEnabled)
+		{
+			timelineFeatures.pNext = enabledFeatures;
+			enabledFeatures = &timelineFeatures;
+		}
+
 		// device create info
 		VkDeviceCreateInfo deviceCreateInfo{};
 		deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+		deviceCreateInfo.pNext = enabledFeatures;
 		deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
 		deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		deviceCreateInfo.pEnabledFeatures = &physicalDeviceFeatures;
@@ -335,6 +943,11 @@ namespace JMEngine
 		vkGetDeviceQueue(m_device, m_queueIndices.graphicsFamily.value(), 0, &m_graphicsQueue);
 		vkGetDeviceQueue(m_device, m_queueIndices.presentFamily.value(), 0, &m_presentQueue);
 		vkGetDeviceQueue(m_device, m_queueIndices.computeFamily.value(), 0, &m_computeQueue);
+		m_transferQueue = m_graphicsQueue;
+		if (m_queueIndices.transferFamily.has_value())
+		{
+			vkGetDeviceQueue(m_device, m_queueIndices.transferFamily.value(), 0, &m_transferQueue);
+		}
 
 		// more efficient pointer
 		_vkResetCommandPool = (PFN_vkResetCommandPool)vkGetDeviceProcAddr(m_device, "vkResetCommandPool");
@@ -343,16 +956,22 @@ namespace JMEngine
 		_vkCmdBeginRenderPass = (PFN_vkCmdBeginRenderPass)vkGetDeviceProcAddr(m_device, "vkCmdBeginRenderPass");
 		_vkCmdNextSubpass = (PFN_vkCmdNextSubpass)vkGetDeviceProcAddr(m_device, "vkCmdNextSubpass");
 		_vkCmdEndRenderPass = (PFN_vkCmdEndRenderPass)vkGetDeviceProcAddr(m_device, "vkCmdEndRenderPass");
+		if (m_isDynamicRenderingEnabled)
+		{
+			_vkQueueSubmit2KHR = (PFN_vkQueueSubmit2KHR)vkGetDeviceProcAddr(m_device, "vkQueueSubmit2KHR");
+		}
 		_vkCmdBindPipeline = (PFN_vkCmdBindPipeline)vkGetDeviceProcAddr(m_device, "vkCmdBindPipeline");
 		_vkCmdSetViewport = (PFN_vkCmdSetViewport)vkGetDeviceProcAddr(m_device, "vkCmdSetViewport");
 		_vkCmdSetScissor = (PFN_vkCmdSetScissor)vkGetDeviceProcAddr(m_device, "vkCmdSetScissor");
 		_vkWaitForFences = (PFN_vkWaitForFences)vkGetDeviceProcAddr(m_device, "vkWaitForFences");
 		_vkResetFences = (PFN_vkResetFences)vkGetDeviceProcAddr(m_device, "vkResetFences");
+		_vkCmdDraw = (PFN_vkCmdDraw)vkGetDeviceProcAddr(m_device, "vkCmdDraw");
 		_vkCmdDrawIndexed = (PFN_vkCmdDrawIndexed)vkGetDeviceProcAddr(m_device, "vkCmdDrawIndexed");
 		_vkCmdBindVertexBuffers = (PFN_vkCmdBindVertexBuffers)vkGetDeviceProcAddr(m_device, "vkCmdBindVertexBuffers");
 		_vkCmdBindIndexBuffer = (PFN_vkCmdBindIndexBuffer)vkGetDeviceProcAddr(m_device, "vkCmdBindIndexBuffer");
 		_vkCmdBindDescriptorSets = (PFN_vkCmdBindDescriptorSets)vkGetDeviceProcAddr(m_device, "vkCmdBindDescriptorSets");
 		_vkCmdClearAttachments = (PFN_vkCmdClearAttachments)vkGetDeviceProcAddr(m_device, "vkCmdClearAttachments");
+		_vkCmdExecuteCommands = (PFN_vkCmdExecuteCommands)vkGetDeviceProcAddr(m_device, "vkCmdExecuteCommands");
 	}
 
 	void VulkanRHI::CreateSwapChain()
@@ -378,6 +997,12 @@ namespace JMEngine
 		createInfo.imageExtent = extent;
 		createInfo.imageArrayLayers = 1;
 		createInfo.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		// needed to capture frames
+		m_isSwapchainReadable = swapChainSupport.capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		if (m_isSwapchainReadable)
+		{
+			createInfo.imageUsage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+		}
 
 		uint32_t queueFamilyIndices[] = {(uint32_t)m_queueIndices.graphicsFamily.value(), (uint32_t)m_queueIndices.presentFamily.value()};
 
@@ -397,7 +1022,8 @@ namespace JMEngine
 		createInfo.presentMode = presentMode;
 		createInfo.clipped = VK_TRUE;
 
-		createInfo.oldSwapchain = VK_NULL_HANDLE;
+		// lets the driver hand over resources, the old swapchain is retired but not yet destroyed, see RetireSwapchain
+		createInfo.oldSwapchain = m_swapchain;
 
 		if (vkCreateSwapchainKHR(m_device, &createInfo, nullptr, &m_swapchain) != VK_SUCCESS)
 		{
@@ -412,6 +1038,37 @@ namespace JMEngine
 		m_swapchainExtent = extent;
 	}
 
+	void VulkanRHI::CreateOffscreenTargets()
+	{
+		// one color target per frame in flight so frames never wait on each other's image
+		m_swapchainImageFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		m_swapchainImages.resize(m_maxFramesInFlight);
+		m_offscreenImageAllocations.resize(m_maxFramesInFlight);
+
+		for (uint32_t i = 0; i < m_maxFramesInFlight; i++)
+		{
+			VkImageCreateInfo imageInfo = {};
+			imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+			imageInfo.imageType = VK_IMAGE_TYPE_2D;
+			imageInfo.format = m_swapchainImageFormat;
+			imageInfo.extent = {m_swapchainExtent.width, m_swapchainExtent.height, 1};
+			imageInfo.mipLevels = 1;
+			imageInfo.arrayLayers = 1;
+			imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+			imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+			imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+			imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+			imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+			// render targets are kept out of the shared blocks
+			if (!m_memoryAllocator.CreateImage(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0,
+											   m_swapchainImages[i], m_offscreenImageAllocations[i], true))
+			{
+				LOG_ERROR("failed to create offscreen image!");
+			}
+		}
+	}
+
 	void VulkanRHI::CreateImageViews()
 	{
 		m_swapchainImageViews.resize(m_swapchainImages.size());
@@ -438,309 +1095,775 @@ namespace JMEngine
 
 	void VulkanRHI::CreateRenderPass()
 	{
-		VkAttachmentDescription colorAttachment = {};
+		// the graph begins rendering on the views directly, pipelines only need the formats
+		if (m_isDynamicRenderingEnabled)
+		{
+			m_renderPass = VK_NULL_HANDLE;
+			m_depthPrepassRenderPass = VK_NULL_HANDLE;
+			return;
+		}
+
+		// the same ones the graph builds for the main pass and the pre-pass, pipelines are created against them
+		RenderGraphAttachment depthAttachment;
+		depthAttachment.format = m_depthFormat;
+		depthAttachment.samples = m_msaaSampleCount;
+		depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		if (m_isDepthPrepassEnabled)
+		{
+			m_depthPrepassRenderPass = m_renderGraph.GetRenderPass({}, &depthAttachment);
+			depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+			depthAttachment.isReadOnly = true;
+		}
+		depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+
+		RenderGraphAttachment colorAttachment;
 		colorAttachment.format = m_swapchainImageFormat;
-		colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachment.samples = m_msaaSampleCount;
 		colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-		colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-		colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-		colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-		colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		if (m_msaaSampleCount == VK_SAMPLE_COUNT_1_BIT)
+		{
+			m_renderPass = m_renderGraph.GetRenderPass({colorAttachment}, &depthAttachment);
+			return;
+		}
+
+		colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		RenderGraphAttachment resolveAttachment;
+		resolveAttachment.format = m_swapchainImageFormat;
+		resolveAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		m_renderPass = m_renderGraph.GetRenderPass({colorAttachment}, &depthAttachment, {resolveAttachment});
+	}
+
+	void VulkanRHI::CreatePipelineLayout()
+	{
+		std::vector<uint32_t> constantIds;
+		// set 0 binding 0 takes the per draw uniforms from the upload ring
+		ReflectedPipelineLayout layout = LoadShaderStages("test.vert", "test.frag", m_graphicsPipelineDesc, constantIds, {{0, 0}});
+		if (layout.setLayouts.empty())
+		{
+			LOG_ERROR("shaders do not declare the per draw uniform block!");
+			layout.setLayouts.push_back(m_layoutCache.GetSetLayout({}));
+		}
+		m_pipelineLayout = layout.pipelineLayout;
+		m_perDrawSetLayout = layout.setLayouts[0];
+	}
+
+	ReflectedPipelineLayout VulkanRHI::LoadShaderStages(const std::string &vertexName, const std::string &fragmentName, GraphicsPipelineDesc &desc, std::vector<uint32_t> &constantIds,
+														const std::vector<DescriptorBindingSlot> &dynamicBuffers)
+	{
+		std::span<const uint32_t> vertShaderCode = m_shaderLibrary.Load(vertexName);
+		std::span<const uint32_t> fragShaderCode = m_shaderLibrary.Load(fragmentName);
+
+		desc.vertexShader = m_pipelineLibrary.RegisterShader(vertShaderCode);
+		desc.fragmentShader = m_pipelineLibrary.RegisterShader(fragShaderCode);
+		m_shaderIds[vertexName] = desc.vertexShader;
+		m_shaderIds[fragmentName] = desc.fragmentShader;
+
+		ShaderReflection vertReflection;
+		ShaderReflection fragReflection;
+		if (!SpirvReflection::Reflect(vertShaderCode, vertReflection) || !SpirvReflection::Reflect(fragShaderCode, fragReflection))
+		{
+			LOG_ERROR("failed to reflect shaders " + vertexName + ", " + fragmentName);
+		}
+
+		constantIds.clear();
+		for (const ShaderReflection *reflection : {&vertReflection, &fragReflection})
+		{
+			for (const ShaderSpecializationConstant &constant : reflection->specializationConstants)
+			{
+				if (constant.size != sizeof(uint32_t))
+				{
+					LOG_WARN("specialization constant " + std::to_string(constant.constantId) + " is not 4 bytes and cannot be permuted");
+					continue;
+				}
+				constantIds.push_back(constant.constantId);
+			}
+		}
+
+		ReflectedPipelineLayout layout = m_layoutCache.GetReflectedLayout({&vertReflection, &fragReflection}, dynamicBuffers);
+		desc.layout = layout.pipelineLayout;
+		return layout;
+	}
+
+	void VulkanRHI::CreateDescriptorSets()
+	{
+		VkDescriptorPoolSize poolSize = {};
+		poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+		poolSize.descriptorCount = m_maxFramesInFlight;
 
-		VkAttachmentReference colorAttachmentRef = {};
-		colorAttachmentRef.attachment = 0;
-		colorAttachmentRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		VkDescriptorPoolCreateInfo poolInfo = {};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		poolInfo.maxSets = m_maxFramesInFlight;
 
-		VkSubpassDescription subpass = {};
-		subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-		subpass.colorAttachmentCount = 1;
-		subpass.pColorAttachments = &colorAttachmentRef;
+		if (vkCreateDescriptorPool(m_device, &poolInfo, nullptr, &m_descriptorPool) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to create descriptor pool!");
+		}
 
-		VkSubpassDependency dependency = {};
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.dstSubpass = 0;
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.srcAccessMask = 0;
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		std::vector<VkDescriptorSetLayout> layouts(m_maxFramesInFlight, m_perDrawSetLayout);
+		VkDescriptorSetAllocateInfo allocInfo = {};
+		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool = m_descriptorPool;
+		allocInfo.descriptorSetCount = m_maxFramesInFlight;
+		allocInfo.pSetLayouts = layouts.data();
 
-		VkRenderPassCreateInfo renderPassInfo = {};
-		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-		renderPassInfo.attachmentCount = 1;
-		renderPassInfo.pAttachments = &colorAttachment;
-		renderPassInfo.subpassCount = 1;
-		renderPassInfo.pSubpasses = &subpass;
-		renderPassInfo.dependencyCount = 1;
-		renderPassInfo.pDependencies = &dependency;
+		m_perDrawDescriptorSets.resize(m_maxFramesInFlight);
+		if (vkAllocateDescriptorSets(m_device, &allocInfo, m_perDrawDescriptorSets.data()) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to allocate descriptor sets!");
+		}
 
-		if (vkCreateRenderPass(m_device, &renderPassInfo, nullptr, &m_renderPass) != VK_SUCCESS)
+		// written once, draws only change the dynamic offset
+		for (uint32_t i = 0; i < m_maxFramesInFlight; i++)
 		{
-			LOG_ERROR("failed to create render pass!");
+			VkDescriptorBufferInfo bufferInfo = {};
+			bufferInfo.buffer = m_uploadAllocator.GetBuffer(i);
+			bufferInfo.offset = 0;
+			bufferInfo.range = FrameUploadAllocator::k_dynamicUniformRange;
+
+			VkWriteDescriptorSet descriptorWrite = {};
+			descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descriptorWrite.dstSet = m_perDrawDescriptorSets[i];
+			descriptorWrite.dstBinding = 0;
+			descriptorWrite.dstArrayElement = 0;
+			descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+			descriptorWrite.descriptorCount = 1;
+			descriptorWrite.pBufferInfo = &bufferInfo;
+
+			vkUpdateDescriptorSets(m_device, 1, &descriptorWrite, 0, nullptr);
 		}
 	}
 
 	void VulkanRHI::CreateGraphicsPipeline()
 	{
-		// TODO: write an interface
-		auto vertShaderCode = AssetManager::ReadFile("D:/code/JMEngine/engine/shader/generated/spv/test.vert.spv");
-		auto fragShaderCode = AssetManager::ReadFile("D:/code/JMEngine/engine/shader/generated/spv/test.frag.spv");
-
-		VkShaderModule vertShaderModule;
-		VkShaderModule fragShaderModule;
-		vertShaderModule = CreateShaderModule(vertShaderCode);
-		fragShaderModule = CreateShaderModule(fragShaderCode);
-
-		VkPipelineShaderStageCreateInfo vertShaderStageInfo = {};
-		vertShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		vertShaderStageInfo.stage = VK_SHADER_STAGE_VERTEX_BIT;
-		vertShaderStageInfo.module = vertShaderModule;
-		vertShaderStageInfo.pName = "main";
-
-		VkPipelineShaderStageCreateInfo fragShaderStageInfo = {};
-		fragShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-		fragShaderStageInfo.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-		fragShaderStageInfo.module = fragShaderModule;
-		fragShaderStageInfo.pName = "main";
-
-		VkPipelineShaderStageCreateInfo shaderStages[] = {vertShaderStageInfo, fragShaderStageInfo};
-
-		// vertex
-		VkPipelineVertexInputStateCreateInfo vertexInputInfo = {};
-		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-		vertexInputInfo.vertexBindingDescriptionCount = 0;
-		vertexInputInfo.pVertexBindingDescriptions = nullptr; // Optional
-		vertexInputInfo.vertexAttributeDescriptionCount = 0;
-		vertexInputInfo.pVertexAttributeDescriptions = nullptr; // Optional
-
-		// pipeline input
-		VkPipelineInputAssemblyStateCreateInfo inputAssembly = {};
-		inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-		inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
-		inputAssembly.primitiveRestartEnable = VK_FALSE;
-
-		// viewport
-		VkViewport viewport = {};
-		viewport.x = 0.0f;
-		viewport.y = 0.0f;
-		viewport.width = (float)m_swapchainExtent.width;
-		viewport.height = (float)m_swapchainExtent.height;
-		viewport.minDepth = 0.0f;
-		viewport.maxDepth = 1.0f;
+		SetMainPassState(m_graphicsPipelineDesc);
+		m_depthPrepassPipelineDesc = GetDepthPrepassDesc(m_graphicsPipelineDesc);
 
-		VkRect2D scissor = {};
-		scissor.offset = {0, 0};
-		scissor.extent = m_swapchainExtent;
+		// compiles in the background, draws are skipped until it is ready
+		m_graphicsPipeline = VK_NULL_HANDLE;
+		m_depthPrepassPipeline = VK_NULL_HANDLE;
+		m_isGraphicsPipelinePending = true;
+		RequestGraphicsPipelines();
+
+		PrewarmPipelines();
+	}
 
-		VkPipelineViewportStateCreateInfo viewportState = {};
-		viewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-		viewportState.viewportCount = 1;
-		viewportState.pViewports = &viewport;
-		viewportState.scissorCount = 1;
-		viewportState.pScissors = &scissor;
-
-		// rasterization
-		VkPipelineRasterizationStateCreateInfo rasterizer = {};
-		rasterizer.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO;
-		rasterizer.depthClampEnable = VK_FALSE;
-		rasterizer.rasterizerDiscardEnable = VK_FALSE;
-		rasterizer.polygonMode = VK_POLYGON_MODE_FILL;
-		rasterizer.lineWidth = 1.0f;
-		rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-		rasterizer.frontFace = VK_FRONT_FACE_CLOCKWISE;
-		rasterizer.depthBiasEnable = VK_FALSE;
-		rasterizer.depthBiasConstantFactor = 0.0f; // Optional
-		rasterizer.depthBiasClamp = 0.0f;		   // Optional
-		rasterizer.depthBiasSlopeFactor = 0.0f;	   // Optional
-
-		// mutisample
-		VkPipelineMultisampleStateCreateInfo multisampling = {};
-		multisampling.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-		multisampling.sampleShadingEnable = VK_FALSE;
-		multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
-		multisampling.minSampleShading = 1.0f;			// Optional
-		multisampling.pSampleMask = nullptr;			// Optional
-		multisampling.alphaToCoverageEnable = VK_FALSE; // Optional
-		multisampling.alphaToOneEnable = VK_FALSE;		// Optional
-
-		// blend
-		VkPipelineColorBlendAttachmentState colorBlendAttachment = {};
-		colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-		colorBlendAttachment.blendEnable = VK_FALSE;
-		colorBlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
-		colorBlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-		colorBlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
-		colorBlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
-		colorBlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
-		colorBlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
-
-		VkPipelineColorBlendStateCreateInfo colorBlending = {};
-		colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
-		colorBlending.logicOpEnable = VK_FALSE;
-		colorBlending.logicOp = VK_LOGIC_OP_COPY; // Optional
-		colorBlending.attachmentCount = 1;
-		colorBlending.pAttachments = &colorBlendAttachment;
-		colorBlending.blendConstants[0] = 0.0f; // Optional
-		colorBlending.blendConstants[1] = 0.0f; // Optional
-		colorBlending.blendConstants[2] = 0.0f; // Optional
-		colorBlending.blendConstants[3] = 0.0f; // Optional
-
-		// pipeline layout
-		VkPipelineLayoutCreateInfo pipelineLayoutInfo = {};
-		pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-		pipelineLayoutInfo.setLayoutCount = 0;		   // Optional
-		pipelineLayoutInfo.pSetLayouts = nullptr;	   // Optional
-		pipelineLayoutInfo.pushConstantRangeCount = 0; // Optional
-		pipelineLayoutInfo.pPushConstantRanges = 0;	   // Optional
-
-		if (vkCreatePipelineLayout(m_device, &pipelineLayoutInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
-		{
-			LOG_ERROR("failed to create pipeline layout!");
-		}
-
-		// create pipeline
-		VkGraphicsPipelineCreateInfo pipelineInfo = {};
-		pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-		pipelineInfo.stageCount = 2;
-		pipelineInfo.pStages = shaderStages;
-		pipelineInfo.pVertexInputState = &vertexInputInfo;
-		pipelineInfo.pInputAssemblyState = &inputAssembly;
-		pipelineInfo.pViewportState = &viewportState;
-		pipelineInfo.pRasterizationState = &rasterizer;
-		pipelineInfo.pMultisampleState = &multisampling;
-		pipelineInfo.pDepthStencilState = nullptr; // Optional
-		pipelineInfo.pColorBlendState = &colorBlending;
-		pipelineInfo.pDynamicState = nullptr; // Optional
-		pipelineInfo.layout = m_pipelineLayout;
-		pipelineInfo.renderPass = m_renderPass;
-		pipelineInfo.subpass = 0;
-		pipelineInfo.basePipelineHandle = VK_NULL_HANDLE; // Optional
-		pipelineInfo.basePipelineIndex = -1;			  // Optional
-
-		if (vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &m_graphicsPipeline) != VK_SUCCESS)
-		{
-			LOG_ERROR("failed to create graphics pipeline!");
-		}
-
-		vkDestroyShaderModule(m_device, fragShaderModule, nullptr);
-		vkDestroyShaderModule(m_device, vertShaderModule, nullptr);
-	}
-
-	void VulkanRHI::CreateFramebuffers()
-	{
-		m_swapchainFramebuffers.resize(m_swapchainImageViews.size());
+	void VulkanRHI::SetMainPassState(GraphicsPipelineDesc &desc) const
+	{
+		desc.renderPass = m_renderPass;
+		desc.colorFormats = {m_swapchainImageFormat};
+		desc.depthFormat = m_depthFormat;
+		desc.sampleCount = m_msaaSampleCount;
+		// after a pre-pass only the nearest fragment of each pixel passes
+		desc.isDepthTestEnabled = true;
+		desc.isDepthWriteEnabled = !m_isDepthPrepassEnabled;
+		desc.depthCompareOp = m_isDepthPrepassEnabled ? VK_COMPARE_OP_EQUAL : VK_COMPARE_OP_GREATER_OR_EQUAL;
+		// one binding over the shared vertex buffer
+		desc.vertexBindings = {{0, sizeof(Vertex), VK_VERTEX_INPUT_RATE_VERTEX}};
+		desc.vertexAttributes = {{0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, position)},
+								 {1, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(Vertex, color)}};
+	}
 
-		for (size_t i = 0; i < m_swapchainImageViews.size(); i++)
+	GraphicsPipelineDesc VulkanRHI::GetDepthPrepassDesc(const GraphicsPipelineDesc &desc) const
+	{
+		GraphicsPipelineDesc depthDesc = desc;
+		depthDesc.fragmentShader = 0;
+		depthDesc.colorAttachmentCount = 0;
+		depthDesc.colorFormats.clear();
+		depthDesc.isDepthWriteEnabled = true;
+		depthDesc.depthCompareOp = VK_COMPARE_OP_GREATER_OR_EQUAL;
+		depthDesc.renderPass = m_depthPrepassRenderPass;
+		return depthDesc;
+	}
+
+	void VulkanRHI::RequestGraphicsPipelines()
+	{
+		// the previous permutation keeps drawing while a new one compiles, the pre-pass and the main pass
+		// switch together since the equal test needs depth from the same vertex shader
+		VkPipeline pipeline = m_pipelineLibrary.Request(m_graphicsPipelineDesc);
+		VkPipeline depthPrepassPipeline = m_isDepthPrepassEnabled ? m_pipelineLibrary.Request(m_depthPrepassPipelineDesc) : VK_NULL_HANDLE;
+		if (pipeline != VK_NULL_HANDLE && (!m_isDepthPrepassEnabled || depthPrepassPipeline != VK_NULL_HANDLE))
+		{
+			m_graphicsPipeline = pipeline;
+			m_depthPrepassPipeline = depthPrepassPipeline;
+			m_isGraphicsPipelinePending = false;
+		}
+	}
+
+	void VulkanRHI::PrewarmPipelines()
+	{
+		PROFILE_FUNCTION();
+		// permutations listed in shader/permutations.txt, queued behind the main pipeline
+		for (const ShaderPermutation &permutation : SHADER_PERMUTATIONS)
 		{
-			VkImageView attachments[] = {
-				m_swapchainImageViews[i]};
+			GraphicsPipelineDesc desc;
+			std::vector<uint32_t> constantIds;
+			LoadShaderStages(permutation.vertexShader, permutation.fragmentShader, desc, constantIds, {{0, 0}});
+			SetMainPassState(desc);
 
-			VkFramebufferCreateInfo framebufferInfo = {};
-			framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-			framebufferInfo.renderPass = m_renderPass;
-			framebufferInfo.attachmentCount = 1;
-			framebufferInfo.pAttachments = attachments;
-			framebufferInfo.width = m_swapchainExtent.width;
-			framebufferInfo.height = m_swapchainExtent.height;
-			framebufferInfo.layers = 1;
+			for (size_t i = 0; i < permutation.constantCount; i++)
+			{
+				const ShaderPermutationConstant &constant = SHADER_PERMUTATION_CONSTANTS[permutation.firstConstant + i];
+				if (std::find(constantIds.begin(), constantIds.end(), constant.constantId) == constantIds.end())
+				{
+					LOG_WARN(std::string(permutation.vertexShader) + ", " + permutation.fragmentShader + " do not declare specialization constant " + std::to_string(constant.constantId));
+					continue;
+				}
+				desc.SetSpecializationConstant(constant.constantId, constant.value);
+			}
 
-			if (vkCreateFramebuffer(m_device, &framebufferInfo, nullptr, &m_swapchainFramebuffers[i]) != VK_SUCCESS)
+			m_pipelineLibrary.Request(desc);
+			if (m_isDepthPrepassEnabled)
 			{
-				LOG_ERROR("failed to create framebuffer!");
+				m_pipelineLibrary.Request(GetDepthPrepassDesc(desc));
 			}
 		}
 	}
 
+	void VulkanRHI::ReloadShaders()
+	{
+		PROFILE_FUNCTION();
+		// the interface must stay the same, layouts are not rebuilt
+		for (const std::string &name : m_shaderHotReloader.PollCompiled())
+		{
+			auto it = m_shaderIds.find(name);
+			if (it == m_shaderIds.end())
+			{
+				continue;
+			}
+			ShaderId newShader = m_pipelineLibrary.RegisterShader(m_shaderLibrary.Load(name));
+			ShaderId oldShader = it->second;
+			if (newShader == 0 || newShader == oldShader)
+			{
+				continue;
+			}
+
+			m_pipelineLibrary.ReplaceShader(oldShader, newShader);
+			if (m_graphicsPipelineDesc.vertexShader == oldShader || m_graphicsPipelineDesc.fragmentShader == oldShader)
+			{
+				m_graphicsPipelineDesc.vertexShader = m_graphicsPipelineDesc.vertexShader == oldShader ? newShader : m_graphicsPipelineDesc.vertexShader;
+				m_graphicsPipelineDesc.fragmentShader = m_graphicsPipelineDesc.fragmentShader == oldShader ? newShader : m_graphicsPipelineDesc.fragmentShader;
+				m_depthPrepassPipelineDesc = GetDepthPrepassDesc(m_graphicsPipelineDesc);
+				m_isGraphicsPipelinePending = true;
+			}
+			m_imguiRenderer.ReplaceShader(oldShader, newShader);
+			// even before it compiles, the library keeps a failed replacement pending so the next save
+			// from here still retires the pipeline that is drawing
+			it->second = newShader;
+		}
+	}
+
+	void VulkanRHI::CreateImGuiOverlay()
+	{
+		IMGUI_CHECKVERSION();
+		ImGui::CreateContext();
+		ImGuiIO &io = ImGui::GetIO();
+		io.IniFilename = nullptr;
+		ImGui::StyleColorsDark();
+		if (!m_isHeadless)
+		{
+			// chains the window's existing input callbacks
+			ImGui_ImplGlfw_InitForVulkan(m_window, true);
+		}
+
+		// set 0 binding 0 is the texture, the transform is a push constant
+		GraphicsPipelineDesc desc;
+		std::vector<uint32_t> constantIds;
+		ReflectedPipelineLayout layout = LoadShaderStages("imgui.vert", "imgui.frag", desc, constantIds, {});
+		desc.sampleCount = m_msaaSampleCount;
+		if (layout.setLayouts.empty())
+		{
+			LOG_ERROR("imgui shaders do not declare a texture!");
+			layout.setLayouts.push_back(m_layoutCache.GetSetLayout({}));
+		}
+		m_imguiRenderer.Initialize(m_device, &m_memoryAllocator, &m_uploadAllocator, &m_pipelineLibrary, desc, layout.setLayouts[0]);
+		m_performanceHud.Initialize();
+	}
+
+	void VulkanRHI::DestroyImGuiOverlay()
+	{
+		if (!m_isPerformanceHudEnabled)
+		{
+			return;
+		}
+		m_imguiRenderer.Clear();
+		if (!m_isHeadless)
+		{
+			ImGui_ImplGlfw_Shutdown();
+		}
+		ImGui::DestroyContext();
+	}
+
+	void VulkanRHI::BeginImGuiFrame()
+	{
+		ImGuiIO &io = ImGui::GetIO();
+		if (m_isHeadless)
+		{
+			// no platform backend, the offscreen target is the display
+			io.DisplaySize = ImVec2(static_cast<float>(m_swapchainExtent.width), static_cast<float>(m_swapchainExtent.height));
+			io.DeltaTime = m_hudStats.cpuFrameMs > 0.0 ? static_cast<float>(m_hudStats.cpuFrameMs * 1e-3) : 1.0f / 60.0f;
+		}
+		else
+		{
+			ImGui_ImplGlfw_NewFrame();
+		}
+		ImGui::NewFrame();
+	}
+
+	void VulkanRHI::SetSpecializationConstant(uint32_t constantId, uint32_t value)
+	{
+		m_graphicsPipelineDesc.SetSpecializationConstant(constantId, value);
+		m_depthPrepassPipelineDesc = GetDepthPrepassDesc(m_graphicsPipelineDesc);
+		m_isGraphicsPipelinePending = true;
+	}
+
 	void VulkanRHI::CreateCommandPool()
 	{
+		m_commandPools.resize(m_maxFramesInFlight);
 
-		VkCommandPoolCreateInfo poolInfo = {};
-		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-		poolInfo.queueFamilyIndex = m_queueIndices.graphicsFamily.value();
-		poolInfo.flags = 0; // Optional
+		for (uint32_t i = 0; i < m_maxFramesInFlight; i++)
+		{
+			m_commandPools[i].resize(m_recordingThreadCount);
+			for (auto &commandPool : m_commandPools[i])
+			{
+				commandPool.Initialize(m_device, m_queueIndices.graphicsFamily.value());
+			}
+		}
+	}
+
+	VkCommandBuffer VulkanRHI::AcquireCommandBuffer(uint32_t threadIndex, VkCommandBufferLevel level)
+	{
+		return m_commandPools[m_currentFrame][threadIndex].Acquire(level);
+	}
+
+	void VulkanRHI::RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		PROFILE_FUNCTION();
+		VkCommandBufferBeginInfo beginInfo = {};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = nullptr; // Optional
+
+		if (_vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+		{
+			LOG_ERROR("failed to begin recording command buffer!");
+		}
 
-		if (vkCreateCommandPool(m_device, &poolInfo, nullptr, &m_commandPool) != VK_SUCCESS)
+		// without any pipeline the frame still clears and presents but its draws are dropped
+		if (m_isGraphicsPipelinePending)
+		{
+			RequestGraphicsPipelines();
+		}
+		size_t drawCount = m_graphicsPipeline != VK_NULL_HANDLE ? m_drawCalls.size() : 0;
+
+		m_gpuProfiler.BeginFrame(commandBuffer, m_currentFrame, m_frameNumber + 1);
+		m_uploadWaitSemaphores.clear();
+		m_uploadWaitValues.clear();
+		m_uploadManager.AcquireCompleted(commandBuffer, m_frameNumber + 1, m_uploadWaitSemaphores, m_uploadWaitValues);
+		m_computeWaitSemaphores.clear();
+		m_computeWaitValues.clear();
+		m_computeWaitStages.clear();
+		m_asyncCompute.AcquireResults(commandBuffer, m_frameNumber + 1, m_computeWaitSemaphores, m_computeWaitValues, m_computeWaitStages);
+		if (m_isPerformanceHudEnabled)
+		{
+			m_imguiRenderer.RecordUploads(commandBuffer);
+		}
+		BuildRenderGraph(imageIndex, drawCount);
+		m_renderGraph.Compile();
+		m_renderGraph.Execute(commandBuffer, &m_gpuProfiler);
+		m_gpuProfiler.EndFrame(commandBuffer);
+		m_computeSignalSemaphores.clear();
+		m_asyncCompute.ReleaseToCompute(commandBuffer, m_computeSignalSemaphores);
+
+		if (_vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
 		{
-			LOG_ERROR("failed to create command pool!");
+			LOG_ERROR("failed to record command buffer!");
 		}
 	}
 
-	void VulkanRHI::CreateCommandBuffers()
+	void VulkanRHI::BuildRenderGraph(uint32_t imageIndex, size_t drawCount)
 	{
-		m_commandBuffers.resize(m_swapchainFramebuffers.size());
+		m_renderGraph.Reset();
+
+		// the acquire semaphore is waited on at color attachment output, which is where the image becomes available
+		RenderGraphImportedTexture backbuffer;
+		backbuffer.image = m_swapchainImages[imageIndex];
+		backbuffer.view = m_swapchainImageViews[imageIndex];
+		backbuffer.format = m_swapchainImageFormat;
+		backbuffer.extent = m_swapchainExtent;
+		backbuffer.initialStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		// headless targets are only ever copied out
+		backbuffer.finalLayout = m_isHeadless ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+		RenderGraphResource backbufferResource = m_renderGraph.ImportTexture("backbuffer", backbuffer);
+
+		bool isSecondary = m_recordingThreadCount > 1 && drawCount >= 2 * k_minDrawsPerRecordingJob;
+		// cleared to 0, the far plane under reverse-z
+		RenderGraphResource depth = m_renderGraph.CreateTexture("depth", {m_depthFormat, m_swapchainExtent, m_msaaSampleCount});
+		if (m_isDepthPrepassEnabled)
+		{
+			RenderGraphPassBuilder depthPrepass = m_renderGraph.AddPass("depth prepass", [this, isSecondary, drawCount](const RenderGraphPassContext &context)
+																		{
+																			if (isSecondary)
+																			{
+																				RecordSecondaryCommandBuffers(context, m_depthPrepassPipeline, false);
+																				_vkCmdExecuteCommands(context.commandBuffer, static_cast<uint32_t>(m_secondaryCommandBuffers.size()),
+																									  m_secondaryCommandBuffers.data());
+																				return;
+																			}
+																			RecordDraws(context.commandBuffer, m_depthPrepassPipeline, 0, drawCount); });
+			depthPrepass.WriteDepth(depth, VK_ATTACHMENT_LOAD_OP_CLEAR, {0.0f, 0});
+			if (isSecondary)
+			{
+				depthPrepass.SetSecondaryContents();
+			}
+		}
 
-		VkCommandBufferAllocateInfo allocInfo = {};
-		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-		allocInfo.commandPool = m_commandPool;
-		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandBufferCount = (uint32_t)m_commandBuffers.size();
+		RenderGraphPassBuilder mainPass = m_renderGraph.AddPass("main", [this, isSecondary, drawCount](const RenderGraphPassContext &context)
+																{
+																	if (isSecondary)
+																	{
+																		RecordSecondaryCommandBuffers(context, m_graphicsPipeline, true);
+																		_vkCmdExecuteCommands(context.commandBuffer, static_cast<uint32_t>(m_secondaryCommandBuffers.size()),
+																							  m_secondaryCommandBuffers.data());
+																		return;
+																	}
+																	RecordDraws(context.commandBuffer, m_graphicsPipeline, 0, drawCount);
+																	if (m_isPerformanceHudEnabled)
+																	{
+																		m_imguiRenderer.RecordDraws(context.commandBuffer, context);
+																	} });
+		if (m_msaaSampleCount == VK_SAMPLE_COUNT_1_BIT)
+		{
+			mainPass.WriteColor(backbufferResource, VK_ATTACHMENT_LOAD_OP_CLEAR, {{0.0f, 0.0f, 0.0f, 1.0f}});
+		}
+		else
+		{
+			// never leaves the pass, on tilers the samples stay in tile memory and only the resolve is written out
+			RenderGraphResource msaaColor = m_renderGraph.CreateTexture("msaa color", {m_swapchainImageFormat, m_swapchainExtent, m_msaaSampleCount});
+			mainPass.WriteColor(msaaColor, VK_ATTACHMENT_LOAD_OP_CLEAR, {{0.0f, 0.0f, 0.0f, 1.0f}});
+			mainPass.ResolveColor(msaaColor, backbufferResource);
+		}
+		if (m_isDepthPrepassEnabled)
+		{
+			mainPass.ReadDepth(depth);
+		}
+		else
+		{
+			mainPass.WriteDepth(depth, VK_ATTACHMENT_LOAD_OP_CLEAR, {0.0f, 0});
+		}
+		if (isSecondary)
+		{
+			mainPass.SetSecondaryContents();
+		}
 
-		if (vkAllocateCommandBuffers(m_device, &allocInfo, m_commandBuffers.data()) != VK_SUCCESS)
+		if (m_readbackRequests.empty())
 		{
-			LOG_ERROR("failed to allocate command buffers!");
+			return;
 		}
+		bool isImageReadback = false;
+		for (const auto &request : m_readbackRequests)
+		{
+			isImageReadback |= request.buffer == VK_NULL_HANDLE;
+		}
+		RenderGraphPassBuilder readbackPass = m_renderGraph.AddPass("readback", [this, imageIndex](const RenderGraphPassContext &context)
+																	{ RecordReadbacks(context.commandBuffer, imageIndex); });
+		readbackPass.SetSideEffect();
+		if (isImageReadback && (m_isHeadless || m_isSwapchainReadable))
+		{
+			readbackPass.Read(backbufferResource, RenderGraphUsage::TransferSrc);
+		}
+	}
+
+	void VulkanRHI::RecordReadbacks(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+	{
+		// the graph moved the target to transfer source for this pass
+		VkImageLayout targetLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+		uint64_t frameNumber = m_frameNumber + 1;
+
+		for (auto &request : m_readbackRequests)
+		{
+			if (request.buffer == VK_NULL_HANDLE && !m_isHeadless && !m_isSwapchainReadable)
+			{
+				LOG_WARN("the swapchain does not support transfer source usage, dropping frame capture");
+			}
+			else if (request.buffer == VK_NULL_HANDLE)
+			{
+				// every color format picked for targets is 8 bits per channel rgba or bgra
+				m_readbackRing.ReadbackImage(commandBuffer, m_swapchainImages[imageIndex], targetLayout, m_swapchainExtent,
+											 m_swapchainImageFormat, 4, frameNumber, std::move(request.callback));
+			}
+			else
+			{
+				m_readbackRing.ReadbackBuffer(commandBuffer, request.buffer, request.offset, request.size,
+											  frameNumber, std::move(request.callback));
+			}
+		}
+		m_readbackRequests.clear();
+	}
 
-		for (size_t i = 0; i < m_commandBuffers.size(); i++)
+	void VulkanRHI::RecordSecondaryCommandBuffers(const RenderGraphPassContext &context, VkPipeline pipeline, bool isOverlayRecorded)
+	{
+		size_t drawCount = m_drawCalls.size();
+		uint32_t jobCount = static_cast<uint32_t>(std::min<size_t>(m_recordingThreadCount, drawCount / k_minDrawsPerRecordingJob));
+		size_t drawsPerJob = (drawCount + jobCount - 1) / jobCount;
+
+		m_secondaryCommandBuffers.assign(jobCount, VK_NULL_HANDLE);
+
+		VkCommandBufferInheritanceInfo inheritanceInfo = {};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = context.renderPass;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = context.framebuffer;
+		if (m_gpuProfiler.IsPipelineStatisticsEnabled())
+		{
+			inheritanceInfo.pipelineStatistics = GpuProfiler::k_pipelineStatistics;
+		}
+		// without a render pass the secondaries are told the attachment formats instead, of the depth formats
+		// the device is checked for only D24S8 has stencil
+		VkCommandBufferInheritanceRenderingInfoKHR renderingInfo = {};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO_KHR;
+		renderingInfo.colorAttachmentCount = static_cast<uint32_t>(context.colorFormats.size());
+		renderingInfo.pColorAttachmentFormats = context.colorFormats.data();
+		renderingInfo.depthAttachmentFormat = context.depthFormat;
+		renderingInfo.stencilAttachmentFormat = context.depthFormat == VK_FORMAT_D24_UNORM_S8_UINT ? context.depthFormat : VK_FORMAT_UNDEFINED;
+		renderingInfo.rasterizationSamples = context.samples;
+		if (context.renderPass == VK_NULL_HANDLE)
+		{
+			inheritanceInfo.pNext = &renderingInfo;
+		}
+
+		// each job records a contiguous range so draw order is kept once the buffers are executed in job order
+		m_jobSystem.Dispatch(jobCount,
+							 [&](uint32_t jobIndex, uint32_t threadIndex)
+							 {
+								 PROFILE_SCOPE("RecordSecondaryCommandBuffer");
+								 size_t firstDraw = jobIndex * drawsPerJob;
+								 size_t jobDrawCount = std::min(drawsPerJob, drawCount - firstDraw);
+
+								 VkCommandBuffer commandBuffer = AcquireCommandBuffer(threadIndex, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
+								 VkCommandBufferBeginInfo beginInfo = {};
+								 beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+								 beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+								 beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+								 if (_vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+								 {
+								 	LOG_ERROR("failed to begin recording secondary command buffer!");
+								 }
+								 RecordDraws(commandBuffer, pipeline, firstDraw, jobDrawCount);
+								 if (_vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+								 {
+								 	LOG_ERROR("failed to record secondary command buffer!");
+								 }
+
+								 m_secondaryCommandBuffers[jobIndex] = commandBuffer;
+							 });
+
+		// the overlay goes last so it stays on top, in a secondary of its own since the pass has no inline contents
+		if (isOverlayRecorded && m_isPerformanceHudEnabled)
 		{
+			VkCommandBuffer commandBuffer = AcquireCommandBuffer(0, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+
 			VkCommandBufferBeginInfo beginInfo = {};
 			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-			beginInfo.pInheritanceInfo = nullptr; // Optional
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+			beginInfo.pInheritanceInfo = &inheritanceInfo;
 
-			vkBeginCommandBuffer(m_commandBuffers[i], &beginInfo);
+			if (_vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+			{
+				LOG_ERROR("failed to begin recording secondary command buffer!");
+			}
+			bool hasOverlay = m_imguiRenderer.RecordDraws(commandBuffer, context);
+			if (_vkEndCommandBuffer(commandBuffer) != VK_SUCCESS)
+			{
+				LOG_ERROR("failed to record secondary command buffer!");
+			}
+			if (hasOverlay)
+			{
+				m_secondaryCommandBuffers.push_back(commandBuffer);
+			}
+		}
+	}
 
-			VkRenderPassBeginInfo renderPassInfo = {};
-			renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-			renderPassInfo.renderPass = m_renderPass;
-			renderPassInfo.framebuffer = m_swapchainFramebuffers[i];
-			renderPassInfo.renderArea.offset = {0, 0};
-			renderPassInfo.renderArea.extent = m_swapchainExtent;
-			VkClearValue clearColor = {0.0f, 0.0f, 0.0f, 1.0f};
-			renderPassInfo.clearValueCount = 1;
-			renderPassInfo.pClearValues = &clearColor;
+	void VulkanRHI::RecordDraws(VkCommandBuffer commandBuffer, VkPipeline pipeline, size_t firstDraw, size_t drawCount)
+	{
+		if (drawCount == 0)
+		{
+			return;
+		}
+
+		// dynamic state is not inherited by secondary command buffers, so every recording sets it
+		VkViewport viewport = {};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = (float)m_swapchainExtent.width;
+		viewport.height = (float)m_swapchainExtent.height;
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+
+		VkRect2D scissor = {};
+		scissor.offset = {0, 0};
+		scissor.extent = m_swapchainExtent;
+
+		_vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+		_vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+		_vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+		// every mesh shares the two buffers, draws differ only in their offsets
+		m_geometryBuffer.Bind(commandBuffer);
 
-			vkCmdBeginRenderPass(m_commandBuffers[i], &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-			vkCmdBindPipeline(m_commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, m_graphicsPipeline);
-			vkCmdDraw(m_commandBuffers[i], 3, 1, 0, 0);
-			vkCmdEndRenderPass(m_commandBuffers[i]);
-			if (vkEndCommandBuffer(m_commandBuffers[i]) != VK_SUCCESS)
+		VkDescriptorSet perDrawSet = m_perDrawDescriptorSets[m_currentFrame];
+		uint32_t boundUniformOffset = UINT32_MAX;
+		for (size_t i = firstDraw; i < firstDraw + drawCount; i++)
+		{
+			const DrawCall &drawCall = m_drawCalls[i];
+			// its uniform data never made it into the upload buffer
+			if (drawCall.uniformOffset == k_invalidUniformOffset)
+			{
+				continue;
+			}
+			const MeshRange *mesh = nullptr;
+			if (drawCall.mesh != k_invalidMeshId)
+			{
+				// not uploaded yet
+				mesh = m_geometryBuffer.GetMesh(drawCall.mesh);
+				if (mesh == nullptr)
+				{
+					continue;
+				}
+			}
+			if (drawCall.uniformOffset != boundUniformOffset)
 			{
-				LOG_ERROR("failed to record command buffer!");
+				_vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 0, 1, &perDrawSet, 1, &drawCall.uniformOffset);
+				boundUniformOffset = drawCall.uniformOffset;
+			}
+			if (mesh != nullptr)
+			{
+				_vkCmdDrawIndexed(commandBuffer, mesh->indexCount, drawCall.instanceCount, mesh->firstIndex, mesh->vertexOffset, drawCall.firstInstance);
+			}
+			else
+			{
+				_vkCmdDraw(commandBuffer, drawCall.vertexCount, drawCall.instanceCount, drawCall.firstVertex, drawCall.firstInstance);
 			}
 		}
 	}
 
-	void VulkanRHI::CreateSemaphores()
+	void VulkanRHI::CreateSyncObjects()
 	{
+		m_imageAvailableSemaphores.resize(m_maxFramesInFlight);
+		m_frameFences.resize(m_isTimelineSemaphoreEnabled ? 0 : m_maxFramesInFlight);
+		m_frameSlotNumbers.assign(m_maxFramesInFlight, 0);
+
 		VkSemaphoreCreateInfo semaphoreInfo = {};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-		if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_imageAvailableSemaphore) != VK_SUCCESS ||
-			vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_renderFinishedSemaphore) != VK_SUCCESS)
+		// signaled so the first wait on every slot returns immediately
+		VkFenceCreateInfo fenceInfo = {};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+		for (uint32_t i = 0; i < m_maxFramesInFlight; i++)
+		{
+			if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_imageAvailableSemaphores[i]) != VK_SUCCESS ||
+				(!m_isTimelineSemaphoreEnabled && vkCreateFence(m_device, &fenceInfo, nullptr, &m_frameFences[i]) != VK_SUCCESS))
+			{
+				LOG_ERROR("failed to create synchronization objects for a frame!");
+			}
+		}
+	}
+
+	void VulkanRHI::CreatePresentSemaphores()
+	{
+		if (m_isHeadless)
 		{
+			return;
+		}
+
+		m_renderFinishedSemaphores.resize(m_swapchainImages.size());
 
-			LOG_ERROR("failed to create semaphores!");
+		VkSemaphoreCreateInfo semaphoreInfo = {};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		for (size_t i = 0; i < m_renderFinishedSemaphores.size(); i++)
+		{
+			if (vkCreateSemaphore(m_device, &semaphoreInfo, nullptr, &m_renderFinishedSemaphores[i]) != VK_SUCCESS)
+			{
+				LOG_ERROR("failed to create semaphores!");
+			}
 		}
 	}
 
-	void VulkanRHI::CleanUpSwapchain()
+	void VulkanRHI::RetireSwapchain()
 	{
-		vkDeviceWaitIdle(m_device);
+		m_renderGraph.ReleaseFramebuffers();
+		std::vector<VkImageView> imageViews = std::move(m_swapchainImageViews);
+		m_swapchainImageViews.clear();
+
+		// image views are only used by rendering, the frame fence covers them
+		DeferDestroy([this, imageViews]()
+					 {
+						 for (VkImageView imageView : imageViews)
+						 {
+							 vkDestroyImageView(m_device, imageView, nullptr);
+						 }
+					 });
+
+		// the swapchain handle stays in m_swapchain as oldSwapchain of the next one
+		m_retiredSwapchains.push_back({m_swapchain, std::move(m_renderFinishedSemaphores)});
+		m_renderFinishedSemaphores.clear();
+	}
+
+	void VulkanRHI::ReleaseRetiredSwapchains()
+	{
+		if (m_retiredSwapchains.empty())
+		{
+			return;
+		}
+
+		// presents are processed in queue order, once the frame that presented from the new swapchain
+		// retires, the old presents have consumed their semaphores too
+		std::vector<RetiredSwapchain> retiredSwapchains = std::move(m_retiredSwapchains);
+		m_retiredSwapchains.clear();
+		DeferDestroy([this, retiredSwapchains]()
+					 { DestroyRetiredSwapchains(retiredSwapchains); });
+	}
 
-		for (size_t i = 0; i < m_swapchainFramebuffers.size(); i++)
+	void VulkanRHI::DestroyRetiredSwapchains(const std::vector<RetiredSwapchain> &retiredSwapchains)
+	{
+		for (const RetiredSwapchain &retiredSwapchain : retiredSwapchains)
 		{
-			vkDestroyFramebuffer(m_device, m_swapchainFramebuffers[i], nullptr);
+			for (VkSemaphore semaphore : retiredSwapchain.presentSemaphores)
+			{
+				vkDestroySemaphore(m_device, semaphore, nullptr);
+			}
+			vkDestroySwapchainKHR(m_device, retiredSwapchain.swapchain, nullptr);
 		}
-		vkFreeCommandBuffers(m_device, m_commandPool, static_cast<uint32_t>(m_commandBuffers.size()), m_commandBuffers.data());
+	}
 
-		vkDestroyPipeline(m_device, m_graphicsPipeline, nullptr);
-		vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
-		vkDestroyRenderPass(m_device, m_renderPass, nullptr);
+	void VulkanRHI::CleanUpSwapchain()
+	{
+		vkDeviceWaitIdle(m_device);
 
 		for (size_t i = 0; i < m_swapchainImageViews.size(); i++)
 		{
 			vkDestroyImageView(m_device, m_swapchainImageViews[i], nullptr);
 		}
+		for (size_t i = 0; i < m_renderFinishedSemaphores.size(); i++)
+		{
+			vkDestroySemaphore(m_device, m_renderFinishedSemaphores[i], nullptr);
+		}
+		DestroyRetiredSwapchains(m_retiredSwapchains);
+		m_retiredSwapchains.clear();
+
+		if (m_isHeadless)
+		{
+			for (size_t i = 0; i < m_swapchainImages.size(); i++)
+			{
+				m_memoryAllocator.DestroyImage(m_swapchainImages[i], m_offscreenImageAllocations[i]);
+			}
+			return;
+		}
 		vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
 	}
 
@@ -776,11 +1899,15 @@ namespace JMEngine
 
 	std::vector<const char *> VulkanRHI::GetRequiredExtensions()
 	{
-		uint32_t glfwExtensionCount = 0;
-		const char **glfwExtensions;
-		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		std::vector<const char *> extensions;
 
-		std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		if (!m_isHeadless)
+		{
+			uint32_t glfwExtensionCount = 0;
+			const char **glfwExtensions;
+			glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+			extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+		}
 
 		if (m_enableValidationLayers)
 		{
@@ -835,8 +1962,8 @@ namespace JMEngine
 		auto queueIndices = FindQueueFamilies(device);
 
 		bool isExtensionsSupported = CheckDeviceExtensionSupport(device);
-		bool isSwapchainAdequate = false;
-		if (isExtensionsSupported)
+		bool isSwapchainAdequate = m_isHeadless;
+		if (isExtensionsSupported && !m_isHeadless)
 		{
 			SwapChainSupportDetails swapchainSupportDetails = QuerySwapChainSupport(device);
 			isSwapchainAdequate =
@@ -867,6 +1994,12 @@ namespace JMEngine
 			if (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)
 			{
 				indices.graphicsFamily = i;
+
+				// nothing is presented, the present queue simply aliases the graphics queue
+				if (m_isHeadless)
+				{
+					indices.presentFamily = i;
+				}
 			}
 
 			if (queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)
@@ -875,10 +2008,13 @@ namespace JMEngine
 			}
 
 			VkBool32 isPresentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice,
-												 i,
-												 m_surface,
-												 &isPresentSupport);
+			if (!m_isHeadless)
+			{
+				vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice,
+													 i,
+													 m_surface,
+													 &isPresentSupport);
+			}
 			if (isPresentSupport)
 			{
 				indices.presentFamily = i;
@@ -890,6 +2026,24 @@ namespace JMEngine
 			}
 			i++;
 		}
+
+		for (uint32_t family = 0; family < queueFamilyCount; family++)
+		{
+			if ((queueFamilies[family].queueFlags & VK_QUEUE_COMPUTE_BIT) && !(queueFamilies[family].queueFlags & VK_QUEUE_GRAPHICS_BIT))
+			{
+				indices.computeFamily = family;
+				break;
+			}
+		}
+		for (uint32_t family = 0; family < queueFamilyCount; family++)
+		{
+			VkQueueFlags flags = queueFamilies[family].queueFlags;
+			if ((flags & VK_QUEUE_TRANSFER_BIT) && !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT)))
+			{
+				indices.transferFamily = family;
+				break;
+			}
+		}
 		return indices;
 	}
 
@@ -976,21 +2130,16 @@ namespace JMEngine
 		}
 	}
 
-	VkShaderModule VulkanRHI::CreateShaderModule(const std::vector<char> &code)
+	bool VulkanRHI::IsDeviceExtensionEnabled(const char *extensionName) const
 	{
-		VkShaderModuleCreateInfo createInfo = {};
-		createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-		createInfo.codeSize = code.size();
-
-		createInfo.pCode = reinterpret_cast<const uint32_t *>(code.data());
-
-		VkShaderModule shaderModule;
-		if (vkCreateShaderModule(m_device, &createInfo, nullptr, &shaderModule) != VK_SUCCESS)
+		for (const char *extension : m_deviceExtensions)
 		{
-			LOG_ERROR("failed to create shader module");
+			if (strcmp(extension, extensionName) == 0)
+			{
+				return true;
+			}
 		}
-
-		return shaderModule;
+		return false;
 	}
 
 	bool VulkanRHI::CheckDeviceExtensionSupport(VkPhysicalDevice physicalDevice)
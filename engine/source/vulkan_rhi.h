@@ -1,10 +1,36 @@
 #pragma once
 
 #include "source/window_system.h"
+#include "source/job_system.h"
+#include "source/performance_hud.h"
+#include "source/rhi/render_graph.h"
+#include "source/rhi/vulkan_async_compute.h"
+#include "source/rhi/vulkan_command_pool.h"
+#include "source/rhi/vulkan_geometry_buffer.h"
+#include "source/rhi/vulkan_gpu_profiler.h"
+#include "source/rhi/vulkan_imgui_renderer.h"
+#include "source/rhi/vulkan_layout_cache.h"
+#include "source/rhi/vulkan_memory_allocator.h"
+#include "source/rhi/vulkan_pipeline_cache.h"
+#include "source/rhi/vulkan_pipeline_library.h"
+#include "source/rhi/vulkan_readback.h"
+#include "source/rhi/vulkan_timeline_semaphore.h"
+#include "source/rhi/shader_library.h"
+#include "source/rhi/shader_hot_reload.h"
+#include "source/rhi/vulkan_upload_allocator.h"
+#include "source/rhi/vulkan_upload_manager.h"
 
+#include <glm/glm.hpp>
+
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
 #include <vector>
 #include <memory>
 #include <optional>
+#include <span>
+#include <unordered_map>
 
 namespace JMEngine
 {
@@ -12,7 +38,10 @@ namespace JMEngine
 	{
 		std::optional<uint32_t> graphicsFamily;
 		std::optional<uint32_t> presentFamily;
+		// a family without graphics when there is one, so dispatches run beside rendering
 		std::optional<uint32_t> computeFamily;
+		// a family with transfer but neither graphics nor compute, usually dedicated copy engines
+		std::optional<uint32_t> transferFamily;
 
 		bool IsComplete() { return graphicsFamily.has_value() && presentFamily.has_value() && computeFamily.has_value(); }
 	};
@@ -24,22 +53,202 @@ namespace JMEngine
 		std::vector<VkPresentModeKHR> presentModes;
 	};
 
+	// the layout of the shared vertex buffer, the main pipeline's vertex input
+	struct Vertex
+	{
+		glm::vec3 position;
+		glm::vec3 color;
+	};
+
+	// PushUniform's result when the frame's upload buffer is full, draws carrying it are skipped
+	constexpr uint32_t k_invalidUniformOffset = UINT32_MAX;
+
+	struct DrawCall
+	{
+		uint32_t vertexCount{0};
+		uint32_t instanceCount{1};
+		uint32_t firstVertex{0};
+		uint32_t firstInstance{0};
+		// dynamic offset of the per draw uniform data, see VulkanRHI::PushUniform
+		uint32_t uniformOffset{0};
+		// draws a mesh from VulkanRHI::CreateMesh indexed, vertexCount and firstVertex are ignored then
+		MeshId mesh{k_invalidMeshId};
+	};
+
+	struct RHIInfo
+	{
+		uint32_t maxFramesInFlight{2};
+		// render into offscreen images without a window, surface or present queue
+		bool isHeadless{false};
+		uint32_t headlessWidth{1024};
+		uint32_t headlessHeight{720};
+		// threads that record commands each frame, including the render thread,
+		// more than one records draws into secondary command buffers on worker threads
+		uint32_t recordingThreadCount{1};
+		// per frame in flight, for uniforms, dynamic vertex data and staging
+		VkDeviceSize uploadBytesPerFrame{4ull << 20};
+		// size of the shared vertex and index buffers every mesh is placed in
+		uint32_t geometryVertexCapacity{1u << 20};
+		uint32_t geometryIndexCapacity{4u << 20};
+		// staging ring of the upload manager, streamed data waits on the cpu while it is full
+		VkDeviceSize stagingBytes{32ull << 20};
+		// descriptor sets of the async compute queue are allocated per dispatch from a pool sized by this
+		uint32_t maxComputeDispatchesPerFrame{256};
+		// on vulkan 1.2 devices every queue signals one timeline semaphore with increasing numbers and the cpu waits
+		// on those instead of fences, falls back to fences and binary semaphores when unsupported
+		bool isTimelineSemaphoreEnabled{true};
+		// where VK_KHR_dynamic_rendering and VK_KHR_synchronization2 are supported, passes render without render pass
+		// and framebuffer objects and barriers and submissions go through the 2 variants, falls back otherwise
+		bool isDynamicRenderingEnabled{true};
+		// compiled pipelines persist here between runs, empty disables the file
+		std::string pipelineCachePath{"pipeline_cache.bin"};
+		// background threads building pipelines on a library miss, 0 builds them inline
+		uint32_t pipelineCompileThreadCount{1};
+		// development only, <dir>/<name>.spv shadows the shaders embedded in the binary
+		std::string shaderOverrideDirectory;
+		// development only, recompiles edited glsl in the background and swaps the affected pipelines,
+		// the modules are written to shaderOverrideDirectory or ./shader_hot_reload, its .spv files are deleted at startup
+		bool isShaderHotReloadEnabled{false};
+		// timestamps around each pass, read back a few frames late without stalling
+		bool isGpuProfilerEnabled{true};
+		// adds vertex and fragment shader invocation counts per pass, when the device supports them
+		bool isPipelineStatisticsEnabled{false};
+		// imgui overlay with frame times, pass timings, memory and upload stats, other imgui
+		// windows may be built between BeginFrame and DrawFrame when it is on
+		bool isPerformanceHudEnabled{false};
+		// the main pass renders into a transient multisampled target resolved into the backbuffer,
+		// lowered to what the device supports
+		VkSampleCountFlagBits msaaSampleCount{VK_SAMPLE_COUNT_1_BIT};
+		// draws depth only first, the main pass then shades just the visible fragments with an equal depth test
+		bool isDepthPrepassEnabled{false};
+	};
+
 	class VulkanRHI final
 	{
 	public:
-		void Initialize(std::shared_ptr<WindowSystem> &windowSystem);
+		// windowSystem may be null when info.isHeadless is set
+		void Initialize(std::shared_ptr<WindowSystem> &windowSystem, const RHIInfo &info = RHIInfo{});
 
 		void Clear();
+		// waits for the frame slot to be free, uploads for a frame may only be written after it,
+		// a no-op when the frame has already begun
+		void BeginFrame();
 		void DrawFrame();
 		void RecreateSwapchain();
+		// queued for the next DrawFrame
+		void SubmitDraw(const DrawCall &drawCall);
+		// the data is copied and uploaded by a later frame, draws of the mesh are skipped until then,
+		// k_invalidMeshId when the geometry buffers are full
+		MeshId CreateMesh(std::span<const Vertex> vertices, std::span<const uint32_t> indices);
+		void DestroyMesh(MeshId mesh);
+		// compiled inline, the layout is reflected from the shader and dispatches bind set 0 and push constants,
+		// invalid when the shader does not load, the pipeline keeps its module across shader hot reloads
+		ComputePipeline CreateComputePipeline(const std::string &shaderName, const std::vector<SpecializationConstant> &specializationConstants = {});
+		// recorded right away for the compute queue and submitted after this frame's graphics work,
+		// see AsyncCompute for how resources move between the queues
+		void DispatchCompute(const ComputeDispatch &dispatch);
+		// runs once the gpu has finished every frame submitted so far
+		void DeferDestroy(std::function<void()> &&destroy);
+
+		// copy the next rendered frame or a buffer range to the cpu, results arrive a few frames later,
+		// a full readback ring drops the request and breaks the promise of the future
+		void CaptureFrame(ReadbackCallback &&callback);
+		std::future<std::vector<char>> CaptureFrame();
+		void ReadbackBuffer(VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size, ReadbackCallback &&callback);
 		static void OnWindowResized(GLFWwindow *window, int width, int height);
 
+		// valid until the current frame slot is reused, threadIndex 0 is the render thread
+		VkCommandBuffer AcquireCommandBuffer(uint32_t threadIndex, VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
+		inline uint32_t GetCurrentFrameIndex() const { return m_currentFrame; }
+		inline uint32_t GetMaxFramesInFlight() const { return m_maxFramesInFlight; }
+		inline VulkanMemoryAllocator &GetMemoryAllocator() { return m_memoryAllocator; }
+		inline PipelineLibrary &GetPipelineLibrary() { return m_pipelineLibrary; }
+		// streams buffers and images on the transfer queue from any thread
+		inline UploadManager &GetUploadManager() { return m_uploadManager; }
+		inline AsyncCompute &GetAsyncCompute() { return m_asyncCompute; }
+		inline bool IsTimelineSemaphoreEnabled() const { return m_isTimelineSemaphoreEnabled; }
+		inline bool IsDynamicRenderingEnabled() const { return m_isDynamicRenderingEnabled; }
+		// switches the permutation of the main pipeline, the current one keeps drawing until the new one is compiled
+		void SetSpecializationConstant(uint32_t constantId, uint32_t value);
+		inline GpuProfiler &GetGpuProfiler() { return m_gpuProfiler; }
+		// timings of the latest frame the gpu has finished, about m_maxFramesInFlight frames old
+		inline const GpuFrameTimings &GetGpuFrameTimings() const { return m_gpuProfiler.GetLatestFrame(); }
+		bool IsDeviceExtensionEnabled(const char *extensionName) const;
+		inline PerformanceHud &GetPerformanceHud() { return m_performanceHud; }
+		inline const RenderGraphStats &GetRenderGraphStats() const { return m_renderGraph.GetStats(); }
+		inline GeometryBufferStats GetGeometryStats() const { return m_geometryBuffer.GetStats(); }
+
+		// slices of the current frame's upload buffer, valid until the frame slot is reused
+		UploadAllocation AllocateUpload(VkDeviceSize size, VkDeviceSize alignment);
+		UploadAllocation AllocateUniform(VkDeviceSize size);
+		// k_invalidUniformOffset when the frame's upload buffer is full
+		template <typename T>
+		uint32_t PushUniform(const T &data)
+		{
+			UploadAllocation allocation = AllocateUniform(sizeof(T));
+			if (!allocation.IsValid())
+			{
+				return k_invalidUniformOffset;
+			}
+			memcpy(allocation.mappedData, &data, sizeof(T));
+			return static_cast<uint32_t>(allocation.offset);
+		}
+
 	private:
 		const std::vector<char const *> m_validationLayers{"VK_LAYER_KHRONOS_validation"};
 		std::vector<char const *> m_deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+		// appended to m_deviceExtensions when the physical device supports them
+		const std::vector<char const *> m_optionalDeviceExtensions{VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME, VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME,
+																	 VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME};
 		bool m_enableValidationLayers{true};
 		bool m_enablePointLightShadow{true};
+		bool m_isHeadless{false};
 		QueueFamilyIndices m_queueIndices;
+		uint32_t m_maxFramesInFlight{2};
+		uint32_t m_recordingThreadCount{1};
+		uint32_t m_currentFrame{0};
+		bool m_framebufferResized{false};
+		bool m_isFrameBegun{false};
+
+		// frames are numbered in submission order, a slot's fence signaling completes its number,
+		// with timeline semaphores the graphics timeline reaches each number instead
+		bool m_isTimelineSemaphoreEnabled{false};
+		TimelineSemaphore m_graphicsTimeline;
+		uint64_t m_frameNumber{0};
+		uint64_t m_completedFrameNumber{0};
+		std::vector<uint64_t> m_frameSlotNumbers;
+
+		struct DeferredDestroy
+		{
+			uint64_t frameNumber;
+			std::function<void()> destroy;
+		};
+		std::deque<DeferredDestroy> m_deferredDestroys;
+
+		struct ReadbackRequest
+		{
+			// null requests the frame's color target
+			VkBuffer buffer;
+			VkDeviceSize offset;
+			VkDeviceSize size;
+			ReadbackCallback callback;
+		};
+		std::vector<ReadbackRequest> m_readbackRequests;
+		ReadbackRing m_readbackRing;
+		GpuProfiler m_gpuProfiler;
+		bool m_isPipelineStatisticsEnabled{false};
+
+		ImGuiRenderer m_imguiRenderer;
+		PerformanceHud m_performanceHud;
+		bool m_isPerformanceHudEnabled{false};
+		HudFrameStats m_hudStats;
+		int64_t m_lastFrameBeginNs{0};
+
+		JobSystem m_jobSystem;
+		std::vector<DrawCall> m_drawCalls;
+		std::vector<VkCommandBuffer> m_secondaryCommandBuffers;
+		// below this many draws per job, spreading the work costs more than it saves
+		static constexpr uint32_t k_minDrawsPerRecordingJob = 256;
 
 		GLFWwindow *m_window{nullptr};
 
@@ -51,19 +260,78 @@ namespace JMEngine
 		VkQueue m_presentQueue{nullptr};
 		VkQueue m_graphicsQueue{nullptr};
 		VkQueue m_computeQueue{nullptr};
+		// the graphics queue when there is no transfer only family
+		VkQueue m_transferQueue{nullptr};
+		VulkanMemoryAllocator m_memoryAllocator;
+		FrameUploadAllocator m_uploadAllocator;
+		UploadManager m_uploadManager;
+		// semaphores of the upload batches the frame being recorded takes ownership of
+		std::vector<VkSemaphore> m_uploadWaitSemaphores;
+		std::vector<uint64_t> m_uploadWaitValues;
+		AsyncCompute m_asyncCompute;
+		// compute results the frame being recorded waits on, and the semaphores it signals for the frame's dispatches
+		std::vector<VkSemaphore> m_computeWaitSemaphores;
+		std::vector<uint64_t> m_computeWaitValues;
+		std::vector<VkPipelineStageFlags> m_computeWaitStages;
+		std::vector<VkSemaphore> m_computeSignalSemaphores;
+		PersistentPipelineCache m_pipelineCache;
+		PipelineLibrary m_pipelineLibrary;
+		PipelineLayoutCache m_layoutCache;
+		RenderGraph m_renderGraph;
+		GeometryBuffer m_geometryBuffer;
+		VkSampleCountFlagBits m_msaaSampleCount{VK_SAMPLE_COUNT_1_BIT};
+		ShaderLibrary m_shaderLibrary;
+		ShaderHotReloader m_shaderHotReloader;
+		bool m_isShaderHotReloadEnabled{false};
+		// the module each shader name currently resolves to
+		std::unordered_map<std::string, ShaderId> m_shaderIds;
+		VkDeviceSize m_uploadBytesPerFrame{0};
 		VkSwapchainKHR m_swapchain{nullptr};
 		std::vector<VkImage> m_swapchainImages;
 		VkFormat m_swapchainImageFormat;
 		VkExtent2D m_swapchainExtent;
+		bool m_isSwapchainReadable{false};
 		std::vector<VkImageView> m_swapchainImageViews;
-		VkRenderPass m_renderPass;
-		VkPipelineLayout m_pipelineLayout;
-		VkPipeline m_graphicsPipeline;
-		std::vector<VkFramebuffer> m_swapchainFramebuffers;
-		VkCommandPool m_commandPool;
-		std::vector<VkCommandBuffer> m_commandBuffers;
-		VkSemaphore m_imageAvailableSemaphore;
-		VkSemaphore m_renderFinishedSemaphore;
+		// headless only, backs the images in m_swapchainImages
+		std::vector<VulkanAllocation> m_offscreenImageAllocations;
+		// also means synchronization2, the two are only used together
+		bool m_isDynamicRenderingEnabled{false};
+		// both null with dynamic rendering, pipelines are built against the attachment formats
+		VkRenderPass m_renderPass{VK_NULL_HANDLE};
+		// reverse-z, cleared to 0 with greater or equal tests, D32 or D24S8 depending on support
+		VkFormat m_depthFormat{VK_FORMAT_UNDEFINED};
+		bool m_isDepthPrepassEnabled{false};
+		VkRenderPass m_depthPrepassRenderPass{VK_NULL_HANDLE};
+		// per draw uniforms, one set per frame bound with a dynamic offset,
+		// layouts are reflected from the shaders and owned by m_layoutCache
+		VkDescriptorSetLayout m_perDrawSetLayout{VK_NULL_HANDLE};
+		VkDescriptorPool m_descriptorPool;
+		std::vector<VkDescriptorSet> m_perDrawDescriptorSets;
+		VkPipelineLayout m_pipelineLayout{VK_NULL_HANDLE};
+		// owned by m_pipelineLibrary, the last compiled permutation, null until the first one is ready
+		GraphicsPipelineDesc m_graphicsPipelineDesc;
+		VkPipeline m_graphicsPipeline{VK_NULL_HANDLE};
+		// the depth only variant of the same permutation, both are switched together
+		GraphicsPipelineDesc m_depthPrepassPipelineDesc;
+		VkPipeline m_depthPrepassPipeline{VK_NULL_HANDLE};
+		bool m_isGraphicsPipelinePending{false};
+
+		// per frame in flight
+		std::vector<std::vector<TransientCommandPool>> m_commandPools; // [frame][thread]
+		std::vector<VkSemaphore> m_imageAvailableSemaphores;
+		// empty with timeline semaphores
+		std::vector<VkFence> m_frameFences;
+
+		// per swapchain image, the present engine may still wait on it after the frame fence signals
+		std::vector<VkSemaphore> m_renderFinishedSemaphores;
+		// no fence covers presentation, so a replaced swapchain and its present semaphores live until
+		// the new swapchain has presented, then wait for that frame like any deferred destroy
+		struct RetiredSwapchain
+		{
+			VkSwapchainKHR swapchain{VK_NULL_HANDLE};
+			std::vector<VkSemaphore> presentSemaphores;
+		};
+		std::vector<RetiredSwapchain> m_retiredSwapchains;
 
 		void CreateInstance();
 		void SetupDebugMessenger();
@@ -71,14 +339,36 @@ namespace JMEngine
 		void PickPhysicalDevice();
 		void CreateLogicalDevice();
 		void CreateSwapChain();
+		void CreateOffscreenTargets();
 		void CreateImageViews();
 		void CreateRenderPass();
+		void CreatePipelineLayout();
+		void CreateDescriptorSets();
 		void CreateGraphicsPipeline();
-		void CreateFramebuffers();
+		void SetMainPassState(GraphicsPipelineDesc &desc) const;
+		GraphicsPipelineDesc GetDepthPrepassDesc(const GraphicsPipelineDesc &desc) const;
+		void RequestGraphicsPipelines();
+		void PrewarmPipelines();
+		void ReloadShaders();
+		// registers both stages and reflects their layout, buffers in dynamicBuffers are bound with dynamic offsets
+		ReflectedPipelineLayout LoadShaderStages(const std::string &vertexName, const std::string &fragmentName, GraphicsPipelineDesc &desc, std::vector<uint32_t> &constantIds,
+												 const std::vector<DescriptorBindingSlot> &dynamicBuffers);
+		void CreateImGuiOverlay();
+		void DestroyImGuiOverlay();
+		void BeginImGuiFrame();
 		void CreateCommandPool();
-		void CreateCommandBuffers();
-		void CreateSemaphores();
+		void CreateSyncObjects();
+		void CreatePresentSemaphores();
 		void CleanUpSwapchain();
+		void RetireSwapchain();
+		void ReleaseRetiredSwapchains();
+		void DestroyRetiredSwapchains(const std::vector<RetiredSwapchain> &retiredSwapchains);
+		void FlushDeferredDestroys(bool isForced);
+		void RecordCommandBuffer(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+		void BuildRenderGraph(uint32_t imageIndex, size_t drawCount);
+		void RecordSecondaryCommandBuffers(const RenderGraphPassContext &context, VkPipeline pipeline, bool isOverlayRecorded);
+		void RecordDraws(VkCommandBuffer commandBuffer, VkPipeline pipeline, size_t firstDraw, size_t drawCount);
+		void RecordReadbacks(VkCommandBuffer commandBuffer, uint32_t imageIndex);
 
 		bool CheckValidationLayerSupport();
 		std::vector<const char *> GetRequiredExtensions();
@@ -92,7 +382,6 @@ namespace JMEngine
 		VkSurfaceFormatKHR ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR> &availableFormats);
 		VkPresentModeKHR ChooseSwapPresentMode(const std::vector<VkPresentModeKHR> availablePresentModes);
 		VkExtent2D ChooseSwapExtent(const VkSurfaceCapabilitiesKHR &capabilities);
-		VkShaderModule CreateShaderModule(const std::vector<char> &code);
 		VkPhysicalDeviceFeatures GetRequiredPhysicalDeviceFeatures();
 
 		// function pointers
@@ -104,13 +393,16 @@ namespace JMEngine
 		PFN_vkCmdBeginRenderPass _vkCmdBeginRenderPass;
 		PFN_vkCmdNextSubpass _vkCmdNextSubpass;
 		PFN_vkCmdEndRenderPass _vkCmdEndRenderPass;
+		PFN_vkQueueSubmit2KHR _vkQueueSubmit2KHR{nullptr};
 		PFN_vkCmdBindPipeline _vkCmdBindPipeline;
 		PFN_vkCmdSetViewport _vkCmdSetViewport;
 		PFN_vkCmdSetScissor _vkCmdSetScissor;
 		PFN_vkCmdBindVertexBuffers _vkCmdBindVertexBuffers;
 		PFN_vkCmdBindIndexBuffer _vkCmdBindIndexBuffer;
 		PFN_vkCmdBindDescriptorSets _vkCmdBindDescriptorSets;
+		PFN_vkCmdDraw _vkCmdDraw;
 		PFN_vkCmdDrawIndexed _vkCmdDrawIndexed;
 		PFN_vkCmdClearAttachments _vkCmdClearAttachments;
+		PFN_vkCmdExecuteCommands _vkCmdExecuteCommands;
 	};
 }
\ No newline at end of file